@@ -63,10 +63,13 @@ class Cascade : public std::iostream {
     Cascade& set_fopen_dirs(const std::string& path);
     Cascade& set_include_dirs(const std::string& path);
     Cascade& set_enable_inlining(bool enable);
+    Cascade& set_num_partitions(size_t n);
     Cascade& set_open_loop_target(size_t n);
     Cascade& set_quartus_server(const std::string& host, size_t port);
     Cascade& set_vivado_server(const std::string& host, size_t port, size_t fpga);
     Cascade& set_profile_interval(size_t n);
+    Cascade& set_passes(const std::string& passes);
+    Cascade& set_enable_pass_report(bool enable);
     Cascade& set_stdin(std::streambuf* sb);
     Cascade& set_stdout(std::streambuf* sb);
     Cascade& set_stderr(std::streambuf* sb);
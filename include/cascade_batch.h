@@ -0,0 +1,120 @@
+// Copyright 2017-2019 VMware, Inc.
+// SPDX-License-Identifier: BSD-2-Clause
+//
+// The BSD-2 license (the License) set forth below applies to all parts of the
+// Cascade project.  You may not use this file except in compliance with the
+// License.
+//
+// BSD-2 License
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this
+// list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+// this list of conditions and the following disclaimer in the documentation
+// and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS AS IS AND
+// ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef INCLUDE_CASCADE_CASCADE_BATCH_H
+#define INCLUDE_CASCADE_CASCADE_BATCH_H
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include "common/thread_pool.h"
+
+namespace cascade {
+
+// This class runs many independent copies (lanes) of the same program inside
+// a single process. Each lane has its own $fopen() search path, its own
+// standard output and error streams, and its own $finish() status. Lanes are
+// multiplexed onto a fixed number of worker threads; a lane that finishes
+// early releases its thread to the next lane that's waiting to run.
+
+class CascadeBatch {
+  public:
+    // Typedefs:
+    typedef size_t Lane;
+
+    // Constructors:
+    //
+    // Only simple construciton is allowed. All other methods of construction
+    // are explicitly forbidden.
+    CascadeBatch();
+    CascadeBatch(const CascadeBatch& rhs) = delete;
+    CascadeBatch(CascadeBatch&& rhs) = delete;
+    CascadeBatch& operator=(const CascadeBatch& rhs) = delete;
+    CascadeBatch& operator=(CascadeBatch&& rhs) = delete;
+    ~CascadeBatch();
+
+    // Configuration Methods:
+    //
+    // These methods should only be called prior to the first invocation of
+    // run.  Inoking any of these methods afterwards is undefined.
+    CascadeBatch& set_march(const std::string& march);
+    CascadeBatch& set_include_dirs(const std::string& path);
+    CascadeBatch& set_enable_inlining(bool enable);
+    CascadeBatch& set_open_loop_target(size_t n);
+    CascadeBatch& set_num_threads(size_t n);
+
+    // Lane Methods:
+    //
+    // Adds a new lane which resolves $fopen() statements against fopen_dirs and
+    // directs its standard output and error to out and err. Streambufs are not
+    // owned by this class and must outlive the call to wait_for_stop().
+    Lane add_lane(const std::string& fopen_dirs, std::streambuf* out, std::streambuf* err = nullptr);
+    // Returns the number of lanes
+    size_t size() const;
+
+    // Concurrency Methods:
+    //
+    // Begins running every lane on the program located at path. Returns
+    // immediately.
+    CascadeBatch& run(const std::string& path);
+    // Blocks until every lane has either finished or failed to compile.
+    CascadeBatch& wait_for_stop();
+
+    // Execution State:
+    //
+    // These methods are undefined until wait_for_stop() has returned.
+    bool is_finished(Lane l) const;
+    bool is_bad(Lane l) const;
+
+  private:
+    struct LaneState {
+      std::string fopen_dirs;
+      std::streambuf* out;
+      std::streambuf* err;
+      bool finished;
+      bool bad;
+    };
+
+    std::string march_;
+    std::string include_dirs_;
+    bool enable_inlining_;
+    size_t open_loop_target_;
+    size_t num_threads_;
+
+    ThreadPool pool_;
+    std::vector<LaneState> lanes_;
+    bool is_running_;
+
+    void run_lane(LaneState* ls, const std::string& path);
+};
+
+} // namespace cascade
+
+#endif
@@ -12,6 +12,7 @@ program_logic pl (
 	.s0_address({addr[3],addr[2],addr[1],addr[0]}),
 	.s0_read(read),
 	.s0_write(write),
+	.s0_burstcount(1'b1),
 	.s0_readdata(data_out),
 	.s0_writedata({data_in[7],data_in[6],data_in[5],data_in[4],data_in[3],data_in[2],data_in[1],data_in[0]}),
 	.s0_waitrequest(waitreq)
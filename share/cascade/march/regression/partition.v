@@ -0,0 +1,11 @@
+`ifndef __SHARE_CASCADE_MARCH_REGRESSION_PARTITION_V
+`define __SHARE_CASCADE_MARCH_REGRESSION_PARTITION_V
+
+`include "share/cascade/stdlib/stdlib.v"
+
+(*__target="sw", __partitions=4*)
+Root root();
+
+Clock clock();
+
+`endif
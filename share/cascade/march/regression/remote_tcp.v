@@ -0,0 +1,11 @@
+`ifndef __SHARE_CASCADE_MARCH_REGRESSION_REMOTE_TCP_V
+`define __SHARE_CASCADE_MARCH_REGRESSION_REMOTE_TCP_V
+
+`include "share/cascade/stdlib/stdlib.v"
+
+(*__loc="127.0.0.1:8800"*)
+Root root();
+
+Clock clock();
+
+`endif
@@ -96,11 +96,6 @@ module test(clk);
 
   reg[7:0] inReg, decReg;
 
-  // Variables to read file input into before copying to in-mem buffer
-  reg[(BUFFER_BYTES << 3) - 1:0] inVal;
-  reg[(BUFFER_BYTES << 3) - 1:0] encVal;
-  reg[(BUFFER_BYTES << 3) - 1:0] decVal;
-
   reg[15:0] inIdx, encIdx, decIdx;
 
   // Buffers to hold file content
@@ -130,10 +125,9 @@ module test(clk);
   (*non_volatile*)
   reg[31:0] dCtr;
 
-  integer inFd = $fopen("data/test/benchmark/adpcm/in.dat", "r");
-  integer encFd = $fopen("data/test/benchmark/adpcm/enc.dat", "r");
-  integer decFd = $fopen("data/test/benchmark/adpcm/dec.dat", "r");
-  integer i,j,k;
+  integer inFd = $fopen("share/cascade/test/benchmark/adpcm/in.dat", "r");
+  integer encFd = $fopen("share/cascade/test/benchmark/adpcm/enc.dat", "r");
+  integer decFd = $fopen("share/cascade/test/benchmark/adpcm/dec.dat", "r");
 
   initial begin
     //$display("Initializing");
@@ -152,18 +146,9 @@ module test(clk);
     dCtr = 0;
     decState = 0;
     
-    for (i=0; i<TOTAL_IN_BYTES/BUFFER_BYTES; i=i+1) begin
-      $fread(inFd, inVal);
-      inBuf[i] = inVal;
-    end
-    for (j=0; j<TOTAL_ENC_BYTES/BUFFER_BYTES; j=j+1) begin
-      $fread(encFd, encVal);
-      encBuf[j] = encVal;
-    end
-    for (k=0; k<TOTAL_DEC_BYTES/BUFFER_BYTES; k=k+1) begin
-      $fread(decFd, decVal);
-      decBuf[k] = decVal;
-    end
+    $fread(inFd, inBuf, 0, TOTAL_IN_BYTES/BUFFER_BYTES);
+    $fread(encFd, encBuf, 0, TOTAL_ENC_BYTES/BUFFER_BYTES);
+    $fread(decFd, decBuf, 0, TOTAL_DEC_BYTES/BUFFER_BYTES);
 
     //$display("Done initializing");
   end
@@ -0,0 +1,33 @@
+module Walk();
+
+  parameter ADDR_SIZE = 10;
+
+  localparam SIZE = 1 << ADDR_SIZE;
+
+  // This is the same storage and port logic as the standard library Memory.
+  // We don't instantiate Memory directly since its initial block reads SIZE
+  // words from a file, and that loop would dominate the running time.
+  reg[31:0] data[SIZE-1:0];
+  reg wen = 1;
+  reg[ADDR_SIZE-1:0] addr = 0;
+  wire[31:0] rdata = data[addr];
+
+  reg[31:0] sum = 0;
+  always @(posedge clock.val) begin
+    addr <= addr + 1;
+    if (wen) begin
+      data[addr] <= addr;
+    end else begin
+      sum <= sum + rdata;
+    end
+    if (addr == SIZE-1) begin
+      if (wen) begin
+        wen <= 0;
+      end else begin
+        $display(sum + rdata);
+        $finish;
+      end
+    end
+  end
+
+endmodule
@@ -0,0 +1,2 @@
+`include "share/cascade/test/benchmark/memory/memory.v"
+Walk#(.ADDR_SIZE(10)) walk();
@@ -0,0 +1,46 @@
+`include "share/cascade/test/benchmark/mips32/mips32.v"
+
+// Four independent cores. The first sorts 1024 times and then finishes the
+// simulation. The others are patched to sort 2048 times so that they're still
+// running when it does.
+reg[31:0] imem[63:0];
+reg[31:0] jmem[63:0];
+
+integer s = $fopen("share/cascade/test/benchmark/mips32/run_bubble_128_1024.hex", "r");
+integer i = 0;
+reg[31:0] val = 0;
+initial begin
+  for (i = 0; i < 63; i = i + 1) begin
+    $fread(s, val);
+    imem[i] <= val;
+    jmem[i] <= (i == 5) ? 32'h216b0800 : val;
+  end
+end 
+
+wire[31:0] addr0;
+wire[31:0] instr0 = imem[addr0];
+Mips32 mips0(
+  .instr(instr0),
+  .raddr(addr0)
+);
+
+wire[31:0] addr1;
+wire[31:0] instr1 = jmem[addr1];
+Mips32 mips1(
+  .instr(instr1),
+  .raddr(addr1)
+);
+
+wire[31:0] addr2;
+wire[31:0] instr2 = jmem[addr2];
+Mips32 mips2(
+  .instr(instr2),
+  .raddr(addr2)
+);
+
+wire[31:0] addr3;
+wire[31:0] instr3 = jmem[addr3];
+Mips32 mips3(
+  .instr(instr3),
+  .raddr(addr3)
+);
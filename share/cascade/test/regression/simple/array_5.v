@@ -0,0 +1,12 @@
+// Arrays with more than 2^16 elements. Most of this one is never written, so
+// its storage should stay mostly unallocated.
+
+reg signed[11:0] r[(1<<17)-1:0];
+
+initial begin
+  r[0] = -1;
+  r[(1<<17)-1][3:0] = 4'h5;
+  r[70000] = 12'h7ff;
+  $write("%d %d %d %d", r[0], r[(1<<17)-1], r[70000], r[12345]);
+  $finish;
+end
@@ -0,0 +1,51 @@
+// This test checks that case statements only take the default item when no
+// other item matches, that the first matching item wins, and that conditions
+// and items are compared at their common width and type.
+
+reg[2:0] i = 0;
+reg[7:0] sparse = 0;
+reg[79:0] wide = 80'h1_0000_0000_0000_0003;
+reg signed[3:0] s = -4'sd1;
+
+initial begin
+  for (i = 0; i < 7; i = i + 1) begin
+    case (i)
+      default: $write("d");
+      3'd0: $write("0");
+      3'd1, 3'd2: $write("1");
+      3'd2: $write("x");
+      3'd4: $write("4");
+      3'd5: $write("5");
+    endcase
+  end
+  $write(" ");
+
+  for (sparse = 0; sparse < 200; sparse = sparse + 50) begin
+    case (sparse)
+      8'd0: $write("a");
+      8'd150: $write("b");
+      8'd50: $write("c");
+    endcase
+  end
+  $write(" ");
+
+  case (wide)
+    80'h3: $write("no");
+    80'h1_0000_0000_0000_0003: $write("wide");
+    default: $write("no");
+  endcase
+  $write(" ");
+
+  case (s)
+    8'sb1111_1111: $write("signed");
+    default: $write("no");
+  endcase
+  $write(" ");
+
+  case (s)
+    8'hff: $write("no");
+    8'h0f: $write("unsigned");
+  endcase
+
+  $finish;
+end
@@ -0,0 +1,34 @@
+// This test checks that sharing repeated subexpressions between continuous
+// assignments preserves the width and operand order of each occurrence.
+
+module cse(x, y, z, o1, o2, o3, o4, o5, o6);
+  input wire[7:0] x, y;
+  input wire[3:0] z;
+  output wire[8:0] o1;
+  output wire[7:0] o2;
+  output wire[8:0] o3;
+  output wire[7:0] o4;
+  output wire[7:0] o5;
+  output wire[7:0] o6;
+
+  // x+y is 9 bits wide here and in o3, but only 8 bits wide in o2 and o5
+  assign o1 = x + y;
+  assign o2 = (y + x) ^ z;
+  assign o3 = (x + y) + z;
+  assign o4 = {2{x[3:0] & z}};
+  assign o5 = {2{z & x[3:0]}} ^ (x + y);
+  assign o6 = (x - y) ^ (y - x);
+endmodule
+
+reg[7:0] x = 205;
+reg[7:0] y = 100;
+reg[3:0] z = 5;
+wire[8:0] o1, o3;
+wire[7:0] o2, o4, o5, o6;
+
+cse c(x, y, z, o1, o2, o3, o4, o5, o6);
+
+always @(posedge clock.val) begin
+  $write("%d,%d,%d,%d,%d,%d", o1, o2, o3, o4, o5, o6);
+  $finish;
+end
@@ -0,0 +1,28 @@
+// This test checks that instantiations with identical parameter bindings
+// elaborate independently of one another, including their generate constructs.
+
+module foo(clk, count, slot);
+  input wire clk;
+  input wire[3:0] count;
+  input wire[3:0] slot;
+  parameter N = 1;
+  genvar i;
+  for (i = 0; i < N; i = i + 1) begin
+    if (i == N-1) begin
+      always @(posedge clk) if (count == slot) $write(N);
+    end
+  end
+endmodule
+
+reg[3:0] COUNT = 0;
+always @(posedge clock.val) begin
+  COUNT <= COUNT + 1;
+end
+
+foo#(2) f0(clock.val, COUNT, 0);
+foo#(2) f1(clock.val, COUNT, 1);
+foo#(3) f2(clock.val, COUNT, 2);
+foo#(.N(2)) f3(clock.val, COUNT, 3);
+foo#(2) f4(clock.val, COUNT, 4);
+
+always @(posedge clock.val) if (COUNT == 5) $finish;
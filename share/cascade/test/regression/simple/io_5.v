@@ -0,0 +1,11 @@
+integer s = $fopen("share/cascade/test/regression/simple/io_1.dat", "r");
+reg[7:0] mem[7:0];
+integer i;
+initial begin
+  for (i = 0; i < 8; i = i + 1) begin
+    mem[i] = 8'hff;
+  end
+  $fread(s, mem, 1, 6);
+  $fwrite(32'h8000_0001, mem, 0, 7);
+  $finish;
+end
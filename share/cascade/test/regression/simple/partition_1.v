@@ -0,0 +1,32 @@
+module Counter(
+  input wire clk,
+  output reg[7:0] count = 0
+);
+  always @(posedge clk) begin
+    count <= count + 1;
+  end
+endmodule
+
+module Reporter(
+  input wire clk,
+  input wire[7:0] x
+);
+  always @(posedge clk) begin
+    if (x == 8) begin
+      $write(x);
+      $finish;
+    end
+  end
+endmodule
+
+wire[7:0] a;
+wire[7:0] b;
+Counter c1(clock.val, a);
+Counter c2(clock.val, b);
+Reporter r(clock.val, b);
+
+always @(posedge clock.val) begin
+  if (a == 4) begin
+    $write(a);
+  end
+end
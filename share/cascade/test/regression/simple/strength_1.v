@@ -0,0 +1,33 @@
+// This test checks that replacing arithmetic on constants with shifts and
+// masks, and narrowing the rhs of assignments, doesn't change any values.
+
+reg[7:0] x = 8'd201;
+reg[69:0] y = 70'h3f_0123_4567_89ab_cdef;
+reg signed[7:0] s = -8'sd7;
+reg signed[3:0] a = -4'sd3;
+reg signed[15:0] b = 16'sd100;
+
+// Powers of two, two-bit constants, and wide operands
+wire[15:0] t1 = x * 4;
+wire[15:0] t2 = x * 10;
+wire[7:0] t3 = x / 8;
+wire[7:0] t4 = x % 16;
+wire[7:0] t5 = x * 8'd3;
+wire[7:0] t6 = y + 70'h1;
+wire[11:0] t7 = (y * 70'd5) - x;
+// Signed division is left alone
+wire[7:0] t8 = s / 2;
+// Signed sums are not narrowed, since slicing would zero-extend a
+wire[7:0] t9 = a + b;
+// The width of a product depends on the width of the constant
+wire c1 = (x * 4) > 255;
+wire c2 = (x * 3) == 603;
+
+reg[7:0] r1;
+reg[15:0] r2;
+always @(posedge clock.val) begin
+  r1 = x * 6;
+  r2 = y[15:0] % 256;
+  $write("%d %d %d %d %d %d %d %d %d %d %d %d %d", t1, t2, t3, t4, t5, t6, t7, t8, t9, c1, c2, r1, r2);
+  $finish;
+end
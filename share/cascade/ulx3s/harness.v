@@ -45,6 +45,7 @@ module Harness #(
     .s0_address(address),
     .s0_read(read),
     .s0_write(write),
+    .s0_burstcount(1'b1),
     .s0_readdata(readdata),
     .s0_writedata(writedata),
     .s0_waitrequest(waitrequest)
@@ -17,8 +17,12 @@ enum Request {
 Vprogram_logic* pl_;
 bool running_;
 Request req_;
+bool read_;
 uint16_t addr_;
 uint32_t val_;
+uint32_t* data_;
+size_t count_;
+size_t beat_;
 
 } // namespace
 
@@ -34,17 +38,22 @@ extern "C" void verilator_start() {
         break;
       case READ:
         pl_->s0_address = addr_;
+        pl_->s0_burstcount = count_;
         pl_->s0_read = 1;
         req_ = WAIT;
         break;
       case WRITE:
         pl_->s0_address = addr_;
-        pl_->s0_writedata = val_;
+        pl_->s0_burstcount = count_;
+        pl_->s0_writedata = data_[beat_];
         pl_->s0_write = 1;
         req_ = WAIT;
         break;
       case WAIT:
         if (!pl_->s0_waitrequest) {
+          if (read_) {
+            data_[beat_] = pl_->s0_readdata;
+          }
           pl_->s0_read = 0;
           pl_->s0_write = 0;
           req_ = DONE_1;
@@ -54,7 +63,9 @@ extern "C" void verilator_start() {
         req_ = DONE_2;
         break;
       case DONE_2:
-        req_ = READY;
+        // Program logic increments the address between beats, so there's no
+        // need to return to the caller until the burst is finished.
+        req_ = (++beat_ < count_) ? (read_ ? READ : WRITE) : READY;
         break;
     }
     pl_->eval();
@@ -69,13 +80,39 @@ extern "C" void verilator_stop() {
 }
 
 extern "C" void verilator_write(uint16_t addr, uint32_t val) {
+  read_ = false;
   addr_ = addr;
   val_ = val;
+  data_ = &val_;
+  count_ = 1;
+  beat_ = 0;
   for (req_ = WRITE; req_ != READY;);
 }
 
 extern "C" uint32_t verilator_read(uint16_t addr) {
+  read_ = true;
   addr_ = addr;
+  data_ = &val_;
+  count_ = 1;
+  beat_ = 0;
+  for (req_ = READ; req_ != READY;);
+  return val_;
+}
+
+extern "C" void verilator_write_burst(uint16_t addr, const uint32_t* data, size_t n) {
+  read_ = false;
+  addr_ = addr;
+  data_ = const_cast<uint32_t*>(data);
+  count_ = n;
+  beat_ = 0;
+  for (req_ = WRITE; req_ != READY;);
+}
+
+extern "C" void verilator_read_burst(uint16_t addr, uint32_t* data, size_t n) {
+  read_ = true;
+  addr_ = addr;
+  data_ = data;
+  count_ = n;
+  beat_ = 0;
   for (req_ = READ; req_ != READY;);
-  return pl_->s0_readdata;
 }
@@ -64,6 +64,15 @@ Cascade::Cascade() : eval_(this), iostream(&sb_), sb_() {
   runtime_.get_compiler()->set("verilator64", new avmm::Verilator64Compiler());
   #endif
 
+  // Toolchain-backed compilers are expensive enough that running more than
+  // a few at once only slows all of them down.
+  runtime_.get_compiler()->set_max_compiles("de10", 1);
+  runtime_.get_compiler()->set_max_compiles("f1", 1);
+  runtime_.get_compiler()->set_max_compiles("verilator32", 2);
+  #if __x86_64__ || __ppc64__
+  runtime_.get_compiler()->set_max_compiles("verilator64", 2);
+  #endif
+
   set_quartus_server("localhost", 9900);
   set_vivado_server("localhost", 9900, 0);
 }
@@ -90,6 +99,12 @@ Cascade& Cascade::set_enable_inlining(bool enable) {
   return *this;
 }
 
+Cascade& Cascade::set_num_partitions(size_t n) {
+  assert(!is_running_);
+  runtime_.set_num_partitions(n);
+  return *this;
+}
+
 Cascade& Cascade::set_open_loop_target(size_t n) {
   assert(!is_running_);
   runtime_.set_open_loop_target(n);
@@ -121,6 +136,18 @@ Cascade& Cascade::set_profile_interval(size_t n) {
   return *this;
 }
 
+Cascade& Cascade::set_passes(const string& passes) {
+  assert(!is_running_);
+  runtime_.set_passes(passes);
+  return *this;
+}
+
+Cascade& Cascade::set_enable_pass_report(bool enable) {
+  assert(!is_running_);
+  runtime_.set_enable_pass_report(enable);
+  return *this;
+}
+
 Cascade& Cascade::set_stdin(streambuf* sb) {
   assert(!is_running_);
   runtime_.rdbuf(0, sb);
@@ -257,17 +284,21 @@ void Cascade::EvalLoop::generic_loop() {
   // just go to sleep and check back again later. When inputs do appear, we
   // parse them all until another eof appears. Running the loop one last time
   // when a stop is requested guarantees we don't miss any inputs due to a race
-  // condition on the check against stop_requested().
+  // condition on the check against stop_requested(). Inputs are flushed before
+  // a stop is requested, so the check has to happen before the final pass
+  // rather than after it.
 
-  for (auto one_more = true; !cascade_->runtime_.is_finished() && !cascade_->bad() && (!stop_requested() || one_more); one_more = !stop_requested()) {
+  for (auto last = false; !cascade_->runtime_.is_finished() && !cascade_->bad() && !last; ) {
+    last = stop_requested();
     const auto res = cascade_->runtime_.eval_all(*cascade_);
+    if (last) fprintf(stderr, "DBG LASTPASS eof=%d err=%d\n", (int)res.first, (int)res.second);
     if (res.first) {
       cascade_->setstate(ios::eofbit);
     }
     if (res.second) {
       cascade_->setstate(ios::badbit);
     }
-    if (!stop_requested()) {
+    if (!last && !stop_requested()) {
       wait_for(100);
     }
   }
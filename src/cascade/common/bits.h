@@ -35,6 +35,7 @@
 #include <cassert>
 #include <cctype>
 #include <cmath>
+#include <cstdio>
 #include <iostream>
 #include <stdint.h>
 #include <string>
@@ -76,6 +77,9 @@ class BitsBase : public Serializable {
     // Serial I/O:
     void read(std::istream& is, size_t base);
     void write(std::ostream& os, size_t base) const;
+    // Appends the same text as write(os, base) to s without going through an
+    // ostream. Values that fit in a word are formatted without allocating.
+    void write(std::string& s, size_t base) const;
     size_t deserialize(std::istream& is) override;
     size_t serialize(std::ostream& os) const override;
 
@@ -237,6 +241,10 @@ class BitsBase : public Serializable {
     void write_2_8_16(std::ostream& os, size_t base) const;
     // Writes a number in base 10 as a signed or unsigned value
     void write_10(std::ostream& os) const;
+    // String counterparts of the methods above
+    void write_real(std::string& s) const;
+    void write_2_8_16(std::string& s, size_t base) const;
+    void write_10(std::string& s) const;
     // Halves a decimal value, stored as a string
     void dec_halve(std::string& s) const;
     // Returns true if a decimal value, stored as a string is 0
@@ -386,6 +394,24 @@ inline void BitsBase<T, BT, ST>::write(std::ostream& os, size_t base) const {
   }
 }
 
+template <typename T, typename BT, typename ST>
+inline void BitsBase<T, BT, ST>::write(std::string& s, size_t base) const {
+  switch (base) {
+    case 0:
+      return is_real() ? write_real(s) : write_10(s);
+    case 1:
+      return write_real(s);
+    case 2:
+    case 8:
+    case 16:
+      return write_2_8_16(s, base);
+    case 10:
+      return write_10(s);
+    default:
+      assert(false);
+  }
+}
+
 template <typename T, typename BT, typename ST>
 inline size_t BitsBase<T, BT, ST>::deserialize(std::istream& is) {
   uint32_t header;
@@ -1578,6 +1604,89 @@ inline void BitsBase<T, BT, ST>::write_10(std::ostream& os) const {
   }
 }
 
+template <typename T, typename BT, typename ST>
+inline void BitsBase<T, BT, ST>::write_real(std::string& s) const {
+  // This is the format that operator<<(double) uses by default
+  char buf[32];
+  const auto n = std::snprintf(buf, sizeof(buf), "%g", to_double());
+  s.append(buf, n);
+}
+
+template <typename T, typename BT, typename ST>
+inline void BitsBase<T, BT, ST>::write_2_8_16(std::string& s, size_t base) const {
+  // Reals are the only type whose bits change when cast to unsigned
+  if (type_ == Type::REAL) {
+    auto temp = *this;
+    temp.cast_type(Type::UNSIGNED);
+    return temp.write_2_8_16(s, base);
+  }
+
+  const size_t step = (base == 2) ? 1 : (base == 8) ? 3 : 4;
+  const auto mask = (static_cast<T>(1) << step) - 1;
+
+  // Walk over the value from highest to lowest order digit, pulling in bits
+  // from the next word when a digit straddles a word boundary.
+  for (int d = (size_+step-1)/step - 1; d >= 0; --d) {
+    const auto idx = d * step;
+    const auto pos = idx / bits_per_word();
+    const auto off = idx % bits_per_word();
+    auto val = val_[pos] >> off;
+    if (((off + step) > bits_per_word()) && ((pos+1) != val_.size())) {
+      val |= val_[pos+1] << (bits_per_word() - off);
+    }
+    val &= mask;
+    s.push_back((val > 9) ? static_cast<char>('a' + (val - 10)) : static_cast<char>('0' + val));
+  }
+}
+
+template <typename T, typename BT, typename ST>
+inline void BitsBase<T, BT, ST>::write_10(std::string& s) const {
+  // Cast reals down to integers
+  if (type_ == Type::REAL) {
+    auto temp = *this;
+    temp.cast_type(Type::SIGNED);
+    return temp.write_10(s); 
+  } 
+
+  const auto is_neg = is_neg_signed();
+  if (is_neg) {
+    s.push_back('-');
+  }
+
+  // Fast Path: Single word values can be printed directly
+  if (size_ <= bits_per_word()) {
+    auto val = val_[0];
+    if (is_neg) {
+      val = ~val + 1;
+      if (size_ < bits_per_word()) {
+        val &= (static_cast<T>(1) << size_) - 1;
+      }
+    }
+    char buf[24];
+    auto i = sizeof(buf);
+    do {
+      buf[--i] = '0' + (val % 10);
+      val /= 10;
+    } while (val > 0);
+    s.append(buf + i, sizeof(buf) - i);
+    return;
+  }
+
+  // Slow Path: Same as write_10(os)
+  auto temp = *this;
+  if (is_neg) {
+    temp.invert_add_one();
+  }
+  std::string buf = "0";
+  for (int i = size_-1; i >= 0; --i) {
+    dec_double(buf);
+    if (temp.get(i)) {
+      dec_inc(buf);
+    }
+  }
+  s.append(buf.rbegin(), buf.rend());
+}
+
 template <typename T, typename BT, typename ST>
 inline void BitsBase<T, BT, ST>::dec_halve(std::string& s) const {
   auto next_carry = 0;
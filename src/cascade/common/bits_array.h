@@ -0,0 +1,405 @@
+// Copyright 2017-2019 VMware, Inc.
+// SPDX-License-Identifier: BSD-2-Clause
+//
+// The BSD-2 license (the License) set forth below applies to all parts of the
+// Cascade project.  You may not use this file except in compliance with the
+// License.
+//
+// BSD-2 License
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this
+// list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+// this list of conditions and the following disclaimer in the documentation
+// and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS AS IS AND
+// ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef CASCADE_SRC_COMMON_BITS_ARRAY_H
+#define CASCADE_SRC_COMMON_BITS_ARRAY_H
+
+#include <algorithm>
+#include <cassert>
+#include <iostream>
+#include <stddef.h>
+#include <stdint.h>
+#include <vector>
+#include "common/bits.h"
+#include "common/serializable.h"
+
+namespace cascade {
+
+// This class is a packed representation of an array of bit strings which
+// share a common width and type. Rather than storing a separate BitsBase for
+// each element, elements are laid out back to back in whole words, with a
+// single header describing all of them. Small arrays are stored in one
+// contiguous buffer. Arrays which are larger than a page are broken into
+// fixed-size pages which aren't allocated until they're first written with a
+// non-zero value, so that very large, sparsely used memories stay cheap.
+
+template <typename T, typename BT, typename ST>
+class BitsArrayBase : public Serializable {
+  public:
+    // Supporting Concepts:
+    typedef BitsBase<T, BT, ST> Element;
+    typedef typename Element::Type Type;
+
+    // Constructors:
+    BitsArrayBase();
+    explicit BitsArrayBase(size_t n, size_t w, Type t);
+    explicit BitsArrayBase(const Element& b);
+
+    // Compiler-Generated Constructors:
+    BitsArrayBase(const BitsArrayBase& rhs) = default;
+    BitsArrayBase(BitsArrayBase&& rhs) = default;
+    BitsArrayBase& operator=(const BitsArrayBase& rhs) = default;
+    BitsArrayBase& operator=(BitsArrayBase&& rhs) = default;
+    ~BitsArrayBase() override = default;
+
+    // Serial I/O:
+    size_t deserialize(std::istream& is) override;
+    size_t serialize(std::ostream& os) const override;
+
+    // Block I/O:
+    //
+    // Reads and writes the nth word of the idx'th element. Writes to a word
+    // which extends past the width of an element are truncated.
+    template <typename B>
+    B read_word(size_t idx, size_t n) const;
+    template <typename B>
+    void write_word(size_t idx, size_t n, B b);
+
+    // Type Introspection:
+    size_t size() const;
+    size_t width() const;
+    Type get_type() const;
+
+    // Resizing:
+    //
+    // Discards the contents of this array and replaces them with n zero-valued
+    // elements of width w and type t.
+    void resize(size_t n, size_t w, Type t);
+
+    // Element Access:
+    //
+    // Copies the value of an element. The latter two methods have the same
+    // semantics as BitsBase::assign(): the size and type of the target are
+    // preserved and the value is cast as necessary.
+    Element get(size_t idx) const;
+    void get(size_t idx, Element& b) const;
+    void get(size_t idx, size_t msb, size_t lsb, Element& b) const;
+
+    // Element Assignment:
+    //
+    // Assigns the value of an element with the same semantics as
+    // BitsBase::assign(). Returns true if the value of the element changed.
+    bool set(size_t idx, const Element& b);
+    bool set(size_t idx, size_t msb, size_t lsb, const Element& b);
+
+  private:
+    // The number of words in a page
+    static constexpr size_t page_words_ = 4096;
+    // The number of elements which are serialized as a unit
+    static constexpr size_t block_size_ = 1024;
+
+    // The number of elements in this array
+    uint32_t size_;
+    // The width and type of every element
+    uint32_t width_;
+    Type type_;
+    // The number of words used to store an element
+    uint32_t words_;
+    // Element idx lives in page idx >> shift_ at slot idx & mask_
+    uint32_t shift_;
+    uint32_t mask_;
+    // Storage. Empty pages have never been written and are all zeros.
+    std::vector<std::vector<T>> pages_;
+    // Staging area for elements which require casting
+    mutable Element scratch_;
+
+    // Returns a pointer to the first word of an element, or nullptr if it
+    // lives in a page which has not been allocated.
+    const T* slot(size_t idx) const;
+    // Returns a pointer to the first word of an element, allocating its page
+    // if necessary.
+    T* alloc_slot(size_t idx);
+    // Copies an element into scratch_
+    void load(size_t idx) const;
+    // Copies scratch_ into an element. Returns true if its value changed.
+    bool store(size_t idx);
+
+    // Returns the number of bits in a word
+    constexpr size_t bits_per_word() const;
+};
+
+#ifdef __LP64__
+using BitsArray = BitsArrayBase<uint64_t, __uint128_t, int64_t>;
+#else
+using BitsArray = BitsArrayBase<uint32_t, uint64_t, int32_t>;
+#endif
+
+template <typename T, typename BT, typename ST>
+inline BitsArrayBase<T, BT, ST>::BitsArrayBase() {
+  resize(0, 1, Type::UNSIGNED);
+}
+
+template <typename T, typename BT, typename ST>
+inline BitsArrayBase<T, BT, ST>::BitsArrayBase(size_t n, size_t w, Type t) {
+  resize(n, w, t);
+}
+
+template <typename T, typename BT, typename ST>
+inline BitsArrayBase<T, BT, ST>::BitsArrayBase(const Element& b) {
+  resize(1, b.size(), b.get_type());
+  set(0, b);
+}
+
+template <typename T, typename BT, typename ST>
+inline size_t BitsArrayBase<T, BT, ST>::deserialize(std::istream& is) {
+  uint32_t n = 0;
+  is.read(reinterpret_cast<char*>(&n), 4);
+  uint32_t header = 0;
+  is.read(reinterpret_cast<char*>(&header), 4);
+  resize(n, header & 0x3fffffffu, static_cast<Type>(header >> 30));
+  size_t res = 8;
+
+  // Elements are stored in blocks. Blocks which are entirely zero are
+  // represented by a single byte.
+  const auto bytes = (width_+7) / 8;
+  for (size_t i = 0; i < size_; i += block_size_) {
+    const auto ie = std::min(i + block_size_, static_cast<size_t>(size_));
+    ++res;
+    if (is.get() == 0) {
+      continue;
+    }
+    for (auto j = i; j < ie; ++j) {
+      auto* s = alloc_slot(j);
+      for (size_t k = 0; k < bytes; ++k) {
+        const uint8_t b = is.get();
+        s[k/sizeof(T)] |= (static_cast<T>(b) << (8*(k%sizeof(T))));
+      }
+      res += bytes;
+    }
+  }
+  return res;
+}
+
+template <typename T, typename BT, typename ST>
+inline size_t BitsArrayBase<T, BT, ST>::serialize(std::ostream& os) const {
+  os.write(const_cast<char*>(reinterpret_cast<const char*>(&size_)), 4);
+  uint32_t header = width_ | (static_cast<uint32_t>(type_) << 30);
+  os.write(reinterpret_cast<char*>(&header), 4);
+  size_t res = 8;
+
+  const auto bytes = (width_+7) / 8;
+  for (size_t i = 0; i < size_; i += block_size_) {
+    const auto ie = std::min(i + block_size_, static_cast<size_t>(size_));
+    auto zero = true;
+    for (auto j = i; zero && (j < ie); ++j) {
+      const auto* s = slot(j);
+      zero = (s == nullptr) || std::all_of(s, s + words_, [](T t) {return t == 0;});
+    }
+    os.put(zero ? 0 : 1);
+    ++res;
+    if (zero) {
+      continue;
+    }
+    for (auto j = i; j < ie; ++j) {
+      const auto* s = slot(j);
+      for (size_t k = 0; k < bytes; ++k) {
+        const uint8_t b = (s == nullptr) ? 0 : (s[k/sizeof(T)] >> (8*(k%sizeof(T)))) & static_cast<T>(0xffu);
+        os.put(b);
+      }
+      res += bytes;
+    }
+  }
+  return res;
+}
+
+template <typename T, typename BT, typename ST>
+template <typename B>
+inline B BitsArrayBase<T, BT, ST>::read_word(size_t idx, size_t n) const {
+  assert(sizeof(B) <= sizeof(T));
+  assert(idx < size_);
+
+  const auto b_per_word = sizeof(T) / sizeof(B);
+  const auto i = n / b_per_word;
+  const auto off = n % b_per_word;
+  assert(i < words_);
+
+  const auto* s = slot(idx);
+  return (s == nullptr) ? 0 : static_cast<B>(s[i] >> (8*sizeof(B)*off));
+}
+
+template <typename T, typename BT, typename ST>
+template <typename B>
+inline void BitsArrayBase<T, BT, ST>::write_word(size_t idx, size_t n, B b) {
+  assert(sizeof(B) <= sizeof(T));
+  assert(idx < size_);
+
+  const auto b_per_word = sizeof(T) / sizeof(B);
+  const auto i = n / b_per_word;
+  const auto off = n % b_per_word;
+  assert(i < words_);
+
+  if ((b == 0) && (slot(idx) == nullptr)) {
+    return;
+  }
+  auto* s = alloc_slot(idx);
+  if (sizeof(B) == sizeof(T)) {
+    s[i] = b;
+  } else {
+    const T bmask = static_cast<B>(-1);
+    s[i] &= ~(bmask << (8*sizeof(B)*off));
+    s[i] |= (static_cast<T>(b) << (8*sizeof(B)*off));
+  }
+  const auto trailing = width_ % bits_per_word();
+  if ((i == words_-1) && (trailing != 0)) {
+    s[i] &= (static_cast<T>(1) << trailing) - 1;
+  }
+}
+
+template <typename T, typename BT, typename ST>
+inline size_t BitsArrayBase<T, BT, ST>::size() const {
+  return size_;
+}
+
+template <typename T, typename BT, typename ST>
+inline size_t BitsArrayBase<T, BT, ST>::width() const {
+  return width_;
+}
+
+template <typename T, typename BT, typename ST>
+inline typename BitsArrayBase<T, BT, ST>::Type BitsArrayBase<T, BT, ST>::get_type() const {
+  return type_;
+}
+
+template <typename T, typename BT, typename ST>
+inline void BitsArrayBase<T, BT, ST>::resize(size_t n, size_t w, Type t) {
+  assert(n <= static_cast<size_t>(0xffffffffu));
+  assert(w > 0);
+
+  size_ = n;
+  width_ = w;
+  type_ = t;
+  words_ = (w + bits_per_word() - 1) / bits_per_word();
+  scratch_ = Element(w, t);
+
+  // Small Case: Everything fits in a single page, which we allocate eagerly
+  if (n * words_ <= page_words_) {
+    for (shift_ = 0; (static_cast<size_t>(1) << shift_) < n; ++shift_);
+    pages_.assign(1, std::vector<T>(n * words_, 0));
+  } 
+  // Large Case: As many elements per page as will fit, allocated lazily
+  else {
+    for (shift_ = 0; (static_cast<size_t>(2) << shift_) * words_ <= page_words_; ++shift_);
+    pages_.assign(((n-1) >> shift_) + 1, std::vector<T>());
+  }
+  mask_ = (static_cast<size_t>(1) << shift_) - 1;
+}
+
+template <typename T, typename BT, typename ST>
+inline typename BitsArrayBase<T, BT, ST>::Element BitsArrayBase<T, BT, ST>::get(size_t idx) const {
+  load(idx);
+  return scratch_;
+}
+
+template <typename T, typename BT, typename ST>
+inline void BitsArrayBase<T, BT, ST>::get(size_t idx, Element& b) const {
+  // Fast Path: No casting is necessary
+  if ((b.size() == width_) && (b.get_type() == type_)) {
+    const auto* s = slot(idx);
+    for (size_t i = 0; i < words_; ++i) {
+      b.template write_word<T>(i, (s == nullptr) ? 0 : s[i]);
+    }
+    return;
+  }
+  load(idx);
+  b.assign(scratch_);
+}
+
+template <typename T, typename BT, typename ST>
+inline void BitsArrayBase<T, BT, ST>::get(size_t idx, size_t msb, size_t lsb, Element& b) const {
+  load(idx);
+  b.assign(scratch_, msb, lsb);
+}
+
+template <typename T, typename BT, typename ST>
+inline bool BitsArrayBase<T, BT, ST>::set(size_t idx, const Element& b) {
+  scratch_.assign(b);
+  return store(idx);
+}
+
+template <typename T, typename BT, typename ST>
+inline bool BitsArrayBase<T, BT, ST>::set(size_t idx, size_t msb, size_t lsb, const Element& b) {
+  load(idx);
+  if (scratch_.eq(msb, lsb, b)) {
+    return false;
+  }
+  scratch_.assign(msb, lsb, b);
+  return store(idx);
+}
+
+template <typename T, typename BT, typename ST>
+inline const T* BitsArrayBase<T, BT, ST>::slot(size_t idx) const {
+  assert(idx < size_);
+  const auto& p = pages_[idx >> shift_];
+  return p.empty() ? nullptr : (p.data() + (idx & mask_) * words_);
+}
+
+template <typename T, typename BT, typename ST>
+inline T* BitsArrayBase<T, BT, ST>::alloc_slot(size_t idx) {
+  assert(idx < size_);
+  auto& p = pages_[idx >> shift_];
+  if (p.empty()) {
+    p.resize((static_cast<size_t>(mask_) + 1) * words_, 0);
+  }
+  return p.data() + (idx & mask_) * words_;
+}
+
+template <typename T, typename BT, typename ST>
+inline void BitsArrayBase<T, BT, ST>::load(size_t idx) const {
+  const auto* s = slot(idx);
+  for (size_t i = 0; i < words_; ++i) {
+    scratch_.template write_word<T>(i, (s == nullptr) ? 0 : s[i]);
+  }
+}
+
+template <typename T, typename BT, typename ST>
+inline bool BitsArrayBase<T, BT, ST>::store(size_t idx) {
+  const auto* s = slot(idx);
+  auto changed = false;
+  for (size_t i = 0; !changed && (i < words_); ++i) {
+    changed = scratch_.template read_word<T>(i) != ((s == nullptr) ? 0 : s[i]);
+  }
+  if (!changed) {
+    return false;
+  }
+  auto* t = alloc_slot(idx);
+  for (size_t i = 0; i < words_; ++i) {
+    t[i] = scratch_.template read_word<T>(i);
+  }
+  return true;
+}
+
+template <typename T, typename BT, typename ST>
+inline constexpr size_t BitsArrayBase<T, BT, ST>::bits_per_word() const {
+  return 8*sizeof(T);
+}
+
+} // namespace cascade
+
+#endif
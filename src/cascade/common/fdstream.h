@@ -31,16 +31,24 @@
 #ifndef CASCADE_SRC_COMMON_FDSTREAM_H
 #define CASCADE_SRC_COMMON_FDSTREAM_H
 
+#include <algorithm>
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
 #include <iostream>
 #include <streambuf>
 #include <sys/socket.h>
+#include <sys/uio.h>
 #include <vector>
 
 namespace cascade {
 
 // This class provides a c++ stream interface to *nix file descriptors. The
 // implementation of this class uses a resizable character buffer in the heap
-// to store character data in between calls to flush.
+// to store character data in between calls to flush. Each flush is sent as a
+// single frame consisting of a length header and a payload. On the receiving
+// end, as many bytes as are available are read at once, so several frames can
+// be picked up by a single system call.
 
 class fdbuf : public std::streambuf {
   public:
@@ -56,10 +64,20 @@ class fdbuf : public std::streambuf {
     ~fdbuf() override = default;
 
   private:
+    // Initial and maximum buffer sizes:
+    static constexpr size_t min_buffer_ = 4096;
+    static constexpr size_t max_buffer_ = 1 << 20;
+
     // File Descriptor
     int fd_;
-    // Get/Input/Read Area
+    // Get/Input/Read Area: Frames are received into this buffer. The bytes
+    // between next_ and end_ have been received but not yet exposed through
+    // the get area, and remaining_ is the number of bytes left in the payload
+    // of the current frame.
     std::vector<char_type> get_;
+    size_t next_;
+    size_t end_;
+    uint32_t remaining_;
     // Put/Output/Write Area
     std::vector<char_type> put_;
 
@@ -86,8 +104,8 @@ class fdbuf : public std::streambuf {
     int_type pbackfail(int_type c = traits_type::eof()) override;
 
     // Send/Recv:
-    int send(const char_type* c, size_t len);
-    int recv(char_type* c, size_t len);
+    int send(struct iovec* iov, int n);
+    int recv();
 };
 
 class ifdstream : public std::istream {
@@ -117,10 +135,13 @@ class fdstream : public std::iostream {
     fdbuf buf_;
 };
 
-inline fdbuf::fdbuf(int fd) : get_(1), put_(1) {
+inline fdbuf::fdbuf(int fd) : get_(min_buffer_), put_(min_buffer_) {
   fd_ = fd;
+  next_ = 0;
+  end_ = 0;
+  remaining_ = 0;
   setg(get_.data(), get_.data(), get_.data());
-  setp(put_.data(), put_.data()+1);
+  setp(put_.data(), put_.data()+put_.size());
 }
 
 inline void fdbuf::imbue(const std::locale& loc) {
@@ -150,12 +171,12 @@ inline fdbuf::pos_type fdbuf::seekpos(pos_type pos, std::ios_base::openmode whic
 }
 
 inline int fdbuf::sync() {
-  const uint32_t n = pptr()-pbase();
+  uint32_t n = pptr()-pbase();
   if (n == 0) {
     return 0;
-  } else if (send((const char*)&n, sizeof(n)) == -1) {
-    return -1;
-  } else if (send((const char*)pbase(), n) == -1) {
+  } 
+  struct iovec iov[2] = {{&n, sizeof(n)}, {pbase(), n}};
+  if (send(iov, 2) == -1) {
     return -1;
   }
 
@@ -164,49 +185,66 @@ inline int fdbuf::sync() {
 }
 
 inline std::streamsize fdbuf::showmanyc() {
-  return egptr() - gptr();
+  const auto n = egptr() - gptr();
+  if (n > 0) {
+    return n;
+  }
+  // Count whatever we've already received for the current frame, or if we're
+  // between frames, the next one.
+  const auto avail = end_ - next_;
+  if (remaining_ > 0) {
+    return std::min<size_t>(remaining_, avail);
+  } 
+  if (avail > sizeof(remaining_)) {
+    uint32_t len = 0;
+    memcpy(&len, get_.data()+next_, sizeof(len));
+    return std::min<size_t>(len, avail-sizeof(len));
+  }
+  return 0;
 }
 
 inline fdbuf::int_type fdbuf::underflow() {
-  uint32_t n = 0;
-  if (recv((char_type*)&n, sizeof(n)) == -1) {
-    return traits_type::eof(); 
-  }
-  if (n > get_.size()) {
-    get_.resize(n);
-  }
-  if (recv((char_type*)get_.data(), n) == -1) {
-    return traits_type::eof();
+  while (true) {
+    // Expose as much of the current frame as we've received
+    if ((remaining_ > 0) && (next_ < end_)) {
+      const auto n = std::min<size_t>(remaining_, end_-next_);
+      setg(get_.data()+next_, get_.data()+next_, get_.data()+next_+n);
+      next_ += n;
+      remaining_ -= n;
+      return traits_type::to_int_type(*gptr());
+    }
+    // Or if we're between frames, start the next one
+    if ((remaining_ == 0) && ((end_-next_) >= sizeof(remaining_))) {
+      memcpy(&remaining_, get_.data()+next_, sizeof(remaining_));
+      next_ += sizeof(remaining_);
+      continue;
+    }
+    // Otherwise, we'll have to wait for more data
+    if (recv() <= 0) {
+      return traits_type::eof(); 
+    }
   }
-  setg(get_.data(), get_.data(), get_.data()+n);
-  return traits_type::to_int_type(get_[0]);
 }
 
 inline fdbuf::int_type fdbuf::uflow() {
-  uint32_t n = 0;
-  if (recv((char_type*)&n, sizeof(n)) == -1) {
-    return traits_type::eof(); 
+  const auto res = underflow();
+  if (res != traits_type::eof()) {
+    gbump(1);
   }
-  if (n > get_.size()) {
-    get_.resize(n);
-  }
-  if (recv((char_type*)get_.data(), n) == -1) {
-    return traits_type::eof();
-  }
-  setg(get_.data(), get_.data()+1, get_.data()+n);
-  return traits_type::to_int_type(get_[0]);
+  return res;
 }
 
 inline std::streamsize fdbuf::xsgetn(char_type* s, std::streamsize count) {
   std::streamsize total = 0;
-  std::streamsize chunk = 0;
-  do {
-    chunk = std::min(egptr()-gptr(), count);
+  while (total < count) {
+    if ((gptr() == egptr()) && (underflow() == traits_type::eof())) {
+      break;
+    }
+    const auto chunk = std::min(egptr()-gptr(), count-total);
     std::copy(gptr(), gptr()+chunk, s+total);
+    gbump(chunk);
     total += chunk;
   } 
-  while ((total < count) && (underflow() != -1));
-  setg(eback(), gptr()+chunk, egptr());
   return total;
 }
 
@@ -214,7 +252,11 @@ inline std::streamsize fdbuf::xsputn(const char_type* s, std::streamsize count)
   const size_t n = pptr()-pbase();
   const size_t req = n+count;
   if (req > put_.size()) {
-    put_.resize(req);
+    auto size = put_.size();
+    while (size < req) {
+      size *= 2;
+    }
+    put_.resize(size);
   }
 
   std::copy(s, s+count, put_.data()+n);
@@ -246,28 +288,55 @@ inline fdbuf::int_type fdbuf::pbackfail(int_type c) {
   return traits_type::to_int_type(c);
 }
 
-inline int fdbuf::send(const char_type* c, size_t len) {
+inline int fdbuf::send(struct iovec* iov, int n) {
   int total = 0;
-  while (total < (int)len) {
-    const auto res = ::send(fd_, c+total, len-total, 0);
+  while (n > 0) {
+    auto res = ::writev(fd_, iov, n);
     if (res == -1) {
+      if (errno == EINTR) {
+        continue;
+      }
       return -1;
     }
     total += res;
+    // Skip past whatever was written. Most of the time, that's everything.
+    for (; (n > 0) && (static_cast<size_t>(res) >= iov->iov_len); --n, ++iov) {
+      res -= iov->iov_len;
+    }
+    if (n > 0) {
+      iov->iov_base = static_cast<char*>(iov->iov_base) + res;
+      iov->iov_len -= res;
+    }
   }
   return total;
 }
 
-inline int fdbuf::recv(char_type* c, size_t len) {
-  int total = 0;
-  while (total < (int)len) {
-    const auto res = ::recv(fd_, c+total, len-total, 0);
-    if (res == -1) {
+inline int fdbuf::recv() {
+  // This method is only invoked when the get area is exhausted, so it's safe
+  // to move any unconsumed bytes to the front of the buffer.
+  if (next_ > 0) {
+    std::copy(get_.data()+next_, get_.data()+end_, get_.data());
+    end_ -= next_;
+    next_ = 0;
+    setg(get_.data(), get_.data(), get_.data());
+  }
+  // Read as much as we have room for. If that fills the buffer, there's
+  // probably more where that came from, so grow it for next time.
+  while (true) {
+    const auto res = ::recv(fd_, get_.data()+end_, get_.size()-end_, 0);
+    if ((res == -1) && (errno == EINTR)) {
+      continue;
+    }
+    if (res <= 0) {
       return -1;
     }
-    total += res;
+    end_ += res;
+    if ((end_ == get_.size()) && (get_.size() < max_buffer_)) {
+      get_.resize(2*get_.size());
+      setg(get_.data(), get_.data(), get_.data());
+    }
+    return res;
   }
-  return total;
 }
 
 inline ifdstream::ifdstream(int fd) : std::istream(&buf_), buf_(fd) { }
@@ -0,0 +1,192 @@
+// Copyright 2017-2019 VMware, Inc.
+// SPDX-License-Identifier: BSD-2-Clause
+//
+// The BSD-2 license (the License) set forth below applies to all parts of the
+// Cascade project.  You may not use this file except in compliance with the
+// License.
+//
+// BSD-2 License
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this
+// list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+// this list of conditions and the following disclaimer in the documentation
+// and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS AS IS AND
+// ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef CASCADE_SRC_COMMON_FORK_JOIN_H
+#define CASCADE_SRC_COMMON_FORK_JOIN_H
+
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace cascade {
+
+// This class represents a fixed group of worker threads for running short,
+// bulk synchronous phases of computation. Unlike a ThreadPool, the calling
+// thread participates in the work and blocks until every index in the phase
+// has completed. Workers spin briefly before going to sleep, since phases are
+// typically issued back to back.
+
+class ForkJoin {
+  public:
+    // Job Typedef:
+    typedef std::function<void(size_t)> Job;
+
+    // Constructors:
+    ForkJoin();
+    ~ForkJoin();
+
+    // Parameter Interface:
+    //
+    // Sets the total number of threads which participate in a phase,
+    // including the caller. Invoking this method while a phase is running is
+    // undefined.
+    ForkJoin& set_num_threads(size_t n);
+    // Returns the total number of threads which participate in a phase.
+    size_t get_num_threads() const;
+
+    // Invokes job(i) for every i in [0,n) and blocks until all of them have
+    // returned. Indices are distributed dynamically across threads.
+    void run(size_t n, const Job& job);
+
+  private:
+    // A single phase of work. Lives on the stack of the thread that invoked
+    // run() and is only visible to workers while it is published.
+    struct Batch {
+      const Job* job;
+      size_t n;
+      std::atomic<size_t> next;
+      std::atomic<size_t> refs;
+    };
+
+    std::mutex lock_;
+    std::condition_variable cv_;
+    std::vector<std::thread> threads_;
+    std::atomic<size_t> gen_;
+    Batch* batch_;
+    bool stop_;
+
+    void start(size_t n);
+    void stop();
+    void work(Batch* b);
+};
+
+inline ForkJoin::ForkJoin() {
+  gen_ = 0;
+  batch_ = nullptr;
+  stop_ = false;
+}
+
+inline ForkJoin::~ForkJoin() {
+  stop();
+}
+
+inline ForkJoin& ForkJoin::set_num_threads(size_t n) {
+  stop();
+  start((n > 0) ? (n-1) : 0);
+  return *this;
+}
+
+inline size_t ForkJoin::get_num_threads() const {
+  return threads_.size() + 1;
+}
+
+inline void ForkJoin::run(size_t n, const Job& job) {
+  // Fast Path: Nothing to distribute
+  if (threads_.empty() || (n < 2)) {
+    for (size_t i = 0; i < n; ++i) {
+      job(i);
+    }
+    return;
+  }
+
+  // Publish this batch, do our share of the work, and then retract it so that
+  // late risers don't join. Wait for the workers who did join to drain out.
+  Batch b;
+  b.job = &job;
+  b.n = n;
+  b.next = 0;
+  b.refs = 0;
+  {
+    std::lock_guard<std::mutex> lg(lock_);
+    batch_ = &b;
+    ++gen_;
+  }
+  cv_.notify_all();
+  work(&b);
+  {
+    std::lock_guard<std::mutex> lg(lock_);
+    batch_ = nullptr;
+  }
+  while (b.refs > 0) {
+    std::this_thread::yield();
+  }
+}
+
+inline void ForkJoin::start(size_t n) {
+  stop_ = false;
+  for (size_t i = 0; i < n; ++i) {
+    threads_.push_back(std::thread([this]{
+      for (size_t seen = gen_; ; ) {
+        // Spin for a short while in case the next phase is imminent
+        for (size_t i = 0; (i < 1024) && (gen_ == seen); ++i) {
+          std::this_thread::yield();
+        }
+        Batch* b = nullptr;
+        {
+          std::unique_lock<std::mutex> ul(lock_);
+          cv_.wait(ul, [this, seen]{return stop_ || ((batch_ != nullptr) && (gen_ != seen));});
+          if (stop_) {
+            return;
+          }
+          seen = gen_;
+          b = batch_;
+          ++b->refs;
+        }
+        work(b);
+        --b->refs;
+      }
+    }));
+  }
+}
+
+inline void ForkJoin::stop() {
+  {
+    std::lock_guard<std::mutex> lg(lock_);
+    stop_ = true;
+  }
+  cv_.notify_all();
+  for (auto& t : threads_) {
+    t.join();
+  }
+  threads_.clear();
+}
+
+inline void ForkJoin::work(Batch* b) {
+  for (size_t i = b->next++; i < b->n; i = b->next++) {
+    (*b->job)(i);
+  }
+}
+
+} // namespace cascade
+
+#endif
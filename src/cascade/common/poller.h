@@ -0,0 +1,210 @@
+// Copyright 2017-2019 VMware, Inc.
+// SPDX-License-Identifier: BSD-2-Clause
+//
+// The BSD-2 license (the License) set forth below applies to all parts of the
+// Cascade project.  You may not use this file except in compliance with the
+// License.
+//
+// BSD-2 License
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this
+// list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+// this list of conditions and the following disclaimer in the documentation
+// and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS AS IS AND
+// ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef CASCADE_SRC_COMMON_POLLER_H
+#define CASCADE_SRC_COMMON_POLLER_H
+
+#include <fcntl.h>
+#include <mutex>
+#include <unistd.h>
+#include <vector>
+#ifdef __linux__
+#include <sys/epoll.h>
+#else
+#include <algorithm>
+#include <poll.h>
+#endif
+
+namespace cascade {
+
+// This class reports file descriptors that are ready to be read. Descriptors
+// are reported one-shot: once a descriptor has been reported, it won't be
+// reported again until it's rearmed. This makes it safe to hand a ready
+// descriptor off to another thread, and have that thread rearm it when it's
+// done. On linux, this class is backed by edge-triggered epoll. Elsewhere, it
+// falls back on poll. All methods are thread-safe.
+
+class poller {
+  public:
+    poller();
+    ~poller();
+
+    // Returns true if an error occurred while creating this poller
+    bool error() const;
+
+    // Starts watching fd, or resumes watching it after it was reported
+    void arm(int fd);
+    // Stops watching fd. This method must be called before fd is closed.
+    void disarm(int fd);
+    // Blocks for up to timeout milliseconds and replaces the contents of
+    // ready with the descriptors which became ready in the meantime.
+    void wait(std::vector<int>& ready, int timeout);
+
+  private:
+#ifdef __linux__
+    int fd_;
+    std::vector<struct epoll_event> events_;
+#else
+    // The write end of this pipe is used to interrupt calls to poll when
+    // the set of armed descriptors changes.
+    int pipe_[2];
+    std::mutex lock_;
+    std::vector<int> armed_;
+    void wake();
+#endif
+};
+
+#ifdef __linux__
+
+inline poller::poller() : events_(64) {
+  fd_ = epoll_create1(EPOLL_CLOEXEC);
+}
+
+inline poller::~poller() {
+  if (fd_ != -1) {
+    ::close(fd_);
+  }
+}
+
+inline bool poller::error() const {
+  return fd_ == -1;
+}
+
+inline void poller::arm(int fd) {
+  struct epoll_event e;
+  e.events = EPOLLIN | EPOLLRDHUP | EPOLLET | EPOLLONESHOT;
+  e.data.fd = fd;
+  // Rearming a descriptor which is already ready generates a new edge, so
+  // there's no window in which data can arrive unnoticed.
+  if (epoll_ctl(fd_, EPOLL_CTL_MOD, fd, &e) == -1) {
+    epoll_ctl(fd_, EPOLL_CTL_ADD, fd, &e);
+  }
+}
+
+inline void poller::disarm(int fd) {
+  epoll_ctl(fd_, EPOLL_CTL_DEL, fd, nullptr);
+}
+
+inline void poller::wait(std::vector<int>& ready, int timeout) {
+  ready.clear();
+  const auto n = epoll_wait(fd_, events_.data(), events_.size(), timeout);
+  for (auto i = 0; i < n; ++i) {
+    ready.push_back(events_[i].data.fd);
+  }
+  // If we filled the event buffer, there may be more where that came from.
+  if (n == static_cast<int>(events_.size())) {
+    events_.resize(2*events_.size());
+  }
+}
+
+#else
+
+inline poller::poller() {
+  if (pipe(pipe_) == 0) {
+    fcntl(pipe_[0], F_SETFL, O_NONBLOCK);
+    fcntl(pipe_[1], F_SETFL, O_NONBLOCK);
+  } else {
+    pipe_[0] = -1;
+    pipe_[1] = -1;
+  }
+}
+
+inline poller::~poller() {
+  if (pipe_[0] != -1) {
+    ::close(pipe_[0]);
+    ::close(pipe_[1]);
+  }
+}
+
+inline bool poller::error() const {
+  return pipe_[0] == -1;
+}
+
+inline void poller::arm(int fd) {
+  {
+    std::lock_guard<std::mutex> lg(lock_);
+    if (std::find(armed_.begin(), armed_.end(), fd) == armed_.end()) {
+      armed_.push_back(fd);
+    }
+  }
+  wake();
+}
+
+inline void poller::disarm(int fd) {
+  {
+    std::lock_guard<std::mutex> lg(lock_);
+    armed_.erase(std::remove(armed_.begin(), armed_.end(), fd), armed_.end());
+  }
+  wake();
+}
+
+inline void poller::wait(std::vector<int>& ready, int timeout) {
+  ready.clear();
+
+  std::vector<struct pollfd> fds;
+  fds.push_back({pipe_[0], POLLIN, 0});
+  {
+    std::lock_guard<std::mutex> lg(lock_);
+    for (auto fd : armed_) {
+      fds.push_back({fd, POLLIN, 0});
+    }
+  }
+  if (poll(fds.data(), fds.size(), timeout) <= 0) {
+    return;
+  }
+
+  if (fds[0].revents != 0) {
+    char buf[64];
+    while (read(pipe_[0], buf, sizeof(buf)) > 0);
+  }
+  std::lock_guard<std::mutex> lg(lock_);
+  for (size_t i = 1, ie = fds.size(); i < ie; ++i) {
+    if (fds[i].revents == 0) {
+      continue;
+    }
+    // Ignore descriptors which were disarmed while we were waiting
+    const auto itr = std::find(armed_.begin(), armed_.end(), fds[i].fd);
+    if (itr != armed_.end()) {
+      ready.push_back(fds[i].fd);
+      armed_.erase(itr);
+    }
+  }
+}
+
+inline void poller::wake() {
+  const char c = 0;
+  (void) write(pipe_[1], &c, 1);
+}
+
+#endif
+
+} // namespace cascade
+
+#endif
@@ -0,0 +1,382 @@
+// Copyright 2017-2019 VMware, Inc.
+// SPDX-License-Identifier: BSD-2-Clause
+//
+// The BSD-2 license (the License) set forth below applies to all parts of the
+// Cascade project.  You may not use this file except in compliance with the
+// License.
+//
+// BSD-2 License
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this
+// list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+// this list of conditions and the following disclaimer in the documentation
+// and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS AS IS AND
+// ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef CASCADE_SRC_COMMON_SHMSTREAM_H
+#define CASCADE_SRC_COMMON_SHMSTREAM_H
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <climits>
+#include <cstdint>
+#include <ctime>
+#include <new>
+#include <streambuf>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+#ifdef __linux__
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#endif
+
+namespace cascade {
+
+// This class provides a c++ stream interface to a pair of single-producer
+// single-consumer ring buffers in a block of shared memory. It's intended as a
+// drop-in replacement for the fdbuf underlying a UNIX Domain socket between
+// two processes on the same host: one process creates a segment and passes
+// its descriptor to the other, and the two then read and write opposite
+// rings. Blocking operations spin briefly before sleeping on a futex. 
+//
+// Because the rings carry a byte stream rather than framed messages, flushing
+// is only a matter of publishing the contents of the put area. The optional
+// socket descriptor passed to the constructor is used to detect when the
+// other process has gone away.
+//
+// Shared memory transport is only supported on linux. On other platforms,
+// error() always returns true.
+
+class shmbuf : public std::streambuf {
+  public:
+    // Typedefs:
+    typedef std::streambuf::char_type char_type;
+    typedef std::streambuf::traits_type traits_type;
+    typedef std::streambuf::int_type int_type;
+    typedef std::streambuf::pos_type pos_type;
+    typedef std::streambuf::off_type off_type;
+
+    // Constructors:
+    //
+    // Creates a new segment. The descriptor for this segment can be shared
+    // with another process using descriptor().
+    explicit shmbuf(int peer = -1);
+    // Maps a segment that was created by another process.
+    shmbuf(int fd, int peer);
+    ~shmbuf() override;
+
+    // Returns true if an error occurred while creating or mapping a segment
+    bool error() const;
+    // Returns the file descriptor underlying this segment
+    int descriptor() const;
+    // Marks this segment as closed. Blocking operations on both ends of the
+    // segment return immediately with an error.
+    void close();
+
+  private:
+    // Ring Layout:
+    static constexpr uint32_t ring_size_ = 1 << 18;
+    struct Ring {
+      alignas(64) std::atomic<uint32_t> head;
+      alignas(64) std::atomic<uint32_t> tail;
+      alignas(64) std::atomic<uint32_t> seq;
+      std::atomic<uint32_t> waiters;
+      alignas(64) char_type data[ring_size_];
+    };
+    struct Segment {
+      alignas(64) std::atomic<uint32_t> closed;
+      Ring rings[2];
+    };
+
+    // Segment State:
+    int fd_;
+    int peer_;
+    Segment* seg_;
+    Ring* in_;
+    Ring* out_;
+
+    // Get/Input/Read Area
+    std::vector<char_type> get_;
+    // Put/Output/Write Area
+    std::vector<char_type> put_;
+
+    // Mapping Helpers:
+    void map(bool create);
+
+    // Locales: 
+    void imbue(const std::locale& loc) override;
+
+    // Positioning:
+    shmbuf* setbuf(char_type* s, std::streamsize n) override;
+    pos_type seekoff(off_type off, std::ios_base::seekdir dir, std::ios_base::openmode which = std::ios_base::in | std::ios_base::out) override;
+    pos_type seekpos(pos_type pos, std::ios_base::openmode which = std::ios_base::in | std::ios_base::out) override;
+    int sync() override;
+
+    // Get Area:
+    std::streamsize showmanyc() override;
+    int_type underflow() override;
+
+    // Put Area:
+    int_type overflow(int_type c = traits_type::eof()) override;
+
+    // Send/Recv:
+    int send(const char_type* c, size_t len);
+    int recv(char_type* c, size_t len);
+
+    // Synchronization Helpers:
+    bool is_closed();
+    template <typename P>
+    bool wait(Ring* r, P pred);
+    void notify(Ring* r);
+};
+
+inline shmbuf::shmbuf(int peer) : get_(4096), put_(4096) {
+  peer_ = peer;
+#ifdef __linux__
+  fd_ = memfd_create("cascade_shm", MFD_CLOEXEC);
+  if ((fd_ != -1) && (ftruncate(fd_, sizeof(Segment)) == -1)) {
+    ::close(fd_);
+    fd_ = -1;
+  }
+#else
+  fd_ = -1;
+#endif
+  map(true);
+}
+
+inline shmbuf::shmbuf(int fd, int peer) : get_(4096), put_(4096) {
+  fd_ = fd;
+  peer_ = peer;
+  map(false);
+}
+
+inline shmbuf::~shmbuf() {
+  if (seg_ != nullptr) {
+    sync();
+    close();
+    munmap(seg_, sizeof(Segment));
+  }
+  if (fd_ != -1) {
+    ::close(fd_);
+  }
+}
+
+inline bool shmbuf::error() const {
+  return seg_ == nullptr;
+}
+
+inline int shmbuf::descriptor() const {
+  return fd_;
+}
+
+inline void shmbuf::close() {
+  if (seg_ == nullptr) {
+    return;
+  }
+  seg_->closed = 1;
+  notify(in_);
+  notify(out_);
+}
+
+inline void shmbuf::map(bool create) {
+  seg_ = nullptr;
+  in_ = nullptr;
+  out_ = nullptr;
+  setg(get_.data(), get_.data(), get_.data());
+  setp(put_.data(), put_.data()+put_.size());
+
+  if (fd_ == -1) {
+    return;
+  }
+  auto* addr = mmap(nullptr, sizeof(Segment), PROT_READ | PROT_WRITE, MAP_SHARED, fd_, 0);
+  if (addr == MAP_FAILED) {
+    return;
+  }
+  // The creator of a segment initializes it, writes to ring 0, and reads from
+  // ring 1. Whoever maps it second does the opposite.
+  seg_ = create ? new (addr) Segment() : static_cast<Segment*>(addr);
+  out_ = &seg_->rings[create ? 0 : 1];
+  in_ = &seg_->rings[create ? 1 : 0];
+}
+
+inline void shmbuf::imbue(const std::locale& loc) {
+  // Does nothing.
+  (void) loc;
+}
+
+inline shmbuf* shmbuf::setbuf(char_type* s, std::streamsize n) {
+  // Does nothing.
+  (void) s;
+  (void) n;
+  return this;
+}
+
+inline shmbuf::pos_type shmbuf::seekoff(off_type off, std::ios_base::seekdir dir, std::ios_base::openmode which) {
+  // Does nothing.
+  (void) off;
+  (void) dir;
+  (void) which;
+  return pos_type(off_type(-1));
+}
+
+inline shmbuf::pos_type shmbuf::seekpos(pos_type pos, std::ios_base::openmode which) {
+  // Does nothing.
+  (void) pos;
+  (void) which;
+  return pos_type(off_type(-1));
+}
+
+inline int shmbuf::sync() {
+  const size_t n = pptr()-pbase();
+  if ((n > 0) && (send(pbase(), n) == -1)) {
+    return -1;
+  }
+  setp(put_.data(), put_.data()+put_.size());
+  return 0;
+}
+
+inline std::streamsize shmbuf::showmanyc() {
+  const auto n = egptr() - gptr();
+  if ((n > 0) || (in_ == nullptr)) {
+    return n;
+  }
+  return in_->tail.load() - in_->head.load();
+}
+
+inline shmbuf::int_type shmbuf::underflow() {
+  const auto n = recv(get_.data(), get_.size());
+  if (n <= 0) {
+    return traits_type::eof();
+  }
+  setg(get_.data(), get_.data(), get_.data()+n);
+  return traits_type::to_int_type(get_[0]);
+}
+
+inline shmbuf::int_type shmbuf::overflow(int_type c) {
+  if (sync() == -1) {
+    return traits_type::eof();
+  }
+  if (c != traits_type::eof()) {
+    *pptr() = c;
+    pbump(1);
+  }
+  return traits_type::not_eof(c);
+}
+
+inline int shmbuf::send(const char_type* c, size_t len) {
+  if (out_ == nullptr) {
+    return -1;
+  }
+  size_t total = 0;
+  while (total < len) {
+    if (!wait(out_, [this]{return (out_->tail.load() - out_->head.load()) < ring_size_;})) {
+      return -1;
+    }
+    const auto tail = out_->tail.load(std::memory_order_relaxed);
+    const auto free = ring_size_ - (tail - out_->head.load(std::memory_order_acquire));
+    const auto idx = tail & (ring_size_-1);
+    const auto chunk = std::min<size_t>({len-total, free, ring_size_-idx});
+    std::copy(c+total, c+total+chunk, out_->data+idx);
+    out_->tail.store(tail+chunk, std::memory_order_release);
+    notify(out_);
+    total += chunk;
+  }
+  return total;
+}
+
+inline int shmbuf::recv(char_type* c, size_t len) {
+  if (in_ == nullptr) {
+    return -1;
+  }
+  if (!wait(in_, [this]{return in_->tail.load() != in_->head.load();})) {
+    return -1;
+  }
+  const auto head = in_->head.load(std::memory_order_relaxed);
+  const auto used = in_->tail.load(std::memory_order_acquire) - head;
+  const auto idx = head & (ring_size_-1);
+  const auto chunk = std::min<size_t>({len, used, ring_size_-idx});
+  std::copy(in_->data+idx, in_->data+idx+chunk, c);
+  in_->head.store(head+chunk, std::memory_order_release);
+  notify(in_);
+  return chunk;
+}
+
+inline bool shmbuf::is_closed() {
+  if (seg_->closed.load()) {
+    return true;
+  }
+  // A zero-length read on the peer socket means that the other side of this
+  // connection exited without closing the segment.
+  if (peer_ != -1) {
+    char c;
+    if (::recv(peer_, &c, 1, MSG_PEEK | MSG_DONTWAIT) == 0) {
+      seg_->closed = 1;
+      return true;
+    }
+  }
+  return false;
+}
+
+template <typename P>
+inline bool shmbuf::wait(Ring* r, P pred) {
+  // Spin for a while. Most round trips complete well within this window. On
+  // a single core machine, spinning only delays the other side.
+  static const size_t spins = (std::thread::hardware_concurrency() > 1) ? 4096 : 0;
+  for (size_t i = 0; i < spins; ++i) {
+    if (pred()) {
+      return true;
+    }
+  }
+  // Then fall back on sleeping until the other side makes progress. The
+  // timeout bounds how long it takes to notice that the other side is gone.
+  while (true) {
+    const auto seq = r->seq.load();
+    if (pred()) {
+      return true;
+    }
+    if (is_closed()) {
+      return false;
+    }
+    ++r->waiters;
+#ifdef __linux__
+    struct timespec timeout = {0, 100000000};
+    syscall(SYS_futex, reinterpret_cast<uint32_t*>(&r->seq), FUTEX_WAIT, seq, &timeout, nullptr, 0);
+#else
+    (void) seq;
+    std::this_thread::yield();
+#endif
+    --r->waiters;
+  }
+}
+
+inline void shmbuf::notify(Ring* r) {
+  ++r->seq;
+  if (r->waiters.load() > 0) {
+#ifdef __linux__
+    syscall(SYS_futex, reinterpret_cast<uint32_t*>(&r->seq), FUTEX_WAKE, INT_MAX, nullptr, nullptr, 0);
+#endif
+  }
+}
+
+} // namespace cascade
+
+#endif
@@ -35,7 +35,9 @@
 #include <cstring>
 #include <fcntl.h>
 #include <netinet/in.h>
+#include <netinet/tcp.h>
 #include <sys/socket.h>
+#include <sys/uio.h>
 #include <sys/un.h>
 #include <unistd.h>
 #include "common/fdstream.h"
@@ -58,11 +60,21 @@ class sockstream : public fdstream {
     bool valid() const;
     // Returns the file descriptor underlying this socket
     int descriptor() const;
+    // Returns true if this is a UNIX Domain socket
+    bool is_unix() const;
+
+    // Passes a file descriptor to the process on the other end of a UNIX
+    // Domain socket. Both methods bypass the stream buffer and should only be
+    // called when there is no outstanding stream traffic in either direction.
+    // Returns false or -1 on error.
+    bool send_descriptor(int fd);
+    int recv_descriptor();
 
   private:
     int raw_fd(int fd);
     int unix_sock(const char* path);
     int inet_sock(const char* host, uint32_t port);
+    void set_options();
     int fd_;
 };
 
@@ -92,8 +104,65 @@ inline int sockstream::descriptor() const {
   return fd_;
 }
 
+inline bool sockstream::is_unix() const {
+  struct sockaddr_storage addr;
+  socklen_t len = sizeof(addr);
+  if (getsockname(fd_, (struct sockaddr*)&addr, &len) != 0) {
+    return false;
+  }
+  return addr.ss_family == AF_UNIX;
+}
+
+inline bool sockstream::send_descriptor(int fd) {
+  char c = 0;
+  struct iovec iov = {&c, 1};
+  char buf[CMSG_SPACE(sizeof(int))];
+  memset(buf, 0, sizeof(buf));
+
+  struct msghdr msg;
+  memset(&msg, 0, sizeof(msg));
+  msg.msg_iov = &iov;
+  msg.msg_iovlen = 1;
+  msg.msg_control = buf;
+  msg.msg_controllen = sizeof(buf);
+
+  auto* cmsg = CMSG_FIRSTHDR(&msg);
+  cmsg->cmsg_level = SOL_SOCKET;
+  cmsg->cmsg_type = SCM_RIGHTS;
+  cmsg->cmsg_len = CMSG_LEN(sizeof(int));
+  memcpy(CMSG_DATA(cmsg), &fd, sizeof(int));
+
+  return ::sendmsg(fd_, &msg, 0) == 1;
+}
+
+inline int sockstream::recv_descriptor() {
+  char c = 0;
+  struct iovec iov = {&c, 1};
+  char buf[CMSG_SPACE(sizeof(int))];
+  memset(buf, 0, sizeof(buf));
+
+  struct msghdr msg;
+  memset(&msg, 0, sizeof(msg));
+  msg.msg_iov = &iov;
+  msg.msg_iovlen = 1;
+  msg.msg_control = buf;
+  msg.msg_controllen = sizeof(buf);
+
+  if (::recvmsg(fd_, &msg, 0) != 1) {
+    return -1;
+  }
+  auto* cmsg = CMSG_FIRSTHDR(&msg);
+  if ((cmsg == nullptr) || (cmsg->cmsg_level != SOL_SOCKET) || (cmsg->cmsg_type != SCM_RIGHTS)) {
+    return -1;
+  }
+  int fd = -1;
+  memcpy(&fd, CMSG_DATA(cmsg), sizeof(int));
+  return fd;
+}
+
 inline int sockstream::raw_fd(int fd) {
   fd_ = fd;
+  set_options();
   return fd_;
 }
 
@@ -123,9 +192,20 @@ inline int sockstream::inet_sock(const char* host, uint32_t port) {
     ::close(fd_);
     fd_ = -1;
   } 
+  set_options();
   return fd_;
 }
 
+inline void sockstream::set_options() {
+  // Traffic on these sockets is almost entirely small request/response pairs,
+  // each of which is sent with a single call to writev(). There's nothing to
+  // be gained by letting Nagle's algorithm hold back partial segments.
+  if ((fd_ != -1) && !is_unix()) {
+    int one = 1;
+    setsockopt(fd_, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+  }
+}
+
 } // namespace cascade
 
 #endif
@@ -35,7 +35,7 @@
 #include <condition_variable>
 #include <functional>
 #include <mutex>
-#include <stack>
+#include <queue>
 #include <thread>
 #include <vector>
 #include "common/thread.h"
@@ -59,7 +59,9 @@ class ThreadPool : public Thread {
     ThreadPool& set_num_threads(size_t n);
 
     // Schedule a new job. Ignores jobs scheduled between stop() and start().
-    void insert(Job job);
+    // Jobs with higher priority are run first. Jobs with the same priority
+    // are run in LIFO order.
+    void insert(Job job, size_t priority = 0);
 
   protected:
     // Start a new pool of num_threads_ threads.
@@ -73,13 +75,27 @@ class ThreadPool : public Thread {
 
     size_t num_threads_;
     std::vector<std::thread> threads_;
-    std::stack<Job> jobs_;
+
+    // Pending jobs are ordered by (priority, sequence number)
+    struct Entry {
+      size_t priority;
+      size_t seq;
+      Job job;
+      bool operator<(const Entry& rhs) const;
+    };
+    std::priority_queue<Entry> jobs_;
+    size_t seq_;
 
     std::pair<bool, Job> get();
 };
 
+inline bool ThreadPool::Entry::operator<(const Entry& rhs) const {
+  return (priority != rhs.priority) ? (priority < rhs.priority) : (seq < rhs.seq);
+}
+
 inline ThreadPool::ThreadPool() : Thread() {
   set_num_threads(1);
+  seq_ = 0;
 }
 
 inline ThreadPool& ThreadPool::set_num_threads(size_t n) {
@@ -87,10 +103,10 @@ inline ThreadPool& ThreadPool::set_num_threads(size_t n) {
   return *this;
 }
 
-inline void ThreadPool::insert(Job job) {
+inline void ThreadPool::insert(Job job, size_t priority) {
   {
     std::lock_guard<std::mutex> lg(lock_);
-    jobs_.push(job);
+    jobs_.push({priority, seq_++, job});
   }
   cv_.notify_one();
 }
@@ -125,7 +141,7 @@ inline std::pair<bool, ThreadPool::Job> ThreadPool::get() {
     cv_.wait(ul);
   }
   if (!jobs_.empty()) {
-    auto res = jobs_.top();
+    auto res = jobs_.top().job;
     jobs_.pop();
     return std::make_pair(true, res);
   }
@@ -0,0 +1,245 @@
+// Copyright 2017-2019 VMware, Inc.
+// SPDX-License-Identifier: BSD-2-Clause
+//
+// The BSD-2 license (the License) set forth below applies to all parts of the
+// Cascade project.  You may not use this file except in compliance with the
+// License.
+//
+// BSD-2 License
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this
+// list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+// this list of conditions and the following disclaimer in the documentation
+// and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS AS IS AND
+// ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef CASCADE_SRC_COMMON_TRACE_H
+#define CASCADE_SRC_COMMON_TRACE_H
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <thread>
+#include <vector>
+
+// Categories which aren't in this mask are compiled out of the binary
+// entirely. By default every category is compiled in and disabled at runtime.
+#ifndef CASCADE_TRACE_CATEGORIES
+#define CASCADE_TRACE_CATEGORIES 0xffffffffu
+#endif
+
+namespace cascade {
+
+// This class records a timeline of runtime events (parsing, jit compilation,
+// state handoffs, scheduler phases) in the Chrome trace-event format. Events
+// are appended without locking to a fixed-size buffer owned by the thread
+// which records them. Names must be string literals: nothing is formatted
+// until the trace is written, and nothing at all is done for categories which
+// are disabled.
+
+class Trace {
+  public:
+    // Categories:
+    enum Category : uint32_t {
+      RUNTIME  = 0x1,
+      COMPILE  = 0x2,
+      HANDOFF  = 0x4,
+      SCHEDULE = 0x8,
+      ALL      = 0xf
+    };
+
+    // Configuration Interface:
+    //
+    // Sets the categories which are recorded at runtime
+    static void enable(uint32_t mask);
+    // Returns true if events in category C are being recorded
+    template <uint32_t C>
+    static bool enabled();
+
+    // Recording Interface:
+    //
+    // Records the beginning or end of a duration, or an instantaneous event,
+    // with an optional integer argument
+    template <uint32_t C>
+    static void begin(const char* name, uint64_t arg = 0);
+    template <uint32_t C>
+    static void end(const char* name, uint64_t arg = 0);
+    template <uint32_t C>
+    static void instant(const char* name, uint64_t arg = 0);
+
+    // Records a duration which spans the lifetime of this object
+    template <uint32_t C>
+    class Scope {
+      public:
+        explicit Scope(const char* name, uint64_t arg = 0);
+        ~Scope();
+      private:
+        const char* name_;
+    };
+
+    // Output Interface:
+    //
+    // Writes every event recorded so far as a Chrome trace-event JSON object.
+    // This method is safe to call while other threads are recording.
+    static void write(std::ostream& os);
+
+  private:
+    struct Event {
+      uint64_t ts;
+      const char* name;
+      uint64_t arg;
+      uint32_t cat;
+      char ph;
+    };
+    struct Buffer {
+      static constexpr size_t capacity_ = 1 << 16;
+      explicit Buffer(size_t tid);
+      size_t tid_;
+      std::atomic<size_t> size_;
+      std::unique_ptr<Event[]> events_;
+    };
+
+    static inline std::atomic<uint32_t> mask_ = 0;
+    static inline std::mutex lock_;
+    static inline std::vector<std::unique_ptr<Buffer>> buffers_;
+    static inline thread_local Buffer* local_ = nullptr;
+
+    static void record(uint32_t cat, char ph, const char* name, uint64_t arg);
+    static Buffer* get_local();
+    static uint64_t now();
+    static const char* cat_name(uint32_t cat);
+};
+
+inline void Trace::enable(uint32_t mask) {
+  mask_.store(mask & CASCADE_TRACE_CATEGORIES, std::memory_order_relaxed);
+}
+
+template <uint32_t C>
+inline bool Trace::enabled() {
+  if constexpr ((C & CASCADE_TRACE_CATEGORIES) == 0) {
+    return false;
+  } else {
+    return (mask_.load(std::memory_order_relaxed) & C) != 0;
+  }
+}
+
+template <uint32_t C>
+inline void Trace::begin(const char* name, uint64_t arg) {
+  if (enabled<C>()) {
+    record(C, 'B', name, arg);
+  }
+}
+
+template <uint32_t C>
+inline void Trace::end(const char* name, uint64_t arg) {
+  if (enabled<C>()) {
+    record(C, 'E', name, arg);
+  }
+}
+
+template <uint32_t C>
+inline void Trace::instant(const char* name, uint64_t arg) {
+  if (enabled<C>()) {
+    record(C, 'i', name, arg);
+  }
+}
+
+template <uint32_t C>
+inline Trace::Scope<C>::Scope(const char* name, uint64_t arg) {
+  name_ = name;
+  begin<C>(name_, arg);
+}
+
+template <uint32_t C>
+inline Trace::Scope<C>::~Scope() {
+  end<C>(name_);
+}
+
+inline void Trace::write(std::ostream& os) {
+  std::lock_guard<std::mutex> lg(lock_);
+
+  os << "{\"traceEvents\":[";
+  auto first = true;
+  for (const auto& b : buffers_) {
+    const auto n = b->size_.load(std::memory_order_acquire);
+    for (size_t i = 0; i < n; ++i) {
+      const auto& e = b->events_[i];
+      os << (first ? "\n" : ",\n");
+      os << "{\"name\":\"" << e.name << "\",\"cat\":\"" << cat_name(e.cat) << "\",\"ph\":\"" << e.ph << "\"";
+      os << ",\"ts\":" << (e.ts / 1000) << "." << ((e.ts / 100) % 10) << ((e.ts / 10) % 10) << (e.ts % 10);
+      os << ",\"pid\":0,\"tid\":" << b->tid_;
+      if (e.ph == 'i') {
+        os << ",\"s\":\"t\"";
+      }
+      os << ",\"args\":{\"arg\":" << e.arg << "}}";
+      first = false;
+    }
+  }
+  os << "\n]}" << std::endl;
+}
+
+inline Trace::Buffer::Buffer(size_t tid) : tid_(tid), size_(0), events_(new Event[capacity_]) { }
+
+inline void Trace::record(uint32_t cat, char ph, const char* name, uint64_t arg) {
+  auto* b = get_local();
+  // Only this thread ever writes to its buffer, so publishing the new size
+  // after filling in the event is enough to make it visible to write(). Events
+  // which don't fit are dropped.
+  const auto n = b->size_.load(std::memory_order_relaxed);
+  if (n == Buffer::capacity_) {
+    return;
+  }
+  b->events_[n] = {now(), name, arg, cat, ph};
+  b->size_.store(n+1, std::memory_order_release);
+}
+
+inline Trace::Buffer* Trace::get_local() {
+  if (local_ == nullptr) {
+    std::lock_guard<std::mutex> lg(lock_);
+    buffers_.emplace_back(new Buffer(buffers_.size()));
+    local_ = buffers_.back().get();
+  }
+  return local_;
+}
+
+inline uint64_t Trace::now() {
+  using namespace std::chrono;
+  return duration_cast<nanoseconds>(steady_clock::now().time_since_epoch()).count();
+}
+
+inline const char* Trace::cat_name(uint32_t cat) {
+  switch (cat) {
+    case RUNTIME: 
+      return "runtime";
+    case COMPILE: 
+      return "compile";
+    case HANDOFF: 
+      return "handoff";
+    case SCHEDULE: 
+      return "schedule";
+    default: 
+      return "unknown";
+  }
+}
+
+} // namespace cascade
+
+#endif
@@ -39,8 +39,9 @@
 namespace cascade {
 
 // This class a space-optimized implementation of std::vector. It assumes no
-// more than 2^16 elements, and won't over-provision when a call to resize
-// exceeds capacity.
+// more than 2^32 elements, and won't over-provision when a call to resize
+// exceeds capacity. Single element inserts grow capacity geometrically, so
+// that building a long vector with push_back is still linear.
 
 template <typename T>
 class Vector {
@@ -98,8 +99,8 @@ class Vector {
 
   private:
     T* ts_;
-    uint16_t size_;
-    uint16_t capacity_;    
+    uint32_t size_;
+    uint32_t capacity_;    
 };
 
 template <typename T>
@@ -164,7 +165,7 @@ inline typename Vector<T>::size_type Vector<T>::size() const {
 
 template <typename T>
 inline void Vector<T>::resize(size_type n, const value_type& v) {
-  assert(n <= static_cast<size_t>(0xffffu));
+  assert(n <= static_cast<size_t>(0xffffffffu));
   if (n <= size_) {
     size_ = n;
   } else {
@@ -184,7 +185,7 @@ inline bool Vector<T>::empty() const {
 
 template <typename T>
 inline void Vector<T>::reserve(size_type n) {
-  assert(n <= static_cast<size_t>(0xffffu));
+  assert(n <= static_cast<size_t>(0xffffffffu));
   if (capacity_ >= n) {
     return;
   }
@@ -271,7 +272,9 @@ inline typename Vector<T>::iterator Vector<T>::insert(iterator itr, const value_
   }
 
   const auto delta = itr - ts_;
-  reserve(size_ + 1);
+  if (size_ == capacity_) {
+    reserve(std::min(std::max(2 * static_cast<size_t>(size_), static_cast<size_t>(1)), static_cast<size_t>(0xffffffffu)));
+  }
   itr = begin() + delta;   
 
   std::copy(itr, end(), itr + 1);
@@ -0,0 +1,105 @@
+// Copyright 2017-2019 VMware, Inc.
+// SPDX-License-Identifier: BSD-2-Clause
+//
+// The BSD-2 license (the License) set forth below applies to all parts of the
+// Cascade project.  You may not use this file except in compliance with the
+// License.
+//
+// BSD-2 License
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this
+// list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+// this list of conditions and the following disclaimer in the documentation
+// and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS AS IS AND
+// ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef CASCADE_SRC_COMMON_WATCHDOG_H
+#define CASCADE_SRC_COMMON_WATCHDOG_H
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include "common/thread.h"
+
+namespace cascade {
+
+// A watchdog is an asynchronous timer which can be armed with a deadline.  If
+// the watchdog is not disarmed before the deadline expires, it invokes a
+// callback from its own thread. The callback should do nothing more than set
+// a flag for the thread being watched to notice.
+
+class Watchdog : public Thread {
+  public:
+    typedef std::function<void()> Callback;
+
+    explicit Watchdog(Callback cb);
+    ~Watchdog() override = default;
+
+    // Arms the watchdog to fire in n milliseconds. Replaces any previous
+    // deadline.
+    void arm(size_t n);
+    // Disarms the watchdog. Returns immediately.
+    void disarm();
+
+  private:
+    // The longest that the watchdog will sleep for before checking for a new
+    // deadline.
+    static constexpr size_t poll_interval_ = 10;
+
+    Callback cb_;
+    std::atomic<uint64_t> deadline_;
+
+    void run_logic() override;
+    static uint64_t now();
+};
+
+inline Watchdog::Watchdog(Callback cb) : Thread(), cb_(cb), deadline_(0) { }
+
+inline void Watchdog::arm(size_t n) {
+  deadline_.store(now() + n, std::memory_order_relaxed);
+  notify();
+}
+
+inline void Watchdog::disarm() {
+  deadline_.store(0, std::memory_order_relaxed);
+}
+
+inline void Watchdog::run_logic() {
+  while (!stop_requested()) {
+    auto d = deadline_.load(std::memory_order_relaxed);
+    const auto n = now();
+    if (d == 0) {
+      wait_for(poll_interval_);
+    } else if (n < d) {
+      wait_for(std::min<uint64_t>(d - n, poll_interval_));
+    } else if (deadline_.compare_exchange_strong(d, 0)) {
+      cb_();
+    }
+  }
+}
+
+inline uint64_t Watchdog::now() {
+  using namespace std::chrono;
+  return duration_cast<milliseconds>(steady_clock::now().time_since_epoch()).count();
+}
+
+} // namespace cascade
+
+#endif
@@ -39,6 +39,10 @@ using namespace std;
 
 namespace cascade {
 
+DataPlane::DataPlane() {
+  deferred_ = false;
+}
+
 void DataPlane::register_id(const VId id) {
   if (id >= readers_.size()) {
     readers_.resize(id+1);
@@ -122,9 +126,7 @@ void DataPlane::write(VId id, const Bits* bits) {
     return;
   } 
   write_buf_[id] = *bits;
-  for (auto* e : readers_[id]) {
-    e->read(id, &write_buf_[id]);
-  } 
+  notify(id);
 }
 
 void DataPlane::write(VId id, bool b) {
@@ -135,6 +137,30 @@ void DataPlane::write(VId id, bool b) {
     return;
   } 
   write_buf_[id].flip(0);
+  notify(id);
+}
+
+void DataPlane::set_deferred(bool d) {
+  deferred_ = d;
+  if (deferred_) {
+    return;
+  }
+  // Deliver writes in the order they were made. Repeated writes to the same
+  // variable are harmless; readers only ever see its final value.
+  for (auto id : defer_buf_) {
+    for (auto* e : readers_[id]) {
+      e->read(id, &write_buf_[id]);
+    }
+  }
+  defer_buf_.clear();
+}
+
+void DataPlane::notify(VId id) {
+  if (deferred_) {
+    lock_guard<mutex> lg(defer_lock_);
+    defer_buf_.push_back(id);
+    return;
+  }
   for (auto* e : readers_[id]) {
     e->read(id, &write_buf_[id]);
   } 
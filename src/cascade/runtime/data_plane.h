@@ -31,6 +31,7 @@
 #ifndef CASCADE_SRC_RUNTIME_DATA_PLANE_H
 #define CASCADE_SRC_RUNTIME_DATA_PLANE_H
 
+#include <mutex>
 #include <vector>
 #include "common/bits.h"
 #include "runtime/ids.h"
@@ -46,6 +47,9 @@ class Engine;
 
 class DataPlane {
   public:
+    // Constructors:
+    DataPlane();
+
     // Iterators:
     typedef std::vector<Engine*>::const_iterator reader_iterator;
     typedef std::vector<Engine*>::const_iterator writer_iterator;
@@ -71,12 +75,26 @@ class DataPlane {
     void write(VId id, const Bits* bits);
     void write(VId id, bool b);
 
+    // Deferred Communication Interface:
+    //
+    // While deferral is enabled, writes update the write buffer but readers
+    // aren't notified. This makes it safe for engines with disjoint write
+    // sets to evaluate concurrently. Disabling deferral delivers every
+    // deferred write to its readers.
+    void set_deferred(bool d);
+
   private:
     // Registries:
     std::vector<std::vector<Engine*>> readers_;
     std::vector<std::vector<Engine*>> writers_;
     // Buffers:
     std::vector<Bits> write_buf_;
+    // Deferral State:
+    bool deferred_;
+    std::mutex defer_lock_;
+    std::vector<VId> defer_buf_;
+
+    void notify(VId id);
 };
 
 } // namespace cascade
@@ -269,6 +269,16 @@ ModuleDeclaration* Isolate::get_shell() {
             static_cast<const LocalparamDeclaration*>(decl)->clone_val() :
             static_cast<const ParameterDeclaration*>(decl)->clone_val()
         ));
+      } else if (info.is_local(p.second)) {
+        // A parameter of our own which some other module reads still needs a
+        // declaration here; references to it have been given its global id.
+        res->push_back_items(new LocalparamDeclaration(
+          new Attributes(),
+          to_global_id(p.second),
+          decl->get_type(),
+          decl->clone_dim(),
+          new Number(Evaluate().get_value(r), Number::Format::HEX)
+        ));
       }
       continue;
     }
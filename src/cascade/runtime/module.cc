@@ -32,10 +32,12 @@
 
 #include <cassert>
 #include <iostream>
+#include <limits>
 #include <mutex>
 #include <sstream>
 #include <unordered_map>
 #include <unordered_set>
+#include "common/trace.h"
 #include "runtime/data_plane.h"
 #include "runtime/isolate.h"
 #include "runtime/runtime.h"
@@ -48,16 +50,9 @@
 #include "verilog/print/print.h"
 #include "verilog/program/elaborate.h"
 #include "verilog/program/inline.h"
-#include "verilog/transform/assign_unpack.h"
-#include "verilog/transform/block_flatten.h"
-#include "verilog/transform/constant_prop.h"
-#include "verilog/transform/control_merge.h"
-#include "verilog/transform/de_alias.h"
+#include "verilog/program/partition.h"
 #include "verilog/transform/delete_initial.h"
-#include "verilog/transform/dead_code_eliminate.h"
-#include "verilog/transform/event_expand.h"
-#include "verilog/transform/index_normalize.h"
-#include "verilog/transform/loop_unroll.h"
+#include "verilog/transform/pass_manager.h"
 
 using namespace std;
 
@@ -122,6 +117,8 @@ Module::Module(const ModuleDeclaration* psrc, Runtime* rt, Module* parent) {
 
   engine_ = rt_->get_compiler()->compile_stub(rt_->get_next_id(), psrc);
   version_ = 0;
+  jit_version_ = 0;
+  jit_hash_ = 0;
 }
 
 Module::~Module() {
@@ -151,6 +148,10 @@ size_t Module::size() const {
   return res;
 }
 
+bool Module::is_partition() const {
+  return Partition().is_partition(psrc_);
+}
+
 void Module::synchronize(size_t n) {
   // Examine new code and instantiate new modules below the root 
   Instantiator inst(this);
@@ -316,15 +317,15 @@ ModuleDeclaration* Module::regenerate_ir_source(size_t ignore) {
   const auto is_logic = (std != nullptr) && (std->get_readable_val() == "logic");
   if (is_logic) {
     ModuleInfo(md).invalidate();
-    AssignUnpack().run(md);
-    IndexNormalize().run(md);
-    LoopUnroll().run(md);
-    DeAlias().run(md);
-    ConstantProp().run(md);
-    EventExpand().run(md);
-    ControlMerge().run(md);
-    DeadCodeEliminate().run(md);
-    BlockFlatten().run(md);
+    auto* pm = rt_->get_pass_manager();
+    if (pm->get_enable_report()) {
+      const auto* iid = static_cast<const ModuleInstantiation*>(psrc_->get_parent())->get_iid();
+      ostream os(rt_->rdbuf(Runtime::stdinfo_));
+      os << "Transforming " << Resolve().get_readable_full_id(iid) << endl;
+      md = pm->run(md, &os);
+    } else {
+      md = pm->run(md);
+    }
   }
   return md;
 }
@@ -386,7 +387,10 @@ void Module::compile_and_replace(ModuleDeclaration* md, size_t version, const st
   stringstream ss;
   ss << "pass " << pass << " compilation of " << id << " with attributes " << md->get_attrs();
   const auto info = ss.str();
+  Trace::begin<Trace::COMPILE>("compile", pass);
   auto* e = rt_->get_compiler()->compile(engine_->get_id(), md);
+  Trace::end<Trace::COMPILE>("compile", pass);
+  const auto more = jit && (e != nullptr) && !e->is_stub();
 
   // Special handling for pass 1 compilation, which isn't run asynchronously
   // and has strict reqiurements on successful completion.
@@ -394,6 +398,7 @@ void Module::compile_and_replace(ModuleDeclaration* md, size_t version, const st
     if (e == nullptr) {
       rt_->get_compiler()->fatal("Unable to complete pass 1 compilation!");
     } else {
+      Trace::Scope<Trace::HANDOFF> ts("replace", pass);
       engine_->replace_with(e);
       if (engine_->is_stub()) {
         ostream(rt_->rdbuf(Runtime::stdinfo_)) << "Deferring " << info << endl;
@@ -405,11 +410,40 @@ void Module::compile_and_replace(ModuleDeclaration* md, size_t version, const st
   }
   // Pass n compilation takes place asynchronously
   else {
-    rt_->schedule_interrupt([this, version, e, info]{
-      if ((version < version_) || (e == nullptr)) {
+    // If the current engine can track changes to its state, we can move the
+    // bulk of its state into the new engine from this thread. We take a
+    // snapshot from inside an interrupt so the engine is quiescent, and only
+    // transfer the elements which changed in the meantime at handoff.
+    auto migrated = false;
+    if (e != nullptr) {
+      State* s = nullptr;
+      rt_->schedule_blocking_interrupt([this, version, &s]{
+        if ((version == jit_version_) && engine_->overrides_state_tracking()) {
+          Trace::Scope<Trace::HANDOFF> ts("begin_migration");
+          s = engine_->begin_migration();
+        }
+      },
+      [] {
+        // Does nothing. If the runtime is shutting down, the final interrupt
+        // below will clean up after us.
+      });
+      if (s != nullptr) {
+        Trace::Scope<Trace::HANDOFF> ts("migrate");
+        e->set_state(s);
+        delete s;
+        migrated = true;
+      }
+    }
+    rt_->schedule_interrupt([this, version, e, info, migrated, more, pass]{
+      if ((version == jit_version_) && !more) {
+        jit_hash_ = 0;
+      }
+      if ((version != jit_version_) || (e == nullptr)) {
+        Trace::instant<Trace::COMPILE>("aborted", pass);
         ostream(rt_->rdbuf(Runtime::stdinfo_)) << "Aborted " << info << endl;
       } else {
-        engine_->replace_with(e);
+        Trace::Scope<Trace::HANDOFF> ts("replace", pass);
+        engine_->replace_with(e, migrated);
         ostream(rt_->rdbuf(Runtime::stdinfo_)) << "Finished " << info << endl;
       }
       rt_->reset_open_loop_itrs();
@@ -422,14 +456,40 @@ void Module::compile_and_replace(ModuleDeclaration* md, size_t version, const st
     });
   }
 
-  // Run jit compilation asynchronously
-  if (jit && !engine_->is_stub() && (e != nullptr)) {
-    rt_->schedule_asynchronous(Runtime::Asynchronous([this, md2, version, id, pass, info]{
-      compile_and_replace(md2, version, id, pass+1);
-    }));
-  } else {
+  // Nothing left to do if this was the last pass
+  if (!more) {
+    if (pass == 1) {
+      jit_version_ = version;
+      jit_hash_ = 0;
+    }
     delete md2;
+    return;
   }
+  // If a previous version of this module is still being jit compiled from
+  // identical source, there's no reason to start over. Adopt those results.
+  if (pass == 1) {
+    stringstream ts;
+    ts << md2;
+    const auto hash = std::hash<string>()(ts.str());
+    if ((jit_hash_ != 0) && (jit_hash_ == hash)) {
+      ostream(rt_->rdbuf(Runtime::stdinfo_)) << "Reusing in-flight pass 2 compilation of " << id << endl;
+      delete md2;
+      return;
+    }
+    jit_version_ = version;
+    jit_hash_ = hash;
+  }
+  // Run jit compilation asynchronously. Earlier passes take priority over
+  // later ones, and jobs for out of date versions are dropped before they
+  // start rather than after they finish.
+  const auto priority = numeric_limits<size_t>::max() - pass;
+  rt_->schedule_asynchronous(Runtime::Asynchronous([this, md2, version, id, pass]{
+    if (version != jit_version_) {
+      delete md2;
+      return;
+    }
+    compile_and_replace(md2, version, id, pass+1);
+  }), priority);
 }
 
 } // namespace cascade
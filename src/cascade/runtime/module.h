@@ -31,6 +31,7 @@
 #ifndef CASCADE_SRC_RUNTIME_MODULE_H
 #define CASCADE_SRC_RUNTIME_MODULE_H
 
+#include <atomic>
 #include <forward_list>
 #include <iosfwd>
 #include <stddef.h>
@@ -71,6 +72,8 @@ class Module {
     Engine* engine();
     // Returns the number of modules in this hierarchy:
     size_t size() const;
+    // Returns true if this module was outlined by the partitioner:
+    bool is_partition() const;
 
     // Synchronizes the module hierarchy with changes which have been made to
     // the ast since the previous invocation of synchronize. n is the number of
@@ -110,6 +113,15 @@ class Module {
     Engine* engine_;
     size_t version_;
 
+    // Jit State:
+    //
+    // The version of this module whose jit compilations are still wanted, and
+    // a hash of the source for the first of those compilations (zero if none
+    // are outstanding). Newer versions with identical source adopt the
+    // compilations started on behalf of older ones rather than restarting them.
+    std::atomic<size_t> jit_version_;
+    size_t jit_hash_;
+
     // Helper Methods:
     ModuleDeclaration* regenerate_ir_source(size_t ignore);
     void compile_and_replace(size_t ignore);
@@ -30,15 +30,20 @@
 
 #include "runtime/runtime.h"
 
+#include <algorithm>
+#include <atomic>
 #include <cassert>
 #include <cctype>
 #include <fstream>
 #include <iostream>
 #include <limits>
 #include <sstream>
+#include <thread>
+#include <tuple>
 #include "common/incstream.h"
 #include "common/indstream.h"
 #include "common/system.h"
+#include "common/trace.h"
 #include "runtime/data_plane.h"
 #include "runtime/isolate.h"
 #include "runtime/module.h"
@@ -54,19 +59,22 @@
 #include "verilog/print/print.h"
 #include "verilog/program/inline.h"
 #include "verilog/program/program.h"
+#include "verilog/transform/pass_manager.h"
 
 using namespace std;
 
 namespace cascade {
 
-Runtime::Runtime() : Thread() {
+Runtime::Runtime() : Thread(), watchdog_([this]{int_pending_ = true;}) {
   include_dirs_ = System::src_root();
   fopen_dirs_ = "./";
   disable_inlining_ = false;
+  num_partitions_ = 1;
   enable_open_loop_ = false;
   open_loop_itrs_ = 2;
   open_loop_target_ = 1;
   profile_interval_ = 0;
+  enable_log_ = false;
 
   pool_.set_num_threads(4);
   pool_.run();
@@ -77,6 +85,7 @@ Runtime::Runtime() : Thread() {
   compiler_ = new LocalCompiler(this);
   dp_ = new DataPlane();
   isolate_ = new Isolate();
+  pm_ = new PassManager();
 
   program_ = new Program();
   root_ = nullptr;
@@ -84,6 +93,7 @@ Runtime::Runtime() : Thread() {
 
   finished_ = false;
   item_evals_ = 0;
+  int_pending_ = false;
 
   schedule_all_ = false;
   yield_ = true;
@@ -146,6 +156,7 @@ Runtime::~Runtime() {
   delete compiler_;
   delete dp_;
   delete isolate_;
+  delete pm_;
 
   for (auto& s : streambufs_) {
     if (s.second) {
@@ -175,12 +186,27 @@ Runtime& Runtime::set_disable_inlining(bool di) {
   return *this;
 }
 
+Runtime& Runtime::set_num_partitions(size_t n) {
+  num_partitions_ = n;
+  return *this;
+}
+
 Runtime& Runtime::set_profile_interval(size_t n) {
   profile_interval_ = n;
   last_check_ = ::time(nullptr);
   return *this;
 }
 
+Runtime& Runtime::set_passes(const string& s) {
+  pm_->set_passes(s);
+  return *this;
+}
+
+Runtime& Runtime::set_enable_pass_report(bool epr) {
+  pm_->set_enable_report(epr);
+  return *this;
+}
+
 DataPlane* Runtime::get_data_plane() {
   return dp_;
 }
@@ -193,41 +219,30 @@ Isolate* Runtime::get_isolate() {
   return isolate_;
 }
 
+PassManager* Runtime::get_pass_manager() {
+  return pm_;
+}
+
 Engine::Id Runtime::get_next_id() {
   return next_id_++;
 }
 
 pair<bool, bool> Runtime::eval(istream& is) {
-  log_->clear();
-  const auto eof = parser_->parse(is);
-  auto err = log_->error();
-
-  if (err) {
-    log_parse_errors();
-  } else {
-    schedule_blocking_interrupt([this, &is, &err]{
-      err = !eval_nodes(parser_->begin(), parser_->end());
-    });
-  }
-  return make_pair(eof, err);
+  vector<ModuleItem*> items;
+  const auto res = stage(is, items);
+  const auto ok = commit(items);
+  return make_pair(res.first, res.second || !ok);
 }
 
 pair<bool, bool> Runtime::eval_all(istream& is) {
+  vector<ModuleItem*> items;
   auto eof = false;
   auto err = false;
-  schedule_blocking_interrupt([this, &is, &eof, &err]{
-    while (!eof && !err) {
-      log_->clear();
-      eof = parser_->parse(is);
-      err = log_->error();
-      if (err) {
-        log_parse_errors();
-      } else {
-        err = !eval_nodes(parser_->begin(), parser_->end());
-      }
-    }
-  });
-  return make_pair(eof, err);
+  while (!eof && !err) {
+    tie(eof, err) = stage(is, items);
+  }
+  const auto ok = commit(items);
+  return make_pair(eof, err || !ok);
 }
 
 bool Runtime::schedule_interrupt(Interrupt int_) {
@@ -240,6 +255,7 @@ bool Runtime::schedule_interrupt(Interrupt int_) {
       int_();
     }    
   });
+  int_pending_ = true;
   return true;
 }
 
@@ -256,6 +272,7 @@ bool Runtime::schedule_interrupt(Interrupt int_, Interrupt alt) {
       alt();  
     }
   });
+  int_pending_ = true;
   return true;
 }
 
@@ -276,8 +293,8 @@ bool Runtime::schedule_volatile_interrupt(Interrupt int_, Interrupt alt) {
 }
 
 void Runtime::schedule_blocking_interrupt(Interrupt int_) {
-  unique_lock<mutex> lg(block_lock_);
   if (schedule_interrupt(int_)) {
+    unique_lock<mutex> lg(block_lock_);
     while (!ints_.empty()) {
       block_cv_.wait(lg);
     }
@@ -285,8 +302,8 @@ void Runtime::schedule_blocking_interrupt(Interrupt int_) {
 }
 
 void Runtime::schedule_blocking_interrupt(Interrupt int_, Interrupt alt) {
-  unique_lock<mutex> lg(block_lock_);
   if (schedule_interrupt(int_, alt)) {
+    unique_lock<mutex> lg(block_lock_);
     while (!ints_.empty()) {
       block_cv_.wait(lg);
     }
@@ -294,8 +311,8 @@ void Runtime::schedule_blocking_interrupt(Interrupt int_, Interrupt alt) {
 }
 
 void Runtime::schedule_blocking_volatile_interrupt(Interrupt int_, Interrupt alt) {
-  unique_lock<mutex> lg(block_lock_);
   if (schedule_volatile_interrupt(int_, alt)) {
+    unique_lock<mutex> lg(block_lock_);
     while (!volatile_ints_.empty()) {
       block_cv_.wait(lg);
     }
@@ -314,8 +331,8 @@ void Runtime::schedule_state_safe_interrupt(Interrupt int__) {
   );
 }
 
-void Runtime::schedule_asynchronous(Asynchronous async) {
-  pool_.insert(async); 
+void Runtime::schedule_asynchronous(Asynchronous async, size_t priority) {
+  pool_.insert(async, priority);
 }
 
 bool Runtime::is_finished() const {
@@ -328,6 +345,10 @@ void Runtime::reset_open_loop_itrs() {
   });
 }
 
+bool Runtime::interrupt_pending() const {
+  return int_pending_.load(std::memory_order_relaxed) || stop_requested();
+}
+
 void Runtime::debug(uint32_t action, const string& arg) {
   schedule_interrupt([this, action, arg]{
     const auto* r = resolve(arg);
@@ -359,12 +380,14 @@ void Runtime::debug(uint32_t action, const string& arg) {
 }
 
 void Runtime::finish(uint32_t arg) {
+  lock_guard<mutex> lg(task_lock_);
   if (arg > 0) {
     ostream(rdbuf(stdout_)) 
       << "Simulation Time: " << logical_time_ << "\n"
       << "Wall Clock Time: " << (::time(nullptr) - begin_time_) << "s" << "\n"
       << "Clock Frequency: " << overall_frequency() << endl;
   } 
+  fprintf(stderr, "DBG FINISH\n");
   request_stop();
   finished_ = true;
   yield_ = true;
@@ -467,6 +490,7 @@ void Runtime::save(const string& path) {
 }
 
 void Runtime::yield() {
+  lock_guard<mutex> lg(task_lock_);
   schedule_interrupt([this]{
     yield_ = true;
   });
@@ -490,6 +514,10 @@ void Runtime::rdbuf(FId id, streambuf* sb) {
   } else {
     streambufs_[fid] = make_pair(new nullbuf(), true);
   }
+  // Log events are only formatted if someone is listening for them
+  if (fid == (stdlog_ & 0x7fff'ffff)) {
+    enable_log_ = (sb != nullptr);
+  }
 }
 
 streambuf* Runtime::rdbuf(FId id) const {
@@ -499,6 +527,7 @@ streambuf* Runtime::rdbuf(FId id) const {
 }
 
 FId Runtime::fopen(const std::string& path, uint8_t mode) {
+  lock_guard<mutex> lg(task_lock_);
   incstream is(fopen_dirs_);
   const auto full_path = is.find(path);
   const auto target = full_path == "" ? path : full_path;
@@ -519,10 +548,12 @@ FId Runtime::fopen(const std::string& path, uint8_t mode) {
 }
 
 int32_t Runtime::in_avail(FId id) {
+  lock_guard<mutex> lg(task_lock_);
   return rdbuf(id)->in_avail();
 }
 
 uint32_t Runtime::pubseekoff(FId id, int32_t off, uint8_t way, uint8_t which) {
+  lock_guard<mutex> lg(task_lock_);
   auto d = ios_base::cur;
   switch (way) {
     case 1: d = ios_base::beg; break;
@@ -540,6 +571,7 @@ uint32_t Runtime::pubseekoff(FId id, int32_t off, uint8_t way, uint8_t which) {
 }
 
 uint32_t Runtime::pubseekpos(FId id, int32_t pos, uint8_t which) {
+  lock_guard<mutex> lg(task_lock_);
   auto o = ios_base::openmode();
   switch (which) {
     case 1: o = ios_base::in; break;
@@ -551,27 +583,33 @@ uint32_t Runtime::pubseekpos(FId id, int32_t pos, uint8_t which) {
 }
 
 int32_t Runtime::pubsync(FId id) {
+  lock_guard<mutex> lg(task_lock_);
   return rdbuf(id)->pubsync();
 }
 
 int32_t Runtime::sbumpc(FId id) {
+  lock_guard<mutex> lg(task_lock_);
   return rdbuf(id)->sbumpc();
 }
 
 int32_t Runtime::sgetc(FId id) {
+  lock_guard<mutex> lg(task_lock_);
   return rdbuf(id)->sgetc();
 }
 
 uint32_t Runtime::sgetn(FId id, char* c, uint32_t n) {
+  lock_guard<mutex> lg(task_lock_);
   return rdbuf(id)->sgetn(c, n);
 }
 
 int32_t Runtime::sputc(FId id, char c) {
+  lock_guard<mutex> lg(task_lock_);
   // Squelch puts which take place after a call to finish
   return !finished_ ? rdbuf(id)->sputc(c) : c;
 }
 
 uint32_t Runtime::sputn(FId id, const char* c, uint32_t n) {
+  lock_guard<mutex> lg(task_lock_);
   // Squelch puts which take place after a call to finish
   return !finished_ ? rdbuf(id)->sputn(c, n) : n;
 }
@@ -579,18 +617,24 @@ uint32_t Runtime::sputn(FId id, const char* c, uint32_t n) {
 void Runtime::run_logic() {
   if (logical_time_ == 0) {
     log_event("BEGIN");
+    Trace::instant<Trace::RUNTIME>("begin");
     ostream os(rdbuf(stdinfo_));
     os << "Started logical simulation..." << "\n";
     os << "Installation Path: " << System::src_root() << "\n";
     os << "Fopen dirs:        " << fopen_dirs_ << "\n";
     os << "Include dirs:      " << include_dirs_ << "\n";
     os << "C++ Compiler:      " << System::cxx_compiler() << "\n";
+    os << "IR Passes:         " << pm_->get_passes() << "\n";
     os.flush();
   }
   if (finished_) {
     return;
   }
+  watchdog_.run();
+  fprintf(stderr, "DBG RUN fin=%d stop=%d\n", (int)finished_, (int)stop_requested());
+  size_t dbg_itrs = 0;
   while (!stop_requested() && !finished_) {
+    ++dbg_itrs;
     if (enable_open_loop_ && !schedule_all_) {
       open_loop_scheduler();
     } else {
@@ -598,17 +642,91 @@ void Runtime::run_logic() {
     }
     log_freq();
   }
+  watchdog_.stop_now();
+  fprintf(stderr, "DBG EXIT itrs=%zu fin=%d time=%d\n", dbg_itrs, (int)finished_, (int)logical_time_);
   if (finished_) {
     done_simulation();
     log_event("END");
+    Trace::instant<Trace::RUNTIME>("end", logical_time_);
     ostream(rdbuf(stdinfo_)) << "Finished logical simulation" << endl;
   }
 }
 
+pair<bool, bool> Runtime::stage(istream& is, vector<ModuleItem*>& items) {
+  log_->clear();
+  Trace::begin<Trace::RUNTIME>("parse");
+  const auto eof = parser_->parse(is);
+  Trace::end<Trace::RUNTIME>("parse");
+  if (log_->error()) {
+    log_parse_errors();
+    return make_pair(eof, true);
+  }
+
+  // Declare modules as we see them and set module items aside for later.
+  // Everything which follows an error is discarded.
+  auto res = true;
+  for (auto i = parser_->begin(), ie = parser_->end(); i != ie; ++i) {
+    if (!res) {
+      delete *i;
+    } else if ((*i)->is(Node::Tag::module_declaration)) {
+      res = stage_decl(static_cast<ModuleDeclaration*>(*i));
+    } else {
+      assert((*i)->is_subclass_of(Node::Tag::module_item));
+      items.push_back(static_cast<ModuleItem*>(*i));
+    }
+  }
+  return make_pair(eof, !res);
+}
+
+bool Runtime::stage_decl(ModuleDeclaration* md) {
+  log_event("PARSE", md);
+  { lock_guard<mutex> lg(program_lock_);
+    Trace::Scope<Trace::RUNTIME> ts("declare");
+    program_->declare(md, log_, parser_);
+    if (!log_->error() && disable_inlining_) {
+      md->get_attrs()->set_or_replace("__no_inline", new String("true"));
+    }
+  }
+  log_checker_warns();
+  if (log_->error()) {
+    log_checker_errors();
+    return false;
+  }
+
+  log_event("DECL_OK");
+  return true;
+}
+
+bool Runtime::commit(vector<ModuleItem*>& items) {
+  // Fast Path: Nothing to do
+  if (items.empty()) {
+    return true;
+  }
+  // Slow Path: Evaluate everything in a single interrupt, or clean up if the
+  // runtime is shutting down.
+  auto res = true;
+  fprintf(stderr, "DBG COMMIT %zu\n", items.size());
+  schedule_blocking_interrupt([this, &items, &res]{
+    fprintf(stderr, "DBG EVAL %zu\n", items.size());
+    res = eval_nodes(items.begin(), items.end());
+  },
+  [&items]{
+    fprintf(stderr, "DBG ALT\n");
+    for (auto* mi : items) {
+      delete mi;
+    }
+  });
+  items.clear();
+  fprintf(stderr, "DBG COMMITTED %d\n", (int)res);
+  return res;
+}
+
 void Runtime::eval_stream(istream& is) {
   for (auto res = true; res; ) {
     log_->clear();
+    Trace::begin<Trace::RUNTIME>("parse");
     const auto eof = parser_->parse(is);
+    Trace::end<Trace::RUNTIME>("parse");
 
     // Stop eval'ing as soon as we enounter a parse error, and return false.
     if (log_->error()) {
@@ -641,6 +759,7 @@ bool Runtime::eval_node(Node* n) {
 }
 
 bool Runtime::eval_decl(ModuleDeclaration* md) {
+  Trace::Scope<Trace::RUNTIME> ts("declare");
   program_->declare(md, log_, parser_);
   log_checker_warns();
   if (log_->error()) {
@@ -656,6 +775,7 @@ bool Runtime::eval_decl(ModuleDeclaration* md) {
 }
 
 bool Runtime::eval_item(ModuleItem* mi) {
+  Trace::Scope<Trace::RUNTIME> ts("eval_item");
   program_->eval(mi, log_, parser_); 
   log_checker_warns();
   if (log_->error()) {
@@ -682,6 +802,18 @@ void Runtime::resync() {
   if (item_evals_ == 0) {
     return;
   }
+  Trace::Scope<Trace::RUNTIME> ts("resync", item_evals_);
+  lock_guard<mutex> lg(program_lock_);
+
+  // Split off partitions before inlining whatever remains into the root. An
+  // annotation on the root takes precedence over the configured value, and
+  // zero stands for one partition per hardware thread.
+  const auto* np = program_->src()->get_attrs()->get<Number>("__partitions");
+  auto k = (np != nullptr) ? np->get_val().to_uint() : num_partitions_;
+  if (k == 0) {
+    k = max(thread::hardware_concurrency(), 1u);
+  }
+  program_->partition(k);
 
   // Inline as much as we can and compile whatever is new. Reset the
   // item_evals_ counter as soon as we're done.
@@ -715,11 +847,43 @@ void Runtime::resync() {
   }
   schedule_all_ = true;
 
+  // Split logic between the parallel and serial schedules. If there aren't
+  // any partitions, everything runs serially.
+  const auto num_parallel = parallel_logic_.size();
+  parallel_logic_.clear();
+  serial_logic_.clear();
+  for (auto* m : logic_) {
+    if (m->is_partition()) {
+      parallel_logic_.push_back(m);
+    } else {
+      serial_logic_.push_back(m);
+    }
+  }
+  if (parallel_logic_.empty()) {
+    serial_logic_.clear();
+  } else {
+    const auto itr = find(serial_logic_.begin(), serial_logic_.end(), root_);
+    if ((itr != serial_logic_.end()) && root_->engine()->is_logic()) {
+      parallel_logic_.push_back(root_);
+      serial_logic_.erase(itr);
+    }
+    const auto n = min(k, parallel_logic_.size());
+    if (n != fork_join_.get_num_threads()) {
+      fork_join_.set_num_threads(n);
+    }
+  }
+  if (parallel_logic_.size() != num_parallel) {
+    ostream(rdbuf(stdinfo_)) << "Evaluating " << parallel_logic_.size() << " partitions on " << fork_join_.get_num_threads() << " threads" << endl;
+  }
+
   // Determine whether we can reenter open loop in this state. 
   enable_open_loop_ = (logic_.size() == 2) && (clock_ != nullptr) && (inlined_logic_ != nullptr);
 }
 
 void Runtime::drain_active() {
+  if (!parallel_logic_.empty()) {
+    return drain_active_parallel();
+  }
   for (auto done = false; !done; ) {
     done = true;
     for (auto* m : logic_) {
@@ -733,6 +897,9 @@ void Runtime::drain_active() {
 }
 
 bool Runtime::drain_updates() {
+  if (!parallel_logic_.empty()) {
+    return drain_updates_parallel();
+  }
   auto performed_update = false;
   for (auto* m : logic_) {
     if (m->engine()->conditional_update()) {
@@ -751,6 +918,66 @@ bool Runtime::drain_updates() {
   return performed_evaluate;
 }
 
+void Runtime::drain_active_parallel() {
+  for (auto done = false; !done; ) {
+    done = true;
+    ready_logic_.clear();
+    for (auto* m : parallel_logic_) {
+      if (schedule_all_ || m->engine()->there_are_reads()) {
+        ready_logic_.push_back(m);
+      }
+    }
+    if (!ready_logic_.empty()) {
+      dp_->set_deferred(true);
+      fork_join_.run(ready_logic_.size(), [this](size_t i) {
+        ready_logic_[i]->engine()->evaluate();
+      });
+      dp_->set_deferred(false);
+      done = false;
+    }
+    for (auto* m : serial_logic_) {
+      if (schedule_all_ || m->engine()->there_are_reads()) {
+        m->engine()->evaluate();
+        done = false;
+      }
+    }
+    schedule_all_ = false;
+  }
+}
+
+bool Runtime::drain_updates_parallel() {
+  atomic<bool> performed_update(false);
+  dp_->set_deferred(true);
+  fork_join_.run(parallel_logic_.size(), [this, &performed_update](size_t i) {
+    if (parallel_logic_[i]->engine()->conditional_update()) {
+      performed_update = true;
+    }
+  });
+  dp_->set_deferred(false);
+  for (auto* m : serial_logic_) {
+    if (m->engine()->conditional_update()) {
+      performed_update = true;
+    }
+  }
+  if (!performed_update) {
+    return false;
+  }
+  atomic<bool> performed_evaluate(false);
+  dp_->set_deferred(true);
+  fork_join_.run(parallel_logic_.size(), [this, &performed_evaluate](size_t i) {
+    if (parallel_logic_[i]->engine()->conditional_evaluate()) {
+      performed_evaluate = true;
+    }
+  });
+  dp_->set_deferred(false);
+  for (auto* m : serial_logic_) {
+    if (m->engine()->conditional_evaluate()) {
+      performed_evaluate = true;
+    }
+  }
+  return performed_evaluate;
+}
+
 void Runtime::done_step() {
   for (auto* m : done_logic_) {
     m->engine()->done_step();
@@ -765,16 +992,28 @@ void Runtime::done_simulation() {
 
 void Runtime::drain_interrupts() {
   lock_guard<recursive_mutex> lg(int_lock_);
+  int_pending_ = false;
 
   // Fast Path: No interrupts
   if (ints_.empty()) {
     return;
   }
   // Slow Path: Empty the queue
+  Trace::Scope<Trace::SCHEDULE> ts("drain_interrupts", ints_.size());
+  lock_guard<mutex> pl(program_lock_);
   for (size_t i = 0; i < ints_.size(); ++i) {
     ints_[i]();
   }
   ints_.clear();
+  notify_blocked();
+}
+
+void Runtime::notify_blocked() {
+  // Threads waiting on a blocking interrupt check the queue while holding the
+  // block lock. Taking it here guarantees that a thread which saw a non-empty
+  // queue is already waiting by the time that it's notified. Nobody acquires
+  // the interrupt lock while holding the block lock, so this is deadlock free.
+  lock_guard<mutex> lg(block_lock_);
   block_cv_.notify_all();
 }
 
@@ -787,11 +1026,12 @@ void Runtime::drain_volatile_interrupts() {
   }
   // Slow Path: Empty the queue. 
   if (!volatile_ints_.empty()) {
+    lock_guard<mutex> pl(program_lock_);
     for (size_t i = 0; i < volatile_ints_.size(); ++i) {
       volatile_ints_[i]();
     }
     volatile_ints_.clear();
-    block_cv_.notify_all();
+    notify_blocked();
   }
   // Check for compiler errors from jit-handoff
   if (compiler_->error()) {
@@ -811,7 +1051,15 @@ void Runtime::open_loop_scheduler() {
   const size_t then = ::time(nullptr);
   const auto id = clock_->engine()->get_clock_id();
   const auto val = clock_->engine()->get_clock_val();
+  // The watchdog turns the open loop target into a hard limit. The engine
+  // also returns early if an interrupt arrives in the meantime.
+  if (open_loop_target_ > 0) {
+    watchdog_.arm(1000 * open_loop_target_);
+  }
+  Trace::begin<Trace::SCHEDULE>("open_loop", open_loop_itrs_);
   const auto itrs = inlined_logic_->engine()->open_loop(id, val, open_loop_itrs_);
+  Trace::end<Trace::SCHEDULE>("open_loop", itrs);
+  watchdog_.disarm();
   const size_t now = ::time(nullptr);
 
   // If we ran for an odd number of iterations, flip the clock
@@ -913,6 +1161,11 @@ void Runtime::log_compiler_errors() {
 }
 
 void Runtime::log_event(const string& type, Node* n) {
+  // Fast Path: Don't pretty-print anything if there's nowhere to put it
+  if (!enable_log_) {
+    return;
+  }
+  // Slow Path: Format the event and write it to the log
   stringstream ss;
   ss << "*** " << type << " @ " << logical_time_;
   if (n != nullptr) {
@@ -31,6 +31,7 @@
 #ifndef CASCADE_SRC_RUNTIME_RUNTIME_H
 #define CASCADE_SRC_RUNTIME_RUNTIME_H
 
+#include <atomic>
 #include <condition_variable>
 #include <ctime>
 #include <functional>
@@ -39,9 +40,11 @@
 #include <string>
 #include <vector>
 #include "common/bits.h"
+#include "common/fork_join.h"
 #include "common/log.h"
 #include "common/thread.h"
 #include "common/thread_pool.h"
+#include "common/watchdog.h"
 #include "runtime/ids.h"
 #include "target/engine.h"
 #include "verilog/ast/ast_fwd.h"
@@ -54,6 +57,7 @@ class Isolate;
 class Log;
 class Module;
 class Parser;
+class PassManager;
 class Program;
 
 class Runtime : public Thread {
@@ -82,7 +86,10 @@ class Runtime : public Thread {
     Runtime& set_include_dirs(const std::string& s);
     Runtime& set_open_loop_target(size_t olt);
     Runtime& set_disable_inlining(bool di);
+    Runtime& set_num_partitions(size_t n);
     Runtime& set_profile_interval(size_t n);
+    Runtime& set_passes(const std::string& s);
+    Runtime& set_enable_pass_report(bool epr);
 
     // Major Component Accessors and Helpers:
     //
@@ -92,16 +99,21 @@ class Runtime : public Thread {
     Compiler* get_compiler();
     DataPlane* get_data_plane();
     Isolate* get_isolate();
+    PassManager* get_pass_manager();
     Engine::Id get_next_id();
 
     // Eval Interface:
     //
     // Evaluates the next element from an input stream at the end of the
-    // current time step. Blocks until completion. Returns a pair indicating
-    // whether the end-of-file was reached and whether an error occurred.
+    // current time step. Parsing and module declarations take place on the
+    // calling thread while simulation continues. Module items are evaluated
+    // in a single interrupt. Blocks until completion. Returns a pair
+    // indicating whether the end-of-file was reached and whether an error
+    // occurred.
     std::pair<bool, bool> eval(std::istream& is);
     // Identical to eval(), but loops until either an end-of-file was reached
-    // or an error occurs.
+    // or an error occurs. Module items from every element are evaluated
+    // together in a single interrupt.
     std::pair<bool, bool> eval_all(std::istream& is);
 
     // Scheduling Interface:
@@ -135,12 +147,17 @@ class Runtime : public Thread {
     // Schedules an asynchronous task. Asynchronous tasks begin execution out
     // of phase with the logical time and may begin and end mid-step. If an
     // asynchronous task invokes any of the schedule_xxx_interrupt methods, it
-    // must use the two-argument form.
-    void schedule_asynchronous(Asynchronous async);
+    // must use the two-argument form. Tasks with higher priority begin
+    // execution first.
+    void schedule_asynchronous(Asynchronous async, size_t priority = 0);
     // Returns true if the runtime has executed a finish statement.
     bool is_finished() const;
     // Resets the open loop iteration counter
     void reset_open_loop_itrs();
+    // Returns true if there are interrupts waiting to be serviced, a stop was
+    // requested, or the open loop target has expired. This method is safe to
+    // call from any thread and is cheap enough to poll from inside open loop.
+    bool interrupt_pending() const;
 
     // System Task Interface:
     //
@@ -183,10 +200,12 @@ class Runtime : public Thread {
     std::string include_dirs_;
     std::string fopen_dirs_;
     bool disable_inlining_;
+    size_t num_partitions_;
     bool enable_open_loop_;
     size_t open_loop_itrs_;
     size_t open_loop_target_;
     size_t profile_interval_;
+    bool enable_log_;
 
     // Thread Pool:
     ThreadPool pool_;
@@ -197,6 +216,7 @@ class Runtime : public Thread {
     Compiler* compiler_;
     DataPlane* dp_;
     Isolate* isolate_;
+    PassManager* pm_;
 
     // Program State:
     Program* program_;
@@ -211,6 +231,7 @@ class Runtime : public Thread {
     std::recursive_mutex int_lock_;
     std::mutex block_lock_;
     std::condition_variable block_cv_;
+    std::atomic<bool> int_pending_;
 
     // Generic Scheduling State:
     std::vector<Module*> logic_;
@@ -221,6 +242,27 @@ class Runtime : public Thread {
     // Optimized Scheduling State:
     Module* clock_;
     Module* inlined_logic_;
+    // Preempts open loop execution once the open loop target has expired
+    Watchdog watchdog_;
+
+    // Parallel Scheduling State:
+    //
+    // When the program has been partitioned, the partitions and the root
+    // logic are evaluated concurrently by the workers in fork_join_ and
+    // everything else is evaluated serially.
+    ForkJoin fork_join_;
+    std::vector<Module*> parallel_logic_;
+    std::vector<Module*> serial_logic_;
+    std::vector<Module*> ready_logic_;
+    // Serializes system tasks and stream I/O issued by concurrent engines
+    std::mutex task_lock_;
+
+    // Staged Evaluation State:
+    //
+    // Module declarations are typechecked on the thread which invokes eval(),
+    // concurrently with simulation. The runtime holds this lock whenever it
+    // might touch program_ from its own thread.
+    std::mutex program_lock_;
 
     // Time Keeping:
     time_t begin_time_;
@@ -238,6 +280,19 @@ class Runtime : public Thread {
     // services interrupts between logical simulation steps.
     void run_logic() override;
 
+    // Staged Eval Helpers:
+    //
+    // Parses the next element from an input stream, declares any modules it
+    // contains, and appends its module items to items. Returns a pair
+    // indicating whether the end-of-file was reached and whether an error
+    // occurred. This method runs outside of the runtime thread.
+    std::pair<bool, bool> stage(std::istream& is, std::vector<ModuleItem*>& items);
+    // Identical to eval_decl(), but safe to invoke outside of an interrupt.
+    bool stage_decl(ModuleDeclaration* md);
+    // Evaluates and then clears items in a single blocking interrupt. Returns
+    // false on error.
+    bool commit(std::vector<ModuleItem*>& items);
+
     // REPL Helpers:
     //
     // Repeatedly parses and then invokes eval_nodes() on the contents of an
@@ -266,6 +321,10 @@ class Runtime : public Thread {
     // Drains update events for all modules with updates. Return true if doing
     // so resulted in new active events.
     bool drain_updates();
+    // Identical to drain_active() and drain_updates(), but evaluates parallel
+    // logic concurrently.
+    void drain_active_parallel();
+    bool drain_updates_parallel();
     // Invokes done_step on every module, completing the logical simulation step
     void done_step();
     // Invokes done_simulation on every module, completing the simulation
@@ -274,6 +333,8 @@ class Runtime : public Thread {
     void drain_interrupts();
     // Drains the volatile interrupt queue
     void drain_volatile_interrupts();
+    // Wakes up threads which are waiting on a blocking interrupt
+    void notify_blocked();
 
     // Runs in open loop until timeout or a system task is triggered
     void open_loop_scheduler();
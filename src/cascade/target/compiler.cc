@@ -42,6 +42,7 @@ using namespace std;
 namespace cascade {
 
 Compiler::Compiler() {
+  throttle_stop_ = false;
   fatal_ = false;
   what_ = "";
 }
@@ -65,6 +66,12 @@ CoreCompiler* Compiler::get(const std::string& id) {
   return (itr == ccs_.end()) ? nullptr : itr->second;
 }
 
+Compiler& Compiler::set_max_compiles(const string& id, size_t n) {
+  assert(ccs_.find(id) != ccs_.end());
+  throttle_[id] = make_pair(n, 0);
+  return *this;
+}
+
 Engine* Compiler::compile_stub(Engine::Id id, const ModuleDeclaration* md) {
   const auto loc = md->get_attrs()->get<String>("__loc")->get_readable_val();
   auto* i = get_interface(loc);
@@ -87,7 +94,8 @@ Engine* Compiler::compile(Engine::Id id, ModuleDeclaration* md) {
   }
 
   const auto target = md->get_attrs()->get<String>("__target")->get_readable_val();
-  auto* cc = ((loc != "remote") && (loc != "local")) ? get("proxy") : get(target);
+  const auto cid = ((loc != "remote") && (loc != "local")) ? "proxy" : target;
+  auto* cc = get(cid);
   if (cc == nullptr) {
     error("Unable to locate the required core compiler");
     delete md;
@@ -95,7 +103,13 @@ Engine* Compiler::compile(Engine::Id id, ModuleDeclaration* md) {
   }
 
   ids_.insert(id);
+  if (!acquire(cid)) {
+    delete md;
+    delete i;
+    return nullptr;
+  }
   auto* c = cc->compile(id, md, i);
+  release(cid);
   if (c == nullptr) {
     delete i;
     return nullptr;
@@ -117,6 +131,12 @@ void Compiler::stop_async() {
 }
 
 void Compiler::stop_compile() {
+  {
+    lock_guard<mutex> lg(throttle_lock_);
+    throttle_stop_ = true;
+  }
+  throttle_cv_.notify_all();
+
   for (auto& cc : ccs_) {
     for (auto id : ids_) {
       cc.second->stop_compile(id);
@@ -151,6 +171,34 @@ void Compiler::clear() {
   what_ = "";
 }
 
+bool Compiler::acquire(const string& id) {
+  const auto itr = throttle_.find(id);
+  if (itr == throttle_.end()) {
+    return true;
+  }
+  unique_lock<mutex> ul(throttle_lock_);
+  while (!throttle_stop_ && (itr->second.first > 0) && (itr->second.second >= itr->second.first)) {
+    throttle_cv_.wait(ul);
+  }
+  if (throttle_stop_) {
+    return false;
+  }
+  ++itr->second.second;
+  return true;
+}
+
+void Compiler::release(const string& id) {
+  const auto itr = throttle_.find(id);
+  if (itr == throttle_.end()) {
+    return;
+  }
+  {
+    lock_guard<mutex> lg(throttle_lock_);
+    --itr->second.second;
+  }
+  throttle_cv_.notify_all();
+}
+
 bool Compiler::StubCheck::check(const ModuleDeclaration* md) {
   ModuleInfo mi(md);
   if (!mi.inputs().empty() || !mi.outputs().empty()) {
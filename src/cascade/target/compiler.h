@@ -31,6 +31,7 @@
 #ifndef CASCADE_SRC_TARGET_COMPILER_H
 #define CASCADE_SRC_TARGET_COMPILER_H
 
+#include <condition_variable>
 #include <mutex>
 #include <set>
 #include <string>
@@ -58,6 +59,11 @@ class Compiler {
     // registered compiler are undefined.
     Compiler& set(const std::string& id, CoreCompiler* c);
     CoreCompiler* get(const std::string& id);
+    // Limits the number of concurrent invocations of compile() which can be
+    // handled by the core compiler registered as id. Invocations in excess of
+    // this limit block until a previous invocation returns. A value of zero
+    // (the default) indicates no limit.
+    Compiler& set_max_compiles(const std::string& id, size_t n);
 
     // Compilation Interface:
     // 
@@ -128,6 +134,16 @@ class Compiler {
     // Compilation State:
     std::unordered_set<Engine::Id> ids_;
 
+    // Throttling State:
+    std::mutex throttle_lock_;
+    std::condition_variable throttle_cv_;
+    std::unordered_map<std::string, std::pair<size_t, size_t>> throttle_;
+    bool throttle_stop_;
+
+    // Throttling Helpers:
+    bool acquire(const std::string& id);
+    void release(const std::string& id);
+
     // Error State:
     std::mutex lock_;
     bool fatal_;
@@ -63,6 +63,8 @@ class LocalInterface : public Interface {
     int32_t sputc(FId id, char c) override;
     uint32_t sputn(FId id, const char* c, uint32_t n) override;
 
+    bool interrupt_pending() override;
+
   private:
     Runtime* rt_;
 }; 
@@ -143,6 +145,10 @@ inline uint32_t LocalInterface::sputn(FId id, const char* c, uint32_t n) {
   return rt_->sputn(id, c, n);
 }
 
+inline bool LocalInterface::interrupt_pending() {
+  return rt_->interrupt_pending();
+}
+
 } // namespace cascade
 
 #endif
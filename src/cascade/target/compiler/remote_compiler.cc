@@ -31,8 +31,11 @@
 #include "target/compiler/remote_compiler.h"
 
 #include <cassert>
+#include <fcntl.h>
 #include <unordered_map>
 #include "common/log.h"
+#include "common/poller.h"
+#include "common/shmstream.h"
 #include "common/sockserver.h"
 #include "common/sockstream.h"
 #include "target/compiler/remote_interface.h"
@@ -65,7 +68,7 @@ void RemoteCompiler::schedule_state_safe_interrupt(Runtime::Interrupt int_) {
     if (si.first == -1) {
       continue;
     }
-    auto* asock = socks_[si.first];
+    auto* asock = get_sock(si.first);
     Rpc(Rpc::Type::STATE_SAFE_BEGIN).serialize(*asock);
     asock->flush();
     Rpc res;
@@ -82,7 +85,7 @@ void RemoteCompiler::schedule_state_safe_interrupt(Runtime::Interrupt int_) {
     if (si.first == -1) {
       continue;
     }
-    auto* asock = socks_[si.first];
+    auto* asock = get_sock(si.first);
     Rpc(Rpc::Type::STATE_SAFE_FINISH).serialize(*asock);
     asock->flush();
   }
@@ -109,165 +112,69 @@ RemoteCompiler& RemoteCompiler::set_port(uint32_t p) {
 }
 
 void RemoteCompiler::run_logic() {
-  sockserver tl(port_, 8);
-  sockserver ul(path_.c_str(), 8);
-  if (tl.error() || ul.error()) {
+  sockserver tl(port_, 128);
+  sockserver ul(path_.c_str(), 128);
+  poller p;
+  if (tl.error() || ul.error() || p.error()) {
     return;
   }
 
-  fd_set master_set;
-  FD_ZERO(&master_set);
-  FD_SET(tl.descriptor(), &master_set);
-  FD_SET(ul.descriptor(), &master_set);
-
-  fd_set read_set;
-  FD_ZERO(&read_set);
-
-  struct timeval timeout = {1, 0};
-  auto max_fd = max(tl.descriptor(), ul.descriptor());
+  // Listeners are non-blocking so that we can drain their backlogs in one go
+  // every time they're reported as ready.
+  fcntl(tl.descriptor(), F_SETFL, fcntl(tl.descriptor(), F_GETFL) | O_NONBLOCK);
+  fcntl(ul.descriptor(), F_SETFL, fcntl(ul.descriptor(), F_GETFL) | O_NONBLOCK);
+  p.arm(tl.descriptor());
+  p.arm(ul.descriptor());
 
   pool_.set_num_threads(4);
   pool_.run();
+  workers_.set_num_threads(max(4u, thread::hardware_concurrency()));
+  workers_.run();
 
+  vector<int> ready;
   while (!stop_requested()) {
-    read_set = master_set;
-    select(max_fd+1, &read_set, nullptr, nullptr, &timeout);
-    for (auto i = 0; i <= max_fd; ++i) {
-      
-      // Not ready; nothing to do
-      if (!FD_ISSET(i, &read_set)) {
-        continue;
-      }
-
-      // Listener logic: New connections are added to the read set Note that
-      // this is a write critical section for sockets so it is guarded against
-      // race conditions with the state safe interrupt handler.
-      if ((i == tl.descriptor()) || (i == ul.descriptor())) {
-        lock_guard<mutex> lg(slock_);
-        auto* sock = (i == tl.descriptor()) ? tl.accept() : ul.accept();
-        const auto fd = sock->descriptor();
-        FD_SET(fd, &master_set);
-        if (fd > max_fd) {
-          max_fd = fd;
-          socks_.resize(max_fd+1, nullptr);
+    p.wait(ready, 1000);
+    for (auto fd : ready) {
+      // Listener logic: New connections are added to the socket index and
+      // armed.
+      if ((fd == tl.descriptor()) || (fd == ul.descriptor())) {
+        while (true) {
+          auto* sock = (fd == tl.descriptor()) ? tl.accept() : ul.accept();
+          if (sock->error()) {
+            delete sock;
+            break;
+          }
+          const auto sfd = sock->descriptor();
+          fcntl(sfd, F_SETFL, fcntl(sfd, F_GETFL) & ~O_NONBLOCK);
+          set_sock(sfd, sock);
+          p.arm(sfd);
         }
-        socks_[fd] = sock;
+        p.arm(fd);
         continue;
       }
+      // Client: Hand this connection off to a worker. Since the descriptor
+      // isn't reported again until the worker rearms it, requests on any one
+      // connection (and so for any one engine) are handled in order.
+      workers_.insert([this, &p, fd]{serve(&p, fd);});
+    }
+  }
 
-      // Client: Grab the socket associated with this fd and handle the request
-      // Note that this is a read, which can't interfere with the state safe
-      // interrupt handler and thus doesn't need to be guarded.
-      auto* sock = socks_[i];
-      do {
-        Rpc rpc;
-        rpc.deserialize(*sock);
-        switch (rpc.type_) {
-
-          // Compiler ABI: Note that these methods remove elements from the
-          // sock index which aren't used anywhere else and thus don't need to
-          // be guarded.
-          case Rpc::Type::COMPILE: {
-            compile(sock, rpc);
-            sock = nullptr;
-            socks_[i] = nullptr;
-            FD_CLR(i, &master_set);
-            break;
-          }
-          case Rpc::Type::STOP_COMPILE: {
-            stop_compile(sock, rpc);
-            sock = nullptr;
-            socks_[i] = nullptr;
-            FD_CLR(i, &master_set);
-            break;
-          }
-
-          // Core ABI:
-          case Rpc::Type::GET_STATE:
-            get_state(sock, get_engine(rpc));
-            break;
-          case Rpc::Type::SET_STATE:
-            set_state(sock, get_engine(rpc));
-            break;
-          case Rpc::Type::GET_INPUT:
-            get_input(sock, get_engine(rpc));
-            break;
-          case Rpc::Type::SET_INPUT:
-            set_input(sock, get_engine(rpc));
-            break;
-          case Rpc::Type::FINALIZE:
-            finalize(sock, get_engine(rpc));
-            break;
-          case Rpc::Type::OVERRIDES_DONE_STEP:
-            overrides_done_step(sock, get_engine(rpc));
-            break;
-          case Rpc::Type::DONE_STEP:
-            done_step(sock, get_engine(rpc));
-            break;
-          case Rpc::Type::OVERRIDES_DONE_SIMULATION:
-            overrides_done_simulation(sock, get_engine(rpc));
-            break;
-          case Rpc::Type::DONE_SIMULATION:
-            done_simulation(sock, get_engine(rpc));
-            break;
-          case Rpc::Type::READ:
-            read(sock, get_engine(rpc));
-            break;
-          case Rpc::Type::EVALUATE:
-            evaluate(sock, get_engine(rpc));
-            break;
-          case Rpc::Type::THERE_ARE_UPDATES:
-            there_are_updates(sock, get_engine(rpc));
-            break;
-          case Rpc::Type::UPDATE:
-            update(sock, get_engine(rpc));
-            break;
-          case Rpc::Type::THERE_WERE_TASKS:
-            there_were_tasks(sock, get_engine(rpc));
-            break;
-          case Rpc::Type::CONDITIONAL_UPDATE:
-            conditional_update(sock, get_engine(rpc));
-            break;
-          case Rpc::Type::OPEN_LOOP:
-            open_loop(sock, get_engine(rpc));
-            break;
-
-          // Proxy Compiler Codes:
-          case Rpc::Type::OPEN_CONN_1: {
-            lock_guard<mutex> lg(slock_);
-            open_conn_1(sock, rpc);
-            FD_CLR(sock->descriptor(), &master_set);                                              
-            break;
-          }
-          case Rpc::Type::OPEN_CONN_2: {
-            lock_guard<mutex> lg(slock_);
-            open_conn_2(sock, rpc);
-            break;
-          }
-          case Rpc::Type::CLOSE_CONN: {
-            lock_guard<mutex> lg(slock_);
-            sock = nullptr;
-            delete socks_[sock_index_[rpc.pid_].first];
-            delete socks_[sock_index_[rpc.pid_].second];
-            socks_[sock_index_[rpc.pid_].first] = nullptr;
-            socks_[sock_index_[rpc.pid_].second] = nullptr;
-            FD_CLR(sock_index_[rpc.pid_].second, &master_set);
-            sock_index_[rpc.pid_] = make_pair(-1,-1);
-            break;
-          }
-
-          // Proxy Core Codes:
-          case Rpc::Type::TEARDOWN_ENGINE:
-            teardown_engine(sock, rpc);
-            break;
+  // Wait for the workers to finish whatever they've already started
+  workers_.stop_now();
 
-          // Control reaches here innocuosly when fds are closed remotely
-          default:
-            break;
-        }
-      } while ((sock != nullptr) && (sock->rdbuf()->in_avail() > 0));
+  // Stop all threads serving shared memory connections. Closing their
+  // segments causes them to clean up and exit.
+  { lock_guard<mutex> lg(slock_);
+    for (auto* shm : shm_index_) {
+      if (shm != nullptr) {
+        shm->close();
+      }
     }
   }
+  for (auto& t : shm_threads_) {
+    t.join();
+  }
+  shm_threads_.clear();
 
   // Stop all asynchronous compilation threads. 
   Compiler::stop_compile();
@@ -290,6 +197,77 @@ void RemoteCompiler::run_logic() {
   socks_.clear();
 }
 
+void RemoteCompiler::serve(poller* p, int fd) {
+  // Grab the socket associated with this fd. Note that this is a read, which
+  // can't interfere with the state safe interrupt handler and thus doesn't
+  // need to be guarded by slock_.
+  auto* sock = get_sock(fd);
+
+  // Handle requests until we run out of buffered data. Requests which hand
+  // off or close this socket return without rearming it.
+  do {
+    Rpc rpc;
+    rpc.deserialize(*sock);
+    if (sock->fail()) {
+      // Control reaches here innocuously when fds are closed remotely. Stop
+      // watching this socket, but leave it in the index. It's cleaned up
+      // along with any other sockets associated with its connection.
+      p->disarm(fd);
+      return;
+    }
+    switch (rpc.type_) {
+
+      // Compiler ABI: Note that these methods remove elements from the sock
+      // index which aren't used anywhere else.
+      case Rpc::Type::COMPILE: {
+        p->disarm(fd);
+        set_sock(fd, nullptr);
+        compile(sock, rpc);
+        return;
+      }
+      case Rpc::Type::STOP_COMPILE: {
+        p->disarm(fd);
+        set_sock(fd, nullptr);
+        stop_compile(sock, rpc);
+        return;
+      }
+
+      // Proxy Compiler Codes:
+      case Rpc::Type::OPEN_CONN_1: {
+        lock_guard<mutex> lg(slock_);
+        p->disarm(fd);
+        open_conn_1(sock, rpc);
+        return;
+      }
+      case Rpc::Type::OPEN_CONN_2: {
+        lock_guard<mutex> lg(slock_);
+        if (open_conn_2(sock, rpc)) {
+          p->disarm(fd);
+          return;
+        }
+        break;
+      }
+      case Rpc::Type::CLOSE_CONN: {
+        lock_guard<mutex> lg(slock_);
+        p->disarm(fd);
+        delete get_sock(sock_index_[rpc.pid_].first);
+        delete get_sock(sock_index_[rpc.pid_].second);
+        set_sock(sock_index_[rpc.pid_].first, nullptr);
+        set_sock(sock_index_[rpc.pid_].second, nullptr);
+        sock_index_[rpc.pid_] = make_pair(-1,-1);
+        return;
+      }
+
+      // Core ABI and Proxy Core Codes:
+      default:
+        dispatch(sock, rpc);
+        break;
+    }
+  } while (sock->rdbuf()->in_avail() > 0);
+
+  p->arm(fd);
+}
+
 void RemoteCompiler::compile(sockstream* sock, const Rpc& rpc) {
   // Read the module declaration in the request
   Log log;
@@ -320,7 +298,7 @@ void RemoteCompiler::compile(sockstream* sock, const Rpc& rpc) {
   pool_.insert([this, sock, rpc, md, eid]{
     // TODO(eschkufz) Race condition here between when we set sock_ and when
     // it's read.  Also, note the unguarded access to sock_index_
-    sock_ = socks_[sock_index_[rpc.pid_].second];
+    sock_ = get_sock(sock_index_[rpc.pid_].second);
     assert(sock_ != nullptr);
     auto* e = Compiler::compile(eid, md);
 
@@ -475,10 +453,122 @@ void RemoteCompiler::open_conn_1(sockstream* sock, const Rpc& rpc) {
   sock->flush();
 }
 
-void RemoteCompiler::open_conn_2(sockstream* sock, const Rpc& rpc) {
+bool RemoteCompiler::open_conn_2(sockstream* sock, const Rpc& rpc) {
   sock_index_[rpc.pid_].second = sock->descriptor();
-  Rpc(Rpc::Type::OKAY).serialize(*sock);
+
+  // If the proxy compiler offered (n = 1) to move this connection into shared
+  // memory and it's on the same host as us, agree to do so.
+  const auto shm = (rpc.n_ == 1) && sock->is_unix();
+  Rpc(Rpc::Type::OKAY, 0, 0, shm ? 1 : 0).serialize(*sock);
   sock->flush();
+  if (!shm) {
+    return false;
+  }
+
+  // Receive and map the segment, and report whether it worked.
+  auto* buf = new shmbuf(sock->recv_descriptor(), sock->descriptor());
+  Rpc(buf->error() ? Rpc::Type::FAIL : Rpc::Type::OKAY).serialize(*sock);
+  sock->flush();
+  if (buf->error()) {
+    delete buf;
+    return false;
+  }
+
+  // From here on out, traffic on this socket is served by a dedicated thread.
+  if (rpc.pid_ >= shm_index_.size()) {
+    shm_index_.resize(rpc.pid_+1, nullptr);
+  }
+  shm_index_[rpc.pid_] = buf;
+  sock->rdbuf(buf);
+  shm_threads_.push_back(thread([this, sock, rpc]{shm_loop(sock, rpc.pid_);}));
+  return true;
+}
+
+void RemoteCompiler::shm_loop(sockstream* sock, uint32_t pid) {
+  while (true) {
+    Rpc rpc;
+    rpc.deserialize(*sock);
+    if (sock->fail() || (rpc.type_ == Rpc::Type::CLOSE_CONN)) {
+      break;
+    }
+    dispatch(sock, rpc);
+  }
+
+  // Either the proxy compiler closed this connection or we're shutting down.
+  // Release the sockets associated with this connection along with the
+  // segment. Note that the sockets need to go first, since deleting them
+  // flushes their contents.
+  lock_guard<mutex> lg(slock_);
+  delete get_sock(sock_index_[pid].first);
+  delete get_sock(sock_index_[pid].second);
+  set_sock(sock_index_[pid].first, nullptr);
+  set_sock(sock_index_[pid].second, nullptr);
+  sock_index_[pid] = make_pair(-1,-1);
+  delete shm_index_[pid];
+  shm_index_[pid] = nullptr;
+}
+
+bool RemoteCompiler::dispatch(sockstream* sock, const Rpc& rpc) {
+  switch (rpc.type_) {
+    // Core ABI:
+    case Rpc::Type::GET_STATE:
+      get_state(sock, get_engine(rpc));
+      break;
+    case Rpc::Type::SET_STATE:
+      set_state(sock, get_engine(rpc));
+      break;
+    case Rpc::Type::GET_INPUT:
+      get_input(sock, get_engine(rpc));
+      break;
+    case Rpc::Type::SET_INPUT:
+      set_input(sock, get_engine(rpc));
+      break;
+    case Rpc::Type::FINALIZE:
+      finalize(sock, get_engine(rpc));
+      break;
+    case Rpc::Type::OVERRIDES_DONE_STEP:
+      overrides_done_step(sock, get_engine(rpc));
+      break;
+    case Rpc::Type::DONE_STEP:
+      done_step(sock, get_engine(rpc));
+      break;
+    case Rpc::Type::OVERRIDES_DONE_SIMULATION:
+      overrides_done_simulation(sock, get_engine(rpc));
+      break;
+    case Rpc::Type::DONE_SIMULATION:
+      done_simulation(sock, get_engine(rpc));
+      break;
+    case Rpc::Type::READ:
+      read(sock, get_engine(rpc));
+      break;
+    case Rpc::Type::EVALUATE:
+      evaluate(sock, get_engine(rpc));
+      break;
+    case Rpc::Type::THERE_ARE_UPDATES:
+      there_are_updates(sock, get_engine(rpc));
+      break;
+    case Rpc::Type::UPDATE:
+      update(sock, get_engine(rpc));
+      break;
+    case Rpc::Type::THERE_WERE_TASKS:
+      there_were_tasks(sock, get_engine(rpc));
+      break;
+    case Rpc::Type::CONDITIONAL_UPDATE:
+      conditional_update(sock, get_engine(rpc));
+      break;
+    case Rpc::Type::OPEN_LOOP:
+      open_loop(sock, get_engine(rpc));
+      break;
+
+    // Proxy Core Codes:
+    case Rpc::Type::TEARDOWN_ENGINE:
+      teardown_engine(sock, rpc);
+      break;
+
+    default:
+      return false;
+  }
+  return true;
 }
 
 void RemoteCompiler::teardown_engine(sockstream* sock, const Rpc& rpc) {
@@ -495,4 +585,17 @@ Engine* RemoteCompiler::get_engine(const Rpc& rpc) {
   return engines_[engine_index_[rpc.pid_][rpc.eid_]][rpc.n_];
 }
 
+sockstream* RemoteCompiler::get_sock(int fd) {
+  lock_guard<mutex> lg(ilock_);
+  return socks_[fd];
+}
+
+void RemoteCompiler::set_sock(int fd, sockstream* sock) {
+  lock_guard<mutex> lg(ilock_);
+  if (fd >= static_cast<int>(socks_.size())) {
+    socks_.resize(fd+1, nullptr);
+  }
+  socks_[fd] = sock;
+}
+
 } // namespace cascade
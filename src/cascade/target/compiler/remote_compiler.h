@@ -33,6 +33,7 @@
 
 #include <mutex>
 #include <string>
+#include <thread>
 #include <vector>
 #include "common/thread.h"
 #include "common/thread_pool.h"
@@ -42,6 +43,8 @@
 namespace cascade {
 
 class Engine;
+class poller;
+class shmbuf;
 class sockstream;
 
 class RemoteCompiler : public Compiler, public Thread {
@@ -61,11 +64,17 @@ class RemoteCompiler : public Compiler, public Thread {
     sockstream* sock_;
     ThreadPool pool_;
 
+    // Request Handling State:
+    ThreadPool workers_;
+
     // Socket and Engine Indices:
     //
-    // Protects concurrent access to indices
+    // Protects concurrent access to indices. slock_ guards the socket and
+    // shared memory indices against the state safe interrupt handler, and
+    // ilock_ guards the storage for socks_, which can be resized at any time.
     std::mutex elock_;
     std::mutex slock_;
+    std::mutex ilock_;
     // The ith element of this vector contains a socket for fd=i
     std::vector<sockstream*> socks_; 
     // The ith element of this vector contains the engines with local engine id i
@@ -74,6 +83,10 @@ class RemoteCompiler : public Compiler, public Thread {
     std::vector<std::pair<int, int>> sock_index_;
     // Maps a proxy core / engine id to a local engine id
     std::vector<std::vector<int>> engine_index_;
+    // Maps a proxy core id to the shared memory segment carrying its
+    // synchronous traffic, if any, and the thread which serves it
+    std::vector<shmbuf*> shm_index_;
+    std::vector<std::thread> shm_threads_;
 
     // Compiler Interface:
     void schedule_state_safe_interrupt(Runtime::Interrupt int_) override;
@@ -82,6 +95,9 @@ class RemoteCompiler : public Compiler, public Thread {
     // Thread Interface:
     void run_logic() override;
 
+    // Handles the requests which are available on fd, and then rearms it.
+    void serve(poller* p, int fd);
+
     // Compiler Interface:
     void compile(sockstream* sock, const Rpc& rpc);
     void stop_compile(sockstream* sock, const Rpc& rpc);
@@ -108,12 +124,18 @@ class RemoteCompiler : public Compiler, public Thread {
     void open_loop(sockstream* sock, Engine* e);
 
     void open_conn_1(sockstream* sock, const Rpc& rpc);
-    void open_conn_2(sockstream* sock, const Rpc& rpc);
+    bool open_conn_2(sockstream* sock, const Rpc& rpc);
+    void shm_loop(sockstream* sock, uint32_t pid);
 
     void teardown_engine(sockstream* sock, const Rpc& rpc);
 
+    // Dispatches a Core ABI request. Returns false if rpc isn't one.
+    bool dispatch(sockstream* sock, const Rpc& rpc);
+
     // Index Helpers:
     Engine* get_engine(const Rpc& rpc);
+    sockstream* get_sock(int fd);
+    void set_sock(int fd, sockstream* sock);
 };
 
 } // namespace cascade
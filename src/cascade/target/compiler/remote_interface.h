@@ -63,6 +63,8 @@ class RemoteInterface : public Interface {
     uint32_t sgetn(FId id, char* c, uint32_t n) override;
     int32_t sputc(FId id, char c) override;
     uint32_t sputn(FId id, const char* c, uint32_t n) override;
+
+    bool interrupt_pending() override;
       
   private:
     sockstream* sock_;
@@ -230,6 +232,12 @@ inline uint32_t RemoteInterface::sputn(FId id, const char* c, uint32_t n) {
   return res;
 }
 
+inline bool RemoteInterface::interrupt_pending() {
+  // A round trip to the runtime would cost more than the iterations it saves.
+  // Remote engines rely on the iteration count to bound their latency.
+  return false;
+}
+
 } // namespace cascade
 
 #endif
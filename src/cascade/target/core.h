@@ -33,12 +33,12 @@
 
 #include "common/bits.h"
 #include "runtime/ids.h"
+#include "target/interface.h"
 
 namespace cascade {
 
 // This class encapsulates the target-specific implementation of module logic.
 
-class Interface;
 class Input;
 class State;
 
@@ -54,8 +54,9 @@ class Core {
     virtual State* get_state() = 0;
     // This method must update the value of any non-volatile stateful elements
     // contained in this module. It may ignore values for volatile elements. It
-    // is called exactly once before finalize(), and may be called multiple
-    // times thereafter.
+    // is called at least once before finalize(), and may be called multiple
+    // times thereafter. Any call may provide values for only a subset of
+    // elements, in which case the remainder must be left unmodified.
     virtual void set_state(const State* s) = 0;
     // This method must return the values of all inputs connected to this
     // module. It may be called multiple times before this core is torn down.
@@ -85,6 +86,22 @@ class Core {
     // does nothing.
     virtual void done_simulation();
 
+    // Overriding this method to return true indicates that this core can
+    // record which of its stateful elements have been modified. This allows
+    // the runtime to migrate the bulk of its state to a replacement core in
+    // the background, and only transfer what's changed in the interim at
+    // handoff time. The default implementation returns false.
+    virtual bool overrides_state_tracking() const;
+    // Target-specific implementations may override this method to begin
+    // recording which stateful elements are modified. The default
+    // implementation does nothing.
+    virtual void begin_state_tracking();
+    // This method must return the values of all non-volatile stateful
+    // elements which have been modified since the most recent call to
+    // begin_state_tracking(), and stop recording modifications. The default
+    // implementation returns the result of get_state().
+    virtual State* get_tracked_state();
+
     // This method is invoked whenever new values are presented on this
     // module's input ports. It is required to perform whatever internal logic
     // is necessary such that evaluate_logic() and update_logic() behave
@@ -120,8 +137,10 @@ class Core {
     // in a state where the entire program has been inlined into this core such
     // that the only input clk, is the runtime's clock, it has value val, and
     // there are no outputs. This method must run for up to itr iterations, or
-    // until a system task is generated before returning control. On return it
-    // must report the number of iterations that it ran for. 
+    // until a system task is generated before returning control. It should
+    // also return control early at the end of an iteration if the interface
+    // reports a pending interrupt. On return it must report the number of
+    // iterations that it ran for. 
     virtual size_t open_loop(VId clk, bool val, size_t itr);
 
     // Light-weight RTTI:
@@ -131,7 +150,14 @@ class Core {
     virtual bool is_stub() const;
 
   protected:
+    // The number of open loop iterations between checks for pending
+    // interrupts. Must be a power of two.
+    static constexpr size_t open_loop_poll_ = 16;
+
     Interface* interface();
+    // Returns true if this is an iteration boundary at which open_loop()
+    // should check for and has found a pending interrupt.
+    bool open_loop_preempted(size_t itr);
 
   private:
     Interface* interface_;
@@ -209,6 +235,18 @@ inline void Core::done_simulation() {
   // Does nothing.
 }
 
+inline bool Core::overrides_state_tracking() const {
+  return false;
+}
+
+inline void Core::begin_state_tracking() {
+  // Does nothing.
+}
+
+inline State* Core::get_tracked_state() {
+  return get_state();
+}
+
 inline bool Core::conditional_update() {
   if (there_are_updates()) {
     update();
@@ -220,7 +258,7 @@ inline bool Core::conditional_update() {
 inline size_t Core::open_loop(VId clk, bool val, size_t itr) {
   Bits bits(1, val);
   size_t res = 0;
-  for (auto tasks = false; (res < itr) && !tasks; ++res) {
+  for (auto tasks = false; (res < itr) && !tasks && !open_loop_preempted(res); ++res) {
     // The clock is scheduled first. It changes its value on update and sends
     // the new value to this core. 
     bits.flip(0);
@@ -258,6 +296,10 @@ inline Interface* Core::interface() {
   return interface_;
 }
 
+inline bool Core::open_loop_preempted(size_t itr) {
+  return ((itr & (open_loop_poll_-1)) == 0) && (itr > 0) && interface_->interrupt_pending();
+}
+
 inline bool Clock::there_were_tasks() const {
   return false;
 }
@@ -152,8 +152,9 @@ class AosLogic : public Logic {
     // Evaluation Helpers:
     Evaluate eval_;
     Sync sync_;
-    Scanf scanf_;
-    Printf printf_;
+    // Decoded formats for get and put statements, indexed by task id
+    std::vector<Scanf> scanf_;
+    std::vector<Printf> printf_;
 };
 
 template <typename T>
@@ -539,11 +540,22 @@ inline bool AosLogic<T>::handle_tasks() {
         is.second = get_stream(is.first);
       }
 
-      scanf_.read_without_update(*is.second, &eval_, gs);
-      if (gs->is_non_null_var()) {
+      auto& sf = scanf_[task_id];
+      if (sf.is_slice()) {
+        // Bulk transfers are staged in eval_ and written back all at once
         const auto* r = Resolve().get_resolution(gs->get_var());
         assert(r != nullptr);
-        table_.write_var(r, scanf_.get());
+        gs->get_var()->accept_dim(&sync_);
+        sf.read(*is.second, &eval_);
+        const auto s = sf.get_slice();
+        table_.write_var(r, eval_.get_array_value(r), s.first, s.second);
+      } else {
+        sf.read_without_update(*is.second, &eval_);
+        if (gs->is_non_null_var()) {
+          const auto* r = Resolve().get_resolution(gs->get_var());
+          assert(r != nullptr);
+          table_.write_var(r, sf.get());
+        }
       }
       if (is.second->eof()) {
         table_.write_control_var(table_.feof_index(), (is.first << 1) | 1);
@@ -561,7 +573,7 @@ inline bool AosLogic<T>::handle_tasks() {
       }
 
       ps->accept_expr(&sync_);
-      printf_.write(*is.second, &eval_, ps);
+      printf_[task_id].write(*is.second, &eval_);
       if (is.second->eof()) {
         table_.write_control_var(table_.feof_index(), (is.first << 1) | 1);
       }
@@ -655,14 +667,21 @@ inline void AosLogic<T>::Inserter::visit(const FseekStatement* fs) {
 template <typename T>
 inline void AosLogic<T>::Inserter::visit(const GetStatement* gs) {
   av_->tasks_.push_back(gs);
+  av_->scanf_.resize(av_->tasks_.size());
+  av_->scanf_.back() = Scanf(gs);
   in_args_ = true;
   gs->accept_fd(this);
+  if (av_->scanf_.back().is_slice()) {
+    gs->get_var()->accept_dim(this);
+  }
   in_args_ = false;
 }
 
 template <typename T>
 inline void AosLogic<T>::Inserter::visit(const PutStatement* ps) {
   av_->tasks_.push_back(ps);
+  av_->printf_.resize(av_->tasks_.size());
+  av_->printf_.back() = Printf(ps);
   in_args_ = true;
   ps->accept_fd(this);
   ps->accept_expr(this);
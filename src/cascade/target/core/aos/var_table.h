@@ -35,6 +35,7 @@
 #include <functional>
 #include <unordered_map>
 #include "common/bits.h"
+#include "common/bits_array.h"
 #include "common/vector.h"
 #include "verilog/analyze/evaluate.h"
 #include "verilog/analyze/resolve.h"
@@ -112,7 +113,9 @@ class VarTable {
     // Writes the value of a scalar variable
     void write_var(const Identifier* id, const Bits& val);
     // Writes the value of an array variable
-    void write_var(const Identifier* id, const Vector<Bits>& val);
+    void write_var(const Identifier* id, const BitsArray& val);
+    // Writes elements begin through end-1 of an array variable
+    void write_var(const Identifier* id, const BitsArray& val, size_t begin, size_t end);
 
   private:
     Read read_;
@@ -280,15 +283,26 @@ inline void VarTable<T>::write_var(const Identifier* id, const Bits& val) {
 }
 
 template <typename T>
-inline void VarTable<T>::write_var(const Identifier* id, const Vector<Bits>& val) {
+inline void VarTable<T>::write_var(const Identifier* id, const BitsArray& val) {
   const auto itr = vtable_.find(id);
   assert(itr != vtable_.end());
   assert(val.size() == itr->second.elements);
 
-  auto idx = itr->second.begin;
-  for (size_t i = 0; i < itr->second.elements; ++i) {
+  write_var(id, val, 0, itr->second.elements);
+}
+
+template <typename T>
+inline void VarTable<T>::write_var(const Identifier* id, const BitsArray& val, size_t begin, size_t end) {
+  const auto itr = vtable_.find(id);
+  assert(itr != vtable_.end());
+  assert(val.size() == itr->second.elements);
+  assert(begin <= end);
+  assert(end <= itr->second.elements);
+
+  auto idx = itr->second.begin + begin * itr->second.words_per_element;
+  for (size_t i = begin; i < end; ++i) {
     for (size_t j = 0; j < itr->second.words_per_element; ++j) {
-      const volatile auto word = val[i].read_word<T>(j);
+      const volatile auto word = val.read_word<T>(i, j);
       write_(idx, word);
       ++idx;
     }
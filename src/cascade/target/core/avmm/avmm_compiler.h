@@ -328,6 +328,7 @@ inline std::string AvmmCompiler<M,V,A,T>::get_text() {
   os << "input wire[" << (std::numeric_limits<A>::digits-1) << ":0]  s0_address," << std::endl;
   os << "input wire s0_read," << std::endl;
   os << "input wire s0_write," << std::endl;
+  os << "input wire[" << V << ":0] s0_burstcount," << std::endl;
   os << std::endl;
   os << "output wire[" << (std::numeric_limits<T>::digits-1) << ":0] s0_readdata," << std::endl;
   os << "input  wire[" << (std::numeric_limits<T>::digits-1) << ":0] s0_writedata," << std::endl;
@@ -337,9 +338,34 @@ inline std::string AvmmCompiler<M,V,A,T>::get_text() {
   os << ");" << std::endl;
   os.tab();
 
+  os << "// Burst Sequencing: The address and count are latched on the first beat" << std::endl;
+  os << "// of a burst, and the address advances each time a beat completes." << std::endl;
+  os << "// A burstcount of zero or one is a single transfer." << std::endl;
+  os << "reg __request_prev = 0;" << std::endl;
+  os << "reg[" << (std::numeric_limits<A>::digits-1) << ":0] __burst_address = 0;" << std::endl;
+  os << "reg[" << V << ":0] __burst_count = 0;" << std::endl;
+  os << "wire __request = s0_read | s0_write;" << std::endl;
+  os << "wire[" << (std::numeric_limits<A>::digits-1) << ":0] __address = (__burst_count != 0) ? __burst_address : s0_address;" << std::endl;
+  os << "always @(posedge clk) begin" << std::endl;
+  os.tab();
+  os << "__request_prev <= __request;" << std::endl;
+  os << "if (__request && !__request_prev && (__burst_count == 0)) begin" << std::endl;
+  os.tab();
+  os << "__burst_address <= s0_address;" << std::endl;
+  os << "__burst_count <= s0_burstcount;" << std::endl;
+  os.untab();
+  os << "end else if (!__request && __request_prev && (__burst_count != 0)) begin" << std::endl;
+  os.tab();
+  os << "__burst_address <= __burst_address + 1;" << std::endl;
+  os << "__burst_count <= __burst_count - 1;" << std::endl;
+  os.untab();
+  os << "end" << std::endl;
+  os.untab();
+  os << "end" << std::endl;
+
   os << "// Unpack address into module id and variable id" << std::endl;
-  os << "wire[" << (M-1) << ":0] __mid = s0_address[" << (V+M-1) << ":" << V << "];" << std::endl;
-  os << "wire[" << (V-1) << ":0] __vid = s0_address[" << (V-1) << ":0];" << std::endl;
+  os << "wire[" << (M-1) << ":0] __mid = __address[" << (V+M-1) << ":" << V << "];" << std::endl;
+  os << "wire[" << (V-1) << ":0] __vid = __address[" << (V-1) << ":0];" << std::endl;
 
   os << "// Module Instantiations:" << std::endl;
   for (const auto& s : text) {
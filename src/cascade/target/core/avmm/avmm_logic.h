@@ -31,6 +31,7 @@
 #ifndef CASCADE_SRC_TARGET_CORE_AVMM_AVMM_LOGIC_H
 #define CASCADE_SRC_TARGET_CORE_AVMM_AVMM_LOGIC_H
 
+#include <algorithm>
 #include <cassert>
 #include <functional>
 #include <unordered_map>
@@ -90,6 +91,10 @@ class AvmmLogic : public Logic {
     const Identifier* open_loop_clock();
 
   private:
+    // The number of iterations the fpga runs for in open loop before control
+    // returns to check for pending interrupts
+    static constexpr size_t open_loop_chunk_ = 1024;
+
     // Compiler State:
     Callback cb_;
     size_t slot_;
@@ -99,6 +104,7 @@ class AvmmLogic : public Logic {
     std::vector<const Identifier*> inputs_;
     std::unordered_map<VId, const Identifier*> state_;
     std::vector<std::pair<const Identifier*, VId>> outputs_;
+    std::vector<const Identifier*> output_ids_;
     std::vector<const SystemTaskEnableStatement*> tasks_;
 
     // Control State:
@@ -113,6 +119,7 @@ class AvmmLogic : public Logic {
     // Control Helpers:
     interfacestream* get_stream(FId fd);
     bool handle_tasks();
+    void sync(const Node* n);
 
     // Indexes system tasks and inserts the identifiers which appear in those
     // tasks into the variable table.
@@ -137,12 +144,13 @@ class AvmmLogic : public Logic {
         void visit(const YieldStatement* ys) override;
     };
 
-    // Synchronizes the locations in the variable table which correspond to the
+    // Collects the locations in the variable table which correspond to the
     // identifiers which appear in an AST subtree. 
     class Sync : public Visitor {
       public:
         explicit Sync(AvmmLogic* av);
         ~Sync() override = default;
+        std::vector<const Identifier*> ids_;
       private:
         AvmmLogic* av_;
         void visit(const Identifier* id) override;
@@ -151,8 +159,9 @@ class AvmmLogic : public Logic {
     // Evaluation Helpers:
     Evaluate eval_;
     Sync sync_;
-    Scanf scanf_;
-    Printf printf_;
+    // Decoded formats for get and put statements, indexed by task id
+    std::vector<Scanf> scanf_;
+    std::vector<Printf> printf_;
 };
 
 template <size_t V, typename A, typename T>
@@ -206,6 +215,7 @@ inline AvmmLogic<V,A,T>& AvmmLogic<V,A,T>::set_output(const Identifier* id, VId
     table_.insert(id);
   }
   outputs_.push_back(std::make_pair(id, vid));
+  output_ids_.push_back(id);
   return *this;
 }
 
@@ -234,9 +244,14 @@ inline const VarTable<V,A,T>* AvmmLogic<V,A,T>::get_table() const {
 
 template <size_t V, typename A, typename T>
 inline State* AvmmLogic<V,A,T>::get_state() {
+  std::vector<const Identifier*> ids;
+  for (const auto& sv : state_) {
+    ids.push_back(sv.second);
+  }
+  table_.read_vars(slot_, ids);
+
   auto* s = new State();
   for (const auto& sv : state_) {
-    table_.read_var(slot_, sv.second);
     s->insert(sv.first, eval_.get_array_value(sv.second));
   }
   return s;
@@ -244,13 +259,16 @@ inline State* AvmmLogic<V,A,T>::get_state() {
 
 template <size_t V, typename A, typename T>
 inline void AvmmLogic<V,A,T>::set_state(const State* s) {
-  table_.write_control_var(table_.reset_index(), 1);
+  std::vector<std::pair<const Identifier*, const BitsArray*>> vals;
   for (const auto& sv : state_) {
     const auto itr = s->find(sv.first);
     if (itr != s->end()) {
-      table_.write_var(slot_, sv.second, itr->second);
+      vals.push_back(std::make_pair(sv.second, &itr->second));
     }
   }
+
+  table_.write_control_var(table_.reset_index(), 1);
+  table_.write_vars(slot_, vals);
   table_.write_control_var(table_.reset_index(), 1);
   table_.write_control_var(table_.resume_index(), 1);
 }
@@ -311,7 +329,7 @@ inline void AvmmLogic<V,A,T>::finalize() {
       default:
         continue;
     }
-    fd->accept(&sync_);
+    sync(fd);
     const auto fd_val = eval_.get_value(fd).to_uint();
     stream_cache_[i] = make_pair(fd_val, get_stream(fd_val));
   }
@@ -330,8 +348,8 @@ inline void AvmmLogic<V,A,T>::evaluate() {
   while (handle_tasks()) {
     table_.write_control_var(table_.resume_index(), 1);
   }
+  table_.read_vars(slot_, output_ids_);
   for (const auto& o : outputs_) {
-    table_.read_var(slot_, o.first);
     interface()->write(o.second, &eval_.get_value(o.first));
   }
 }
@@ -360,27 +378,37 @@ inline size_t AvmmLogic<V,A,T>::open_loop(VId clk, bool val, size_t itr) {
 
   there_were_tasks_ = false;
 
-  // Setting the open loop variable allows the continue flag to span clock
-  // ticks.  Loop here either until control returns without having hit a task
-  // (indicating that we've finished) or it trips a task that requires
-  // immediate attention.
-  table_.write_control_var(table_.open_loop_index(), itr);
-  while (handle_tasks() && !there_were_tasks_) {
-    table_.write_control_var(table_.resume_index(), 1);
-  }
-
-  // If we hit a task that requires immediate attention, clear the open loop
-  // counter, finish out this clock, and return the number of iterations that
-  // we ran for. Otherwise, we finished our quota.
-  if (there_were_tasks_) {
-    const auto res = table_.read_control_var(table_.open_loop_index());
-    table_.write_control_var(table_.open_loop_index(), 0);
-    while (handle_tasks()) {
+  // The fpga runs its quota in chunks so that we have a chance to notice
+  // pending interrupts in between them.
+  for (size_t res = 0; ; ) {
+    // Setting the open loop variable allows the continue flag to span clock
+    // ticks.  Loop here either until control returns without having hit a
+    // task (indicating that we've finished this chunk) or it trips a task that
+    // requires immediate attention.
+    const auto n = std::min(itr - res, open_loop_chunk_);
+    table_.write_control_var(table_.open_loop_index(), n);
+    while (handle_tasks() && !there_were_tasks_) {
       table_.write_control_var(table_.resume_index(), 1);
     }
-    return res;
-  } else {
-    return itr;
+
+    // If we hit a task that requires immediate attention, clear the open
+    // loop counter, finish out this clock, and return the number of
+    // iterations that we ran for. The counter holds the number of iterations
+    // that were left in this chunk.
+    if (there_were_tasks_) {
+      const auto rem = table_.read_control_var(table_.open_loop_index());
+      table_.write_control_var(table_.open_loop_index(), 0);
+      while (handle_tasks()) {
+        table_.write_control_var(table_.resume_index(), 1);
+      }
+      return res + (n - rem);
+    }
+    // Otherwise, we finished this chunk. Keep going until we've finished our
+    // quota or someone is waiting for us.
+    res += n;
+    if ((res == itr) || interface()->interrupt_pending()) {
+      return res;
+    }
   }
 }
 
@@ -486,7 +514,7 @@ inline bool AvmmLogic<V,A,T>::handle_tasks() {
     }
     case Node::Tag::finish_statement: {
       const auto* fs = static_cast<const FinishStatement*>(task);
-      fs->accept_arg(&sync_);
+      sync(fs->get_arg());
       interface()->finish(eval_.get_value(fs->get_arg()).to_uint());
       there_were_tasks_ = true;
       break;
@@ -495,7 +523,7 @@ inline bool AvmmLogic<V,A,T>::handle_tasks() {
       const auto* fs = static_cast<const FflushStatement*>(task);
       auto is = stream_cache_[task_id];
       if (is.second == nullptr) {
-        fs->accept_fd(&sync_);
+        sync(fs->get_fd());
         is.first = eval_.get_value(fs->get_fd()).to_uint();
         is.second = get_stream(is.first);
       }
@@ -509,12 +537,12 @@ inline bool AvmmLogic<V,A,T>::handle_tasks() {
       const auto* fs = static_cast<const FseekStatement*>(task);
       auto is = stream_cache_[task_id];
       if (is.second == nullptr) {
-        fs->accept_fd(&sync_);
+        sync(fs->get_fd());
         is.first = eval_.get_value(fs->get_fd()).to_uint();
         is.second = get_stream(is.first);
       }
 
-      fs->accept_offset(&sync_);
+      sync(fs->get_offset());
       const auto offset = eval_.get_value(fs->get_offset()).to_uint();
       const auto op = eval_.get_value(fs->get_op()).to_uint();
       const auto way = (op == 0) ? std::ios_base::beg : (op == 1) ? std::ios_base::cur : std::ios_base::end;
@@ -530,16 +558,27 @@ inline bool AvmmLogic<V,A,T>::handle_tasks() {
       const auto* gs = static_cast<const GetStatement*>(task);
       auto is = stream_cache_[task_id];
       if (is.second == nullptr) {
-        gs->accept_fd(&sync_);
+        sync(gs->get_fd());
         is.first = eval_.get_value(gs->get_fd()).to_uint();
         is.second = get_stream(is.first);
       }
 
-      scanf_.read_without_update(*is.second, &eval_, gs);
-      if (gs->is_non_null_var()) {
+      auto& sf = scanf_[task_id];
+      if (sf.is_slice()) {
+        // Bulk transfers are staged in eval_ and written back in one burst
         const auto* r = Resolve().get_resolution(gs->get_var());
         assert(r != nullptr);
-        table_.write_var(slot_, r, scanf_.get());
+        sync(gs->get_var()->front_dim());
+        sf.read(*is.second, &eval_);
+        const auto s = sf.get_slice();
+        table_.write_var(slot_, r, eval_.get_array_value(r), s.first, s.second);
+      } else {
+        sf.read_without_update(*is.second, &eval_);
+        if (gs->is_non_null_var()) {
+          const auto* r = Resolve().get_resolution(gs->get_var());
+          assert(r != nullptr);
+          table_.write_var(slot_, r, sf.get());
+        }
       }
       if (is.second->eof()) {
         table_.write_control_var(table_.feof_index(), (is.first << 1) | 1);
@@ -551,13 +590,13 @@ inline bool AvmmLogic<V,A,T>::handle_tasks() {
       const auto* ps = static_cast<const PutStatement*>(task);
       auto is = stream_cache_[task_id];
       if (is.second == nullptr) {
-        ps->accept_fd(&sync_);
+        sync(ps->get_fd());
         is.first = eval_.get_value(ps->get_fd()).to_uint();
         is.second = get_stream(is.first);
       }
 
-      ps->accept_expr(&sync_);
-      printf_.write(*is.second, &eval_, ps);
+      sync(ps->get_expr());
+      printf_[task_id].write(*is.second, &eval_);
       if (is.second->eof()) {
         table_.write_control_var(table_.feof_index(), (is.first << 1) | 1);
       }
@@ -595,6 +634,16 @@ inline bool AvmmLogic<V,A,T>::handle_tasks() {
   return true;
 }
 
+template <size_t V, typename A, typename T>
+inline void AvmmLogic<V,A,T>::sync(const Node* n) {
+  if (n == nullptr) {
+    return;
+  }
+  sync_.ids_.clear();
+  n->accept(&sync_);
+  table_.read_vars(slot_, sync_.ids_);
+}
+
 template <size_t V, typename A, typename T>
 inline AvmmLogic<V,A,T>::Inserter::Inserter(AvmmLogic* av) : Visitor() {
   av_ = av;
@@ -652,14 +701,21 @@ inline void AvmmLogic<V,A,T>::Inserter::visit(const FseekStatement* fs) {
 template <size_t V, typename A, typename T>
 inline void AvmmLogic<V,A,T>::Inserter::visit(const GetStatement* gs) {
   av_->tasks_.push_back(gs);
+  av_->scanf_.resize(av_->tasks_.size());
+  av_->scanf_.back() = Scanf(gs);
   in_args_ = true;
   gs->accept_fd(this);
+  if (av_->scanf_.back().is_slice()) {
+    gs->get_var()->accept_dim(this);
+  }
   in_args_ = false;
 }
 
 template <size_t V, typename A, typename T>
 inline void AvmmLogic<V,A,T>::Inserter::visit(const PutStatement* ps) {
   av_->tasks_.push_back(ps);
+  av_->printf_.resize(av_->tasks_.size());
+  av_->printf_.back() = Printf(ps);
   in_args_ = true;
   ps->accept_fd(this);
   ps->accept_expr(this);
@@ -706,7 +762,7 @@ inline void AvmmLogic<V,A,T>::Sync::visit(const Identifier* id) {
   const auto* r = Resolve().get_resolution(id);
   assert(r != nullptr);
   assert(av_->table_.find(r) != av_->table_.end());
-  av_->table_.read_var(av_->slot_, r);
+  ids_.push_back(r);
 }
 
 } // namespace cascade::avmm
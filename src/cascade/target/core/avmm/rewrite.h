@@ -64,6 +64,14 @@ class Rewrite {
       std::map<std::string, const Identifier*> posedges_;
       void visit(const Event* e) override;
     };
+    // Records the targets of write sites for variables lowered to RAMs
+    struct RamIndex : Visitor {
+      explicit RamIndex(const VarTable<V,A,T>* vt);
+      ~RamIndex() override = default;
+      const VarTable<V,A,T>* vt_;
+      std::vector<const Identifier*> sites_;
+      void visit(const NonblockingAssign* na) override;
+    };
 
     void emit_state_machine_vars(ModuleDeclaration* res, const Machinify<T>* mfy);
     void emit_avalon_vars(ModuleDeclaration* res);
@@ -71,12 +79,14 @@ class Rewrite {
     void emit_shadow_vars(ModuleDeclaration* res, const ModuleDeclaration* md, const VarTable<V,A,T>* vt);
     void emit_view_vars(ModuleDeclaration* res, const ModuleDeclaration* md, const VarTable<V,A,T>* vt);
     void emit_update_vars(ModuleDeclaration* res, const VarTable<V,A,T>* vt);
+    void emit_ram_vars(ModuleDeclaration* res, const VarTable<V,A,T>* vt, const RamIndex* ri);
     void emit_state_vars(ModuleDeclaration* res);
     void emit_trigger_vars(ModuleDeclaration* res, const TriggerIndex* ti);
     void emit_open_loop_vars(ModuleDeclaration* res);
 
     void emit_avalon_logic(ModuleDeclaration* res);
     void emit_update_logic(ModuleDeclaration* res, const VarTable<V,A,T>* vt);
+    void emit_ram_logic(ModuleDeclaration* res, const VarTable<V,A,T>* vt, const RamIndex* ri);
     void emit_state_logic(ModuleDeclaration* res, const VarTable<V,A,T>* vt, const Machinify<T>* mfy);
     void emit_trigger_logic(ModuleDeclaration* res, const TriggerIndex* ti);
     void emit_open_loop_logic(ModuleDeclaration* res, const VarTable<V,A,T>* vt);
@@ -85,6 +95,7 @@ class Rewrite {
           
     void emit_subscript(Identifier* id, size_t idx, size_t n, const std::vector<size_t>& arity) const;
     void emit_slice(Identifier* id, size_t w, size_t i) const;
+    bool has_rams(const VarTable<V,A,T>* vt) const;
 };
 
 template <size_t M, size_t V, typename A, typename T>
@@ -94,6 +105,8 @@ inline std::string Rewrite<M,V,A,T>::run(const ModuleDeclaration* md, size_t slo
   // Generate index tables before doing anything even remotely invasive
   TriggerIndex ti;
   md->accept(&ti);
+  RamIndex ri(vt);
+  md->accept(&ri);
 
   // Emit a new declaration, with module name based on slot id. This
   // declaration will use the Avalon Memory-mapped slave interface.
@@ -114,6 +127,7 @@ inline std::string Rewrite<M,V,A,T>::run(const ModuleDeclaration* md, size_t slo
   emit_shadow_vars(res, md, vt);
   emit_view_vars(res, md, vt);
   emit_update_vars(res, vt);
+  emit_ram_vars(res, vt, &ri);
   emit_state_vars(res);
   emit_trigger_vars(res, &ti);
   emit_open_loop_vars(res);
@@ -127,6 +141,7 @@ inline std::string Rewrite<M,V,A,T>::run(const ModuleDeclaration* md, size_t slo
   emit_state_machine_vars(res, &mfy);
   emit_avalon_logic(res);
   emit_update_logic(res, vt);
+  emit_ram_logic(res, vt, &ri);
   emit_state_logic(res, vt, &mfy);
   emit_trigger_logic(res, &ti);
   emit_open_loop_logic(res, vt);
@@ -166,6 +181,22 @@ inline void Rewrite<M,V,A,T>::TriggerIndex::visit(const Event* e) {
   }
 }
 
+template <size_t M, size_t V, typename A, typename T>
+inline Rewrite<M,V,A,T>::RamIndex::RamIndex(const VarTable<V,A,T>* vt) : Visitor() { 
+  vt_ = vt;
+}
+
+template <size_t M, size_t V, typename A, typename T>
+inline void Rewrite<M,V,A,T>::RamIndex::visit(const NonblockingAssign* na) {
+  // Sites are numbered in the same order that TextMangle encounters them
+  const auto* r = Resolve().get_resolution(na->get_lhs());
+  assert(r != nullptr);
+  const auto titr = vt_->find(r);
+  if ((titr != vt_->end()) && titr->second.ram) {
+    sites_.push_back(r);
+  }
+}
+
 template <size_t M, size_t V, typename A, typename T>
 inline void Rewrite<M,V,A,T>::emit_state_machine_vars(ModuleDeclaration* res, const Machinify<T>* mfy) {
   ItemBuilder ib;
@@ -204,7 +235,7 @@ inline void Rewrite<M,V,A,T>::emit_shadow_vars(ModuleDeclaration* res, const Mod
   // Index the stateful elements in the variable table
   std::map<std::string, typename VarTable<V,A,T>::const_iterator> vars;
   for (auto v = vt->begin(), ve = vt->end(); v != ve; ++v) {
-    if (info.is_stateful(v->first)) {
+    if (info.is_stateful(v->first) && !v->second.ram) {
       vars.insert(make_pair(v->first->front_ids()->get_readable_sid(), v));
     }
   }
@@ -236,10 +267,11 @@ template <size_t M, size_t V, typename A, typename T>
 inline void Rewrite<M,V,A,T>::emit_view_vars(ModuleDeclaration* res, const ModuleDeclaration* md, const VarTable<V,A,T>* vt) {
   ModuleInfo info(md);
 
-  // Index both inputs and the stateful elements in the variable table
+  // Index both inputs and the stateful elements in the variable table which
+  // weren't lowered to RAMs
   std::map<std::string, typename VarTable<V,A,T>::const_iterator> vars;
   for (auto v = vt->begin(), ve = vt->end(); v != ve; ++v) {
-    if (info.is_input(v->first) || info.is_stateful(v->first)) {
+    if ((info.is_input(v->first) || info.is_stateful(v->first)) && !v->second.ram) {
       vars.insert(make_pair(v->first->front_ids()->get_readable_sid(), v));
     }
   }
@@ -293,6 +325,36 @@ inline void Rewrite<M,V,A,T>::emit_update_vars(ModuleDeclaration* res, const Var
   res->push_back_items(ib.begin(), ib.end());
 }
 
+template <size_t M, size_t V, typename A, typename T>
+inline void Rewrite<M,V,A,T>::emit_ram_vars(ModuleDeclaration* res, const VarTable<V,A,T>* vt, const RamIndex* ri) {
+  if (!has_rams(vt)) {
+    return;
+  }
+  ItemBuilder ib;
+
+  // Emit the window register and an address/data pair for every write site 
+  ib << "reg[" << (std::numeric_limits<T>::digits-1) << ":0] __ram_window = 0;" << std::endl;
+  for (size_t i = 0, ie = ri->sites_.size(); i < ie; ++i) {
+    const auto* r = ri->sites_[i];
+    assert(r->get_parent()->is(Node::Tag::reg_declaration));
+    ib << "reg[" << (std::numeric_limits<T>::digits-1) << ":0] __ram_addr_" << i << ";" << std::endl;
+
+    auto* rd = static_cast<const RegDeclaration*>(r->get_parent())->clone();
+    rd->replace_id(new Identifier("__ram_data_" + std::to_string(i)));
+    rd->replace_val(nullptr);
+    ib << rd << std::endl;
+    delete rd;
+  }
+
+  // Emit update masks for the write queue
+  const auto update_arity = std::max(static_cast<size_t>(1), ri->sites_.size());
+  ib << "reg[" << (update_arity-1) << ":0] __ram_prev_update_mask = 0;" << std::endl;
+  ib << "reg[" << (update_arity-1) << ":0] __ram_update_mask = 0;" << std::endl;
+  ib << "wire[" << (update_arity-1) << ":0] __ram_update_queue;" << std::endl;
+
+  res->push_back_items(ib.begin(), ib.end());
+}
+
 template <size_t M, size_t V, typename A, typename T>
 inline void Rewrite<M,V,A,T>::emit_state_vars(ModuleDeclaration* res) {
   ItemBuilder ib;
@@ -376,13 +438,63 @@ inline void Rewrite<M,V,A,T>::emit_update_logic(ModuleDeclaration* res, const Va
 
   const auto update_arity = std::max(static_cast<size_t>(32), vt->size());
   ib << "assign __update_queue = (__prev_update_mask ^ __update_mask);" << std::endl;
-  ib << "assign __there_are_updates = |__update_queue;" << std::endl;
+  if (has_rams(vt)) {
+    ib << "assign __ram_update_queue = (__ram_prev_update_mask ^ __ram_update_mask);" << std::endl;
+    ib << "assign __there_are_updates = (|__update_queue || |__ram_update_queue);" << std::endl;
+    ib << "always @(posedge __clk) __ram_prev_update_mask <= ((__apply_updates || __reset) ? __ram_update_mask : __ram_prev_update_mask);" << std::endl;
+  } else {
+    ib << "assign __there_are_updates = |__update_queue;" << std::endl;
+  }
   ib << "assign __apply_updates = ((__read_request && (__vid == " << vt->apply_update_index() << ")) || (__there_are_updates && __open_loop_tick));" << std::endl;
   ib << "always @(posedge __clk) __prev_update_mask <= ((__apply_updates || __reset) ? __update_mask : __prev_update_mask);" << std::endl;
   
   res->push_back_items(ib.begin(), ib.end());
 }
 
+template <size_t M, size_t V, typename A, typename T>
+inline void Rewrite<M,V,A,T>::emit_ram_logic(ModuleDeclaration* res, const VarTable<V,A,T>* vt, const RamIndex* ri) {
+  if (!has_rams(vt)) {
+    return;
+  }
+
+  // Index the variables which were lowered to RAMs
+  std::map<size_t, typename VarTable<V,A,T>::const_iterator> rams;
+  for (auto t = vt->begin(), te = vt->end(); t != te; ++t) {
+    if (t->second.ram) {
+      rams[t->second.begin] = t;
+    }
+  }
+
+  ItemBuilder ib;
+  ib << "always @(posedge __clk) __ram_window <= ((__read_request && (__vid == " << vt->ram_index() << ")) ? __in : __ram_window);" << std::endl;
+
+  // Every RAM is written from a single block: first by draining its write
+  // queue entries in program order, and then through the window.
+  for (const auto& r : rams) {
+    const auto itr = r.second;
+    const auto name = itr->first->front_ids()->get_readable_sid();
+    const auto w = itr->second.bits_per_element;
+
+    ib << "always @(posedge __clk) begin" << std::endl;
+    ib << "if (__apply_updates) begin" << std::endl;
+    for (size_t i = 0, ie = ri->sites_.size(); i < ie; ++i) {
+      if (ri->sites_[i] == itr->first) {
+        ib << "if (__ram_update_queue[" << i << "]) " << name << "[__ram_addr_" << i << "] <= __ram_data_" << i << ";" << std::endl;
+      }
+    }
+    ib << "end" << std::endl;
+    for (size_t j = 0, je = itr->second.words_per_element; j < je; ++j) {
+      auto* id = new Identifier(new Id(name), new Identifier("__ram_window"));
+      emit_slice(id, w, j);
+      ib << "if (__read_request && (__vid == " << (itr->second.begin+j) << ")) " << id << " <= __in;" << std::endl;
+      delete id;
+    }
+    ib << "end" << std::endl;
+  }
+
+  res->push_back_items(ib.begin(), ib.end());
+}
+
 template <size_t M, size_t V, typename A, typename T>
 inline void Rewrite<M,V,A,T>::emit_state_logic(ModuleDeclaration* res, const VarTable<V,A,T>* vt, const Machinify<T>* mfy) {
   ItemBuilder ib;
@@ -481,10 +593,11 @@ template <size_t M, size_t V, typename A, typename T>
 inline void Rewrite<M,V,A,T>::emit_var_logic(ModuleDeclaration* res, const ModuleDeclaration* md, const VarTable<V,A,T>* vt, const Machinify<T>* mfy, const Identifier* clock) {
   ModuleInfo info(md);
 
-  // Index both inputs and stateful elements in the variable table 
+  // Index both inputs and stateful elements in the variable table, other than
+  // RAMs, which are updated by emit_ram_logic
   std::map<size_t, typename VarTable<V,A,T>::const_iterator> vars;
   for (auto t = vt->begin(), te = vt->end(); t != te; ++t) {
-    if (info.is_input(t->first) || info.is_stateful(t->first)) {
+    if ((info.is_input(t->first) || info.is_stateful(t->first)) && !t->second.ram) {
       vars[t->second.begin] = t;
     }
   }
@@ -569,8 +682,11 @@ inline void Rewrite<M,V,A,T>::emit_output_logic(ModuleDeclaration* res, const Mo
   // (outputs), and the variables which are.
   std::map<size_t, typename VarTable<V,A,T>::const_iterator> vars;
   std::map<size_t, typename VarTable<V,A,T>::const_iterator> outputs;
+  std::map<size_t, typename VarTable<V,A,T>::const_iterator> rams;
   for (auto t = vt->begin(), te = vt->end(); t != te; ++t) {
-    if (!info.is_input(t->first) && !info.is_stateful(t->first)) {
+    if (t->second.ram) {
+      rams[t->second.begin] = t;
+    } else if (!info.is_input(t->first) && !info.is_stateful(t->first)) {
       outputs[t->second.begin] = t;
     } else {
       vars[t->second.begin] = t;
@@ -596,6 +712,19 @@ inline void Rewrite<M,V,A,T>::emit_output_logic(ModuleDeclaration* res, const Mo
       delete id;
     }
   }
+  for (const auto& r : rams) {
+    const auto itr = r.second;
+    const auto w = itr->second.bits_per_element;
+    for (size_t i = 0; i < itr->second.words_per_element; ++i) {
+      ib << (itr->second.begin+i) << ": __out = ";
+
+      auto* id = new Identifier(new Id(itr->first->front_ids()->get_readable_sid()), new Identifier("__ram_window"));
+      emit_slice(id, w, i);
+      ib << id << ";" << std::endl;
+
+      delete id;
+    }
+  }
   
   ib << vt->there_are_updates_index() << ": __out = __there_are_updates;" << std::endl;
   ib << vt->there_were_tasks_index() << ": __out = __task_id[0];" << std::endl;
@@ -648,6 +777,16 @@ inline void Rewrite<M,V,A,T>::emit_slice(Identifier* id, size_t w, size_t i) con
   }
 }
 
+template <size_t M, size_t V, typename A, typename T>
+inline bool Rewrite<M,V,A,T>::has_rams(const VarTable<V,A,T>* vt) const {
+  for (auto t = vt->begin(), te = vt->end(); t != te; ++t) {
+    if (t->second.ram) {
+      return true;
+    }
+  }
+  return false;
+}
+
 } // namespace cascade::avmm
 
 #endif
@@ -33,6 +33,7 @@
 
 #include <limits>
 #include <stddef.h>
+#include <string>
 #include <vector>
 #include "target/core/avmm/var_table.h"
 #include "verilog/analyze/module_info.h"
@@ -49,6 +50,8 @@ namespace cascade::avmm {
 // 3. $feof() expressions are replaced their corresponding vtable entry
 // 4. System tasks are transformed into state udpate operations
 // 5. Non-blocking assignments are transformed into state update operations
+//    Assignments to variables which are lowered to RAMs are transformed into
+//    write queue operations, numbered in order of appearance.
 
 template <size_t V, typename A, typename T>
 class TextMangle : public Builder {
@@ -60,6 +63,7 @@ class TextMangle : public Builder {
     const ModuleDeclaration* md_;
     const VarTable<V,A,T>* vt_;
     size_t task_index_;
+    size_t site_index_;
 
     Attributes* build(const Attributes* as) override;
     ModuleItem* build(const RegDeclaration* rd) override;
@@ -86,6 +90,7 @@ inline TextMangle<V,A,T>::TextMangle(const ModuleDeclaration* md, const VarTable
   md_ = md;
   vt_ = vt;
   task_index_ = 1;
+  site_index_ = 0;
 }
 
 template <size_t V, typename A, typename T>
@@ -96,6 +101,10 @@ inline Attributes* TextMangle<V,A,T>::build(const Attributes* as) {
 
 template <size_t V, typename A, typename T>
 inline ModuleItem* TextMangle<V,A,T>::build(const RegDeclaration* rd) {
+  const auto titr = vt_->find(rd->get_id());
+  if ((titr != vt_->end()) && titr->second.ram) {
+    return rd->clone();
+  }
   return ModuleInfo(md_).is_stateful(rd->get_id()) ? nullptr : rd->clone();
 }
 
@@ -141,6 +150,36 @@ inline Statement* TextMangle<V,A,T>::build(const NonblockingAssign* na) {
   const auto* lhs = na->get_lhs();
   const auto* r = Resolve().get_resolution(lhs);
   assert(r != nullptr);
+
+  // Assignments to RAMs are placed in this site's write queue entry
+  const auto titr = vt_->find(r);
+  if ((titr != vt_->end()) && titr->second.ram) {
+    const auto site = std::to_string(site_index_++);
+    res->push_back_stmts(new NonblockingAssign(
+      na->clone_ctrl(),
+      new Identifier("__ram_addr_" + site),
+      lhs->front_dim()->clone()
+    ));
+    res->push_back_stmts(new NonblockingAssign(
+      na->clone_ctrl(),
+      new Identifier("__ram_data_" + site),
+      na->get_rhs()->clone()
+    ));
+    res->push_back_stmts(new NonblockingAssign(
+      new Identifier(
+        new Id("__ram_update_mask"),
+        new Number(Bits(std::numeric_limits<T>::digits, site_index_-1))
+      ),
+      new UnaryExpression(
+        UnaryExpression::Op::TILDE,
+        new Identifier(
+          new Id("__ram_prev_update_mask"),
+          new Number(Bits(std::numeric_limits<T>::digits, site_index_-1))
+        )
+      )
+    ));
+    return res;
+  }
   
   // Replace the original assignment with an assignment to a temporary variable
   auto* next = lhs->clone();
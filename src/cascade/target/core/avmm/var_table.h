@@ -31,12 +31,17 @@
 #ifndef CASCADE_SRC_TARGET_CORE_AVMM_VAR_TABLE_H
 #define CASCADE_SRC_TARGET_CORE_AVMM_VAR_TABLE_H
 
+#include <algorithm>
 #include <cassert>
 #include <functional>
 #include <unordered_map>
+#include <utility>
+#include <vector>
 #include "common/bits.h"
+#include "common/bits_array.h"
 #include "common/vector.h"
 #include "verilog/analyze/evaluate.h"
+#include "verilog/analyze/module_info.h"
 #include "verilog/analyze/resolve.h"
 #include "verilog/ast/ast.h"
 
@@ -51,11 +56,14 @@ class VarTable {
       size_t elements;
       size_t bits_per_element;
       size_t words_per_element;
+      bool ram;
     };
 
     // IO Typedefs:
     typedef std::function<T(A)> Read;
     typedef std::function<void(A, T)> Write;
+    typedef std::function<void(A, T*, size_t)> ReadBurst;
+    typedef std::function<void(A, const T*, size_t)> WriteBurst;
 
     // Iterator Typedefs:
     typedef typename std::unordered_map<const Identifier*, const Row>::const_iterator const_iterator;
@@ -66,8 +74,13 @@ class VarTable {
     // Configuration Interface:
     VarTable& set_read(Read read);
     VarTable& set_write(Write write);
+    // Burst IO is optional. Tables without it fall back on single words.
+    VarTable& set_read_burst(ReadBurst read_burst);
+    VarTable& set_write_burst(WriteBurst write_burst);
 
-    // Inserts an element into the table.
+    // Inserts an element into the table. Large arrays which qualify as
+    // inferred RAMs (see is_ram) only reserve a window of words_per_element
+    // words, which is paged over their contents by the ram control variable.
     void insert(const Identifier* id);
     // Returns the number of words in the var table.
     size_t size() const;
@@ -97,6 +110,8 @@ class VarTable {
     size_t feof_index() const;
     // Reserved for debugging
     size_t debug_index() const;
+    // Returns the address of the ram window control variable.
+    size_t ram_index() const;
 
     // Reads the value of a control variable
     T read_control_var(size_t index) const;
@@ -108,19 +123,45 @@ class VarTable {
     // Writes the value of a scalar variable
     void write_var(size_t slot, const Identifier* id, const Bits& val);
     // Writes the value of an array variable
-    void write_var(size_t slot, const Identifier* id, const Vector<Bits>& val);
+    void write_var(size_t slot, const Identifier* id, const BitsArray& val);
+    // Writes elements begin through end-1 of an array variable
+    void write_var(size_t slot, const Identifier* id, const BitsArray& val, size_t begin, size_t end);
+    // Reads the values of a set of variables, coalescing variables which are
+    // adjacent in the table into a single burst
+    void read_vars(size_t slot, const std::vector<const Identifier*>& ids) const;
+    // Writes the values of a set of variables, coalescing variables which are
+    // adjacent in the table into a single burst
+    void write_vars(size_t slot, const std::vector<std::pair<const Identifier*, const BitsArray*>>& vals);
 
   private:
+    // Arrays with fewer than this many elements are always flattened
+    static constexpr size_t ram_threshold_ = 256;
+
     Read read_;
     Write write_;
+    ReadBurst read_burst_;
+    WriteBurst write_burst_;
+    mutable std::vector<T> buffer_;
 
     size_t next_index_;
     std::unordered_map<const Identifier*, const Row> vtable_;
+
+    // Returns true if this variable can be lowered to an inferred RAM: a
+    // large, one-dimensional stateful array which is only ever written in
+    // its entirety by single-target non-blocking assignments outside of
+    // loops.
+    bool is_ram(const Identifier* id, size_t elements) const;
+
+    // Burst IO Helpers:
+    void read_burst(A addr, T* data, size_t n) const;
+    void write_burst(A addr, const T* data, size_t n);
 };
 
 template <size_t V, typename A, typename T>
 inline VarTable<V,A,T>::VarTable() {
   next_index_ = 0;
+  read_burst_ = nullptr;
+  write_burst_ = nullptr;
 }
 
 template <size_t V, typename A, typename T>
@@ -135,6 +176,18 @@ inline VarTable<V,A,T>& VarTable<V,A,T>::set_write(Write write) {
   return *this;
 }
 
+template <size_t V, typename A, typename T>
+inline VarTable<V,A,T>& VarTable<V,A,T>::set_read_burst(ReadBurst read_burst) {
+  read_burst_ = read_burst;
+  return *this;
+}
+
+template <size_t V, typename A, typename T>
+inline VarTable<V,A,T>& VarTable<V,A,T>::set_write_burst(WriteBurst write_burst) {
+  write_burst_ = write_burst;
+  return *this;
+}
+
 template <size_t V, typename A, typename T>
 inline void VarTable<V,A,T>::insert(const Identifier* id) {
   assert(find(id) == end());
@@ -149,14 +202,15 @@ inline void VarTable<V,A,T>::insert(const Identifier* id) {
   assert(r != nullptr);
   row.bits_per_element = std::max(Evaluate().get_width(r), Evaluate().get_width(id));
   row.words_per_element = (row.bits_per_element + std::numeric_limits<T>::digits - 1) / std::numeric_limits<T>::digits;
+  row.ram = is_ram(r, row.elements);
 
   vtable_.insert(std::make_pair(id, row));
-  next_index_ += (row.elements * row.words_per_element);
+  next_index_ += ((row.ram ? 1 : row.elements) * row.words_per_element);
 }
 
 template <size_t V, typename A, typename T>
 inline size_t VarTable<V,A,T>::size() const {
-  return debug_index() + 1;
+  return ram_index() + 1;
 }
 
 template <size_t V, typename A, typename T>
@@ -221,17 +275,22 @@ inline size_t VarTable<V,A,T>::debug_index() const {
   return next_index_ + 7;
 }
 
+template <size_t V, typename A, typename T>
+inline size_t VarTable<V,A,T>::ram_index() const {
+  return next_index_ + 8;
+}
+
 template <size_t V, typename A, typename T>
 inline T VarTable<V,A,T>::read_control_var(size_t index) const {
   assert(index >= there_are_updates_index());
-  assert(index <= debug_index());
+  assert(index <= ram_index());
   return read_(index);
 }
 
 template <size_t V, typename A, typename T>
 inline void VarTable<V,A,T>::write_control_var(size_t index, T val) {
   assert(index >= there_are_updates_index());
-  assert(index <= debug_index());
+  assert(index <= ram_index());
   write_(index, val);
 }
 
@@ -240,12 +299,24 @@ inline void VarTable<V,A,T>::read_var(size_t slot, const Identifier* id) const {
   const auto itr = vtable_.find(id);
   assert(itr != vtable_.end());
 
-  auto idx = itr->second.begin;
-  for (size_t i = 0; i < itr->second.elements; ++i) {
-    for (size_t j = 0; j < itr->second.words_per_element; ++j) {
-      const volatile auto word = read_((slot << V) | idx);
-      Evaluate().assign_word<T>(id, i, j, word);
-      ++idx;
+  const auto wpe = itr->second.words_per_element;
+  if (itr->second.ram) {
+    buffer_.resize(wpe);
+    for (size_t i = 0; i < itr->second.elements; ++i) {
+      write_((slot << V) | ram_index(), i);
+      read_burst((slot << V) | itr->second.begin, buffer_.data(), wpe);
+      for (size_t j = 0; j < wpe; ++j) {
+        Evaluate().assign_word<T>(id, i, j, buffer_[j]);
+      }
+    }
+    return;
+  } 
+
+  buffer_.resize(itr->second.elements * wpe);
+  read_burst((slot << V) | itr->second.begin, buffer_.data(), buffer_.size());
+  for (size_t i = 0, idx = 0; i < itr->second.elements; ++i) {
+    for (size_t j = 0; j < wpe; ++j, ++idx) {
+      Evaluate().assign_word<T>(id, i, j, buffer_[idx]);
     } 
   }
 }
@@ -256,28 +327,193 @@ inline void VarTable<V,A,T>::write_var(size_t slot, const Identifier* id, const
   assert(itr != vtable_.end());
   assert(itr->second.elements == 1);
 
-  auto idx = itr->second.begin;
-  for (size_t j = 0; j < itr->second.words_per_element; ++j) {
-    const volatile auto word = val.read_word<T>(j);
-    write_((slot << V) | idx, word);
-    ++idx;
+  const auto wpe = itr->second.words_per_element;
+  buffer_.resize(wpe);
+  for (size_t j = 0; j < wpe; ++j) {
+    buffer_[j] = val.read_word<T>(j);
   }
+  write_burst((slot << V) | itr->second.begin, buffer_.data(), wpe);
 }
 
 template <size_t V, typename A, typename T>
-inline void VarTable<V,A,T>::write_var(size_t slot, const Identifier* id, const Vector<Bits>& val) {
+inline void VarTable<V,A,T>::write_var(size_t slot, const Identifier* id, const BitsArray& val) {
   const auto itr = vtable_.find(id);
   assert(itr != vtable_.end());
   assert(val.size() == itr->second.elements);
+  write_var(slot, id, val, 0, itr->second.elements);
+}
+
+template <size_t V, typename A, typename T>
+inline void VarTable<V,A,T>::write_var(size_t slot, const Identifier* id, const BitsArray& val, size_t begin, size_t end) {
+  const auto itr = vtable_.find(id);
+  assert(itr != vtable_.end());
+  assert(val.size() == itr->second.elements);
+  assert(begin <= end);
+  assert(end <= itr->second.elements);
+
+  const auto wpe = itr->second.words_per_element;
+  if (itr->second.ram) {
+    buffer_.resize(wpe);
+    for (size_t i = begin; i < end; ++i) {
+      write_((slot << V) | ram_index(), i);
+      for (size_t j = 0; j < wpe; ++j) {
+        buffer_[j] = val.read_word<T>(i, j);
+      }
+      write_burst((slot << V) | itr->second.begin, buffer_.data(), wpe);
+    }
+    return;
+  }
 
-  auto idx = itr->second.begin;
-  for (size_t i = 0; i < itr->second.elements; ++i) {
-    for (size_t j = 0; j < itr->second.words_per_element; ++j) {
-      const volatile auto word = val[i].read_word<T>(j);
-      write_((slot << V) | idx, word);
-      ++idx;
+  buffer_.resize((end - begin) * wpe);
+  for (size_t i = begin, idx = 0; i < end; ++i) {
+    for (size_t j = 0; j < wpe; ++j, ++idx) {
+      buffer_[idx] = val.read_word<T>(i, j);
+    }
+  }
+  write_burst((slot << V) | (itr->second.begin + begin * wpe), buffer_.data(), buffer_.size());
+}
+
+template <size_t V, typename A, typename T>
+inline void VarTable<V,A,T>::read_vars(size_t slot, const std::vector<const Identifier*>& ids) const {
+  // Sort the rows in this set by their location in the table. Rams are paged
+  // through a window, so they're read one at a time.
+  std::vector<const_iterator> rows;
+  for (const auto* id : ids) {
+    const auto itr = vtable_.find(id);
+    assert(itr != vtable_.end());
+    if (itr->second.ram) {
+      read_var(slot, id);
+    } else {
+      rows.push_back(itr);
+    }
+  }
+  std::sort(rows.begin(), rows.end(), [](auto x, auto y) {return x->second.begin < y->second.begin;});
+  rows.erase(std::unique(rows.begin(), rows.end()), rows.end());
+
+  // Read runs of adjacent rows with a single burst
+  for (size_t i = 0, ie = rows.size(); i < ie; ) {
+    const auto begin = rows[i]->second.begin;
+    auto end = begin;
+    auto j = i;
+    for (; (j < ie) && (rows[j]->second.begin == end); ++j) {
+      end += rows[j]->second.elements * rows[j]->second.words_per_element;
+    }
+
+    buffer_.resize(end - begin);
+    read_burst((slot << V) | begin, buffer_.data(), end - begin);
+    for (size_t idx = 0; i < j; ++i) {
+      const auto& row = rows[i]->second;
+      for (size_t e = 0; e < row.elements; ++e) {
+        for (size_t w = 0; w < row.words_per_element; ++w, ++idx) {
+          Evaluate().assign_word<T>(rows[i]->first, e, w, buffer_[idx]);
+        }
+      }
+    }
+  }
+}
+
+template <size_t V, typename A, typename T>
+inline void VarTable<V,A,T>::write_vars(size_t slot, const std::vector<std::pair<const Identifier*, const BitsArray*>>& vals) {
+  // Sort the rows in this set by their location in the table. Rams are paged
+  // through a window, so they're written one at a time.
+  std::vector<std::pair<const_iterator, const BitsArray*>> rows;
+  for (const auto& v : vals) {
+    const auto itr = vtable_.find(v.first);
+    assert(itr != vtable_.end());
+    assert(v.second->size() == itr->second.elements);
+    if (itr->second.ram) {
+      write_var(slot, v.first, *v.second);
+    } else {
+      rows.push_back(std::make_pair(itr, v.second));
+    }
+  }
+  std::sort(rows.begin(), rows.end(), [](const auto& x, const auto& y) {return x.first->second.begin < y.first->second.begin;});
+
+  // Write runs of adjacent rows with a single burst
+  for (size_t i = 0, ie = rows.size(); i < ie; ) {
+    const auto begin = rows[i].first->second.begin;
+    buffer_.clear();
+    for (; (i < ie) && (rows[i].first->second.begin == begin + buffer_.size()); ++i) {
+      const auto& row = rows[i].first->second;
+      for (size_t e = 0; e < row.elements; ++e) {
+        for (size_t w = 0; w < row.words_per_element; ++w) {
+          buffer_.push_back(rows[i].second->template read_word<T>(e, w));
+        }
+      }
+    }
+    write_burst((slot << V) | begin, buffer_.data(), buffer_.size());
+  }
+}
+
+template <size_t V, typename A, typename T>
+inline void VarTable<V,A,T>::read_burst(A addr, T* data, size_t n) const {
+  if (read_burst_ != nullptr) {
+    read_burst_(addr, data, n);
+  } else for (size_t i = 0; i < n; ++i) {
+    data[i] = read_(addr + i);
+  }
+}
+
+template <size_t V, typename A, typename T>
+inline void VarTable<V,A,T>::write_burst(A addr, const T* data, size_t n) {
+  if (write_burst_ != nullptr) {
+    write_burst_(addr, data, n);
+  } else for (size_t i = 0; i < n; ++i) {
+    write_(addr + i, data[i]);
+  }
+}
+
+template <size_t V, typename A, typename T>
+inline bool VarTable<V,A,T>::is_ram(const Identifier* id, size_t elements) const {
+  if ((elements < ram_threshold_) || (Evaluate().get_arity(id).size() != 1)) {
+    return false;
+  }
+  assert(id->get_parent() != nullptr);
+  if (!id->get_parent()->is(Node::Tag::reg_declaration)) {
+    return false;
+  }
+  const auto* md = Resolve().get_origin(id);
+  if ((md == nullptr) || !ModuleInfo(md).is_stateful(id)) {
+    return false;
+  }
+
+  for (auto i = Resolve().use_begin(id), ie = Resolve().use_end(id); i != ie; ++i) {
+    if (!(*i)->is(Node::Tag::identifier)) {
+      continue;
+    }
+    const auto* u = static_cast<const Identifier*>(*i);
+    const auto* p = u->get_parent();
+    if (p->is(Node::Tag::nonblocking_assign)) {
+      const auto* na = static_cast<const NonblockingAssign*>(p);
+      if (na->get_rhs() == u) {
+        continue;
+      }
+      if ((na->size_lhs() != 1) || (u->size_dim() != 1)) {
+        return false;
+      }
+      // Each write site owns a single write queue entry, so it can't be
+      // allowed to fire more than once between updates.
+      for (const auto* n = p; n != nullptr; n = n->get_parent()) {
+        if (n->is_subclass_of(Node::Tag::loop_statement)) {
+          return false;
+        }
+      }
+    } else if (p->is(Node::Tag::blocking_assign)) {
+      if (static_cast<const BlockingAssign*>(p)->get_rhs() != u) {
+        return false;
+      }
+    } else if (p->is(Node::Tag::variable_assign)) {
+      if (static_cast<const VariableAssign*>(p)->get_rhs() != u) {
+        return false;
+      }
+    } else if (p->is(Node::Tag::get_statement)) {
+      const auto* gs = static_cast<const GetStatement*>(p);
+      if (gs->is_non_null_var() && (gs->get_var() == u)) {
+        return false;
+      }
     }
   }
+  return true;
 }
 
 } // namespace cascade::avmm
@@ -130,7 +130,9 @@ inline bool VerilatorCompiler<M,V,A,T>::compile(const std::string& text, std::mu
     
     auto read = (T (*)(A)) dlsym(handle_, "verilator_read");
     auto write = (void (*)(A, T)) dlsym(handle_, "verilator_write");
-    logic_->set_io(read, write);
+    auto read_burst = (void (*)(A, T*, size_t)) dlsym(handle_, "verilator_read_burst");
+    auto write_burst = (void (*)(A, const T*, size_t)) dlsym(handle_, "verilator_write_burst");
+    logic_->set_io(read, write, read_burst, write_burst);
     
     auto init = (void (*)()) dlsym(handle_, "verilator_init");
     init();
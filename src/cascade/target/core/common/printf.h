@@ -31,65 +31,162 @@
 #ifndef CASCADE_SRC_TARGET_CORE_COMMON_PRINTF_H
 #define CASCADE_SRC_TARGET_CORE_COMMON_PRINTF_H
 
+#include <algorithm>
 #include <cstdio>
 #include <iostream>
+#include <string>
 #include "verilog/analyze/evaluate.h"
+#include "verilog/analyze/resolve.h"
 #include "verilog/ast/ast.h"
 
 namespace cascade {
 
-struct Printf {
-  void write(std::ostream& os, Evaluate* eval, const PutStatement* ps) const;
+// A put statement's format, decoded once when a core is built rather than
+// every time the statement runs. Text is formatted into a thread-local
+// buffer and handed to the stream in a single write.
+
+class Printf {
+  public:
+    Printf();
+    explicit Printf(const PutStatement* ps);
+
+    void write(std::ostream& os, Evaluate* eval) const;
+
+  private:
+    enum class Op : uint8_t {
+      TEXT = 0,
+      VALUE,
+      CHAR,
+      STRING,
+      REAL,
+      SLICE
+    };
+
+    Op op_;
+    uint8_t base_;
+    const Expression* expr_;
+    std::string text_;
+    // The array and range of elements written by a bulk $fwrite()
+    const Identifier* var_;
+    const RangeExpression* range_;
 };
 
-inline void Printf::write(std::ostream& os, Evaluate* eval, const PutStatement* ps) const {
-  const auto* fmt = ps->get_fmt()->get_readable_val().c_str();
-  if (fmt[0] != '%') {
-    os << fmt;
+inline Printf::Printf() {
+  op_ = Op::TEXT;
+  base_ = 0;
+  expr_ = nullptr;
+  var_ = nullptr;
+  range_ = nullptr;
+}
+
+inline Printf::Printf(const PutStatement* ps) : Printf() {
+  text_ = ps->get_fmt()->get_readable_val();
+  if (text_[0] != '%') {
     return;
   }
 
   assert(ps->is_non_null_expr());
-  const auto& val = eval->get_value(ps->get_expr());
+  expr_ = ps->get_expr();
 
-  switch (fmt[1]) {
+  switch (text_[1]) {
     case '_':
-      val.write(os, 0);
-      return;
+      op_ = Op::VALUE;
+      base_ = 0;
+      break;
     case 'b':
     case 'B': 
-      val.write(os, 2);
-      return;
+      op_ = Op::VALUE;
+      base_ = 2;
+      break;
     case 'c':
     case 'C':
-      os << val.to_char();
-      return;
+      op_ = Op::CHAR;
+      break;
     case 'd':
     case 'D':
-      val.write(os, 10);
-      return;
+      op_ = Op::VALUE;
+      base_ = 10;
+      break;
     case 'h':
     case 'H': 
-      val.write(os, 16);
-      return;
+    case 'u':
+    case 'U':
+      op_ = Op::VALUE;
+      base_ = 16;
+      break;
     case 'o':
     case 'O': 
-      val.write(os, 8);
-      return;
+      op_ = Op::VALUE;
+      base_ = 8;
+      break;
     case 's':
     case 'S': 
-      os << val.to_string();
-      return;
-    case 'u':
-    case 'U':
-      val.write(os, 16);
-      return;
-    default: 
+      op_ = Op::STRING;
       break;
+    default: 
+      // Anything else is passed through to snprintf
+      op_ = Op::REAL;
+      return;
   } 
-  char buffer[1024]; 
-  std::snprintf(buffer, 1024, fmt, val.to_double());
-  os << buffer;
+
+  // Bulk transfers are indexed part-selects in place of an array subscript
+  if ((op_ == Op::VALUE) && expr_->is(Node::Tag::identifier)) {
+    const auto* id = static_cast<const Identifier*>(expr_);
+    const auto* r = Resolve().get_resolution(id);
+    if ((r != nullptr) && !r->empty_dim() && (id->size_dim() == 1) && id->front_dim()->is(Node::Tag::range_expression)) {
+      op_ = Op::SLICE;
+      var_ = r;
+      range_ = static_cast<const RangeExpression*>(id->front_dim());
+    }
+  }
+}
+
+inline void Printf::write(std::ostream& os, Evaluate* eval) const {
+  if (op_ == Op::TEXT) {
+    os.write(text_.data(), text_.length());
+    return;
+  }
+
+  thread_local std::string buf;
+  buf.clear();
+
+  // Bulk transfers write one element per line. The range may have been
+  // rewritten into some other form by the time that we see it.
+  if (op_ == Op::SLICE) {
+    const auto& arr = eval->get_array_value(var_);
+    const auto rng = eval->get_range(range_);
+    const auto end = std::min(rng.first + 1, arr.size());
+    if (rng.second < end) {
+      auto elem = arr.get(rng.second);
+      for (auto i = rng.second; i < end; ++i) {
+        arr.get(i, elem);
+        elem.write(buf, base_);
+        buf.push_back('\n');
+      }
+    }
+    os.write(buf.data(), buf.length());
+    return;
+  }
+
+  const auto& val = eval->get_value(expr_);
+  switch (op_) {
+    case Op::VALUE:
+      val.write(buf, base_);
+      break;
+    case Op::CHAR:
+      buf.push_back(val.to_char());
+      break;
+    case Op::STRING:
+      buf.append(val.to_string());
+      break;
+    default: {
+      char buffer[1024]; 
+      std::snprintf(buffer, 1024, text_.c_str(), val.to_double());
+      buf.append(buffer);
+      break;
+    }
+  }
+  os.write(buf.data(), buf.length());
 }
 
 } // namespace cascade
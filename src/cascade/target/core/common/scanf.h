@@ -31,64 +31,95 @@
 #ifndef CASCADE_SRC_TARGET_CORE_COMMON_SCANF_H
 #define CASCADE_SRC_TARGET_CORE_COMMON_SCANF_H
 
+#include <algorithm>
 #include <cctype>
 #include <iostream>
+#include <string>
+#include <utility>
 #include "common/bits.h"
 #include "verilog/analyze/evaluate.h"
+#include "verilog/analyze/resolve.h"
 #include "verilog/ast/ast.h"
 
 namespace cascade {
 
+// A get statement's format, decoded once when a core is built rather than
+// every time the statement runs.
+
 class Scanf {
   public:
-    void read(std::istream& is, Evaluate* eval, const GetStatement* gs);
-    bool read_without_update(std::istream& is, Evaluate* eval, const GetStatement* gs);
+    Scanf();
+    explicit Scanf(const GetStatement* gs);
+
+    void read(std::istream& is, Evaluate* eval);
+    bool read_without_update(std::istream& is, Evaluate* eval);
     const Bits& get() const;
+
+    // Bulk transfers can't be read without updating their target. This
+    // returns the elements written by the most recent read: [first, second).
+    bool is_slice() const;
+    std::pair<size_t, size_t> get_slice() const;
+
   private:
+    enum class Op : uint8_t {
+      TEXT = 0,
+      VALUE,
+      CHAR,
+      STRING,
+      SLICE
+    };
+
+    Op op_;
+    // 1 for reals, 2, 8, 10, or 16 for integers, and 0 to decide based on
+    // the type of the target variable
+    uint8_t base_;
+    const Identifier* var_;
+    std::string text_;
     Bits val_;
+    // The range of a bulk $fread() and the elements that it last wrote
+    const RangeExpression* range_;
+    size_t begin_;
+    size_t end_;
+
+    void read_slice(std::istream& is, Evaluate* eval);
 };
 
-inline void Scanf::read(std::istream& is, Evaluate* eval, const GetStatement* gs) {
-  if (read_without_update(is, eval, gs)) {
-    eval->assign_value(gs->get_var(), val_);
-  }
+inline Scanf::Scanf() {
+  op_ = Op::TEXT;
+  base_ = 0;
+  var_ = nullptr;
+  range_ = nullptr;
+  begin_ = 0;
+  end_ = 0;
 }
 
-inline bool Scanf::read_without_update(std::istream& is, Evaluate* eval, const GetStatement* gs) {
-  const auto format = gs->get_fmt()->get_readable_val();
-  if (format[0] != '%') {
-    for (auto c : format) {
-      if (isspace(c)) {
-        while (isspace(is.peek())) {
-          is.get();
-        }
-      } else if (c != is.get()) {
-        break;
-      }
-    }
-    return false;
+inline Scanf::Scanf(const GetStatement* gs) : Scanf() {
+  text_ = gs->get_fmt()->get_readable_val();
+  if (text_[0] != '%') {
+    return;
   }
 
   assert(gs->is_non_null_var());
-  switch (format[1]) {
+  var_ = gs->get_var();
+
+  switch (text_[1]) {
     case '_': 
-      if (eval->get_type(gs->get_var()) == Bits::Type::REAL) {
-        val_.read(is, 1);
-      } else {
-        val_.read(is, 10);
-      }
+      op_ = Op::VALUE;
+      base_ = 0;
       break;
     case 'b':
     case 'B':
-      val_.read(is, 2);
+      op_ = Op::VALUE;
+      base_ = 2;
       break;
     case 'c':
     case 'C': 
-      val_.read(is.get());
+      op_ = Op::CHAR;
       break;
     case 'd':
     case 'D': 
-      val_.read(is, 10);
+      op_ = Op::VALUE;
+      base_ = 10;
       break;
     case 'e':
     case 'E':
@@ -96,39 +127,120 @@ inline bool Scanf::read_without_update(std::istream& is, Evaluate* eval, const G
     case 'F':
     case 'g':
     case 'G': 
-      val_.read(is, 1);
+      op_ = Op::VALUE;
+      base_ = 1;
       break;
     case 'h':
     case 'H': 
-      val_.read(is, 16);
+    case 'u':
+    case 'U': 
+      op_ = Op::VALUE;
+      base_ = 16;
       break;
     case 'o':
     case 'O': 
-      val_.read(is, 8);
+      op_ = Op::VALUE;
+      base_ = 8;
       break;
     case 's':
-    case 'S': {
+    case 'S':
+      op_ = Op::STRING;
+      break;
+    default: 
+      assert(false);
+      return;
+  }
+
+  // Bulk transfers are indexed part-selects in place of an array subscript
+  if (op_ == Op::VALUE) {
+    const auto* r = Resolve().get_resolution(var_);
+    if ((r != nullptr) && !r->empty_dim() && (var_->size_dim() == 1) && var_->front_dim()->is(Node::Tag::range_expression)) {
+      op_ = Op::SLICE;
+      range_ = static_cast<const RangeExpression*>(var_->front_dim());
+      var_ = r;
+    }
+  }
+}
+
+inline void Scanf::read(std::istream& is, Evaluate* eval) {
+  if (op_ == Op::SLICE) {
+    read_slice(is, eval);
+  } else if (read_without_update(is, eval)) {
+    eval->assign_value(var_, val_);
+  }
+}
+
+inline bool Scanf::read_without_update(std::istream& is, Evaluate* eval) {
+  switch (op_) {
+    case Op::TEXT:
+      for (auto c : text_) {
+        if (isspace(c)) {
+          while (isspace(is.peek())) {
+            is.get();
+          }
+        } else if (c != is.get()) {
+          break;
+        }
+      }
+      return false;
+    case Op::VALUE:
+      if (base_ != 0) {
+        val_.read(is, base_);
+      } else if (eval->get_type(var_) == Bits::Type::REAL) {
+        val_.read(is, 1);
+      } else {
+        val_.read(is, 10);
+      }
+      return true;
+    case Op::CHAR:
+      val_.read(is.get());
+      return true;
+    case Op::STRING: {
       std::string s;
       is >> s;
       val_ = Bits(s);
-      break;
+      return true;
     }
-    case 'u':
-    case 'U': 
-      val_.read(is, 16);
-      break;
-    default: 
+    default:
       assert(false);
-      break;
+      return false;
   }
-  return true;
 }
 
 inline const Bits& Scanf::get() const {
   return val_;
 }
 
+inline bool Scanf::is_slice() const {
+  return op_ == Op::SLICE;
+}
+
+inline std::pair<size_t, size_t> Scanf::get_slice() const {
+  return std::make_pair(begin_, end_);
+}
+
+inline void Scanf::read_slice(std::istream& is, Evaluate* eval) {
+  // The range may have been rewritten into some other form by the time that
+  // we see it, but it always describes the elements [lower, upper].
+  const auto size = eval->get_array_value(var_).size();
+  const auto rng = eval->get_range(range_);
+  begin_ = rng.second;
+
+  // Elements are read one per value until either the range is full or the
+  // stream runs dry. Values past the end of the array are discarded.
+  for (end_ = begin_; end_ <= rng.first; ++end_) {
+    val_.read(is, base_);
+    if (is.fail()) {
+      break;
+    }
+    if (end_ < size) {
+      eval->assign_value(var_, end_, -1, -1, val_);
+    }
+  }
+  end_ = std::min(end_, size);
+  begin_ = std::min(begin_, end_);
+}
+
 } // namespace cascade
 
 #endif
-
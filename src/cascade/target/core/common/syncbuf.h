@@ -31,13 +31,22 @@
 #ifndef CASCADE_SRC_TARGET_CORE_COMMON_SYNCBUF_H
 #define CASCADE_SRC_TARGET_CORE_COMMON_SYNCBUF_H
 
-#include <streambuf>
-#include <mutex>
+#include <algorithm>
+#include <atomic>
 #include <condition_variable>
+#include <cstring>
+#include <mutex>
+#include <streambuf>
+#include <thread>
 
 namespace cascade {
 
-// FIFO with atomic puts and gets Peeking and put-backs are not supported
+// A single-producer single-consumer FIFO backed by a fixed capacity ring.
+// Puts of no more than capacity bytes are atomic: they become visible to the
+// reader all at once. The reader consumes directly out of the ring through
+// the get area, so single character reads don't touch shared state until the
+// current window is exhausted. Blocking operations spin briefly before
+// sleeping. Put-backs are not supported.
 
 class syncbuf : public std::streambuf {
   public:
@@ -50,122 +59,169 @@ class syncbuf : public std::streambuf {
    
     // Constructors:
     syncbuf();
-    ~syncbuf() override;
+    ~syncbuf() override = default;
     
     // Blocking Read:
     void waitforn(char_type* s, std::streamsize count);
 
   private:
-    // Shared data buffer:
-    char_type* data_;
-    size_t data_cap_;
-    size_t goff_, poff_;
-
-    // Synchronization:
+    // Ring capacity, must be a power of 2:
+    static constexpr size_t capacity_ = 1 << 16;
+
+    // Consumer state: 
+    alignas(64) std::atomic<size_t> head_;
+    // Producer state:
+    alignas(64) std::atomic<size_t> tail_;
+    size_t head_cache_;
+    // Sleeping:
+    alignas(64) std::atomic<size_t> waiters_;
     std::mutex mut_;
     std::condition_variable cv_;
-    
+    // Shared data buffer:
+    alignas(64) char_type data_[capacity_];
+
     // Get Area:
-    int_type uflow() override;
+    std::streamsize showmanyc() override;
+    int_type underflow() override;
     std::streamsize xsgetn(char_type* s, std::streamsize count) override;
 
     // Put Area:
     std::streamsize xsputn(const char_type* s, std::streamsize count) override;
+
+    // Ring Helpers:
+    void consume();
+    bool refill();
+    template <typename P>
+    void wait(P pred);
+    void notify();
 };
 
-inline syncbuf::syncbuf() {
-  data_ = new char_type[64];
-  data_cap_ = 64;
-  goff_ = 0;
-  poff_ = 0;
-  setg(nullptr, nullptr, nullptr);
+inline syncbuf::syncbuf() : std::streambuf() {
+  head_ = 0;
+  tail_ = 0;
+  head_cache_ = 0;
+  waiters_ = 0;
+  setg(data_, data_, data_);
   setp(nullptr, nullptr);
 }
 
-inline syncbuf::~syncbuf() {
-  delete[] data_;
-  //std::cout << "Final capacity: " << data_cap_ << std::endl;
+inline void syncbuf::waitforn(char_type* s, std::streamsize count) {
+  while (true) {
+    const auto n = std::min(count, static_cast<std::streamsize>(egptr() - gptr()));
+    memcpy(s, gptr(), n);
+    gbump(n);
+    s += n;
+    count -= n;
+    if (count == 0) {
+      break;
+    }
+    consume();
+    wait([this]{return tail_.load() != head_.load(std::memory_order_relaxed);});
+    refill();
+  }
+  consume();
 }
 
-inline void syncbuf::waitforn(char_type* s, std::streamsize count) {
-  std::unique_lock<std::mutex> ul(mut_);
+inline std::streamsize syncbuf::showmanyc() {
+  consume();
+  return tail_.load(std::memory_order_acquire) - head_.load(std::memory_order_relaxed);
+}
 
-  // Wait on condition variable until enough data is available
-  while ((poff_-goff_) < count) {
-    cv_.wait(ul);
-  }
-  
-  const auto next_goff = goff_ + count;
-  std::copy(&data_[goff_], &data_[next_goff], s);
-  goff_ = next_goff;
-  
-  // If no data is left, reset pointers to recycle space
-  if (goff_ == poff_) {
-    goff_ = 0;
-    poff_ = 0;
-  }
+inline syncbuf::int_type syncbuf::underflow() {
+  return refill() ? traits_type::to_int_type(*gptr()) : traits_type::eof();
 }
 
-inline syncbuf::int_type syncbuf::uflow() {
-  std::lock_guard<std::mutex> lg(mut_);
-  if (goff_ == poff_) {
-    return traits_type::eof();
-  } else {
-    const auto ret_val = traits_type::to_int_type(data_[goff_]);
-    ++goff_;
-    if (goff_ == poff_) {
-      goff_ = 0;
-      poff_ = 0;
+inline std::streamsize syncbuf::xsgetn(char_type* s, std::streamsize count) {
+  std::streamsize total = 0;
+  while (total < count) {
+    if ((gptr() == egptr()) && !refill()) {
+      break;
     }
-    return ret_val;
+    const auto n = std::min(count - total, static_cast<std::streamsize>(egptr() - gptr()));
+    memcpy(s + total, gptr(), n);
+    gbump(n);
+    total += n;
+    consume();
   }
+  return total;
 }
 
 inline std::streamsize syncbuf::xsputn(const char_type* s, std::streamsize count) {
-  std::lock_guard<std::mutex> lg(mut_);
-  size_t next_poff = poff_ + count;
-  
-  // If current capacity is insufficient, grow by power of 2
-  if (next_poff > data_cap_) {
-    while (next_poff > data_cap_) {
-      data_cap_ *= 2;
+  // Writes larger than the ring are broken into pieces. Everything else is
+  // published with a single store.
+  std::streamsize total = 0;
+  while (total < count) {
+    const auto n = std::min(static_cast<size_t>(count - total), capacity_);
+    const auto tail = tail_.load(std::memory_order_relaxed);
+    if (capacity_ - (tail - head_cache_) < n) {
+      wait([this, tail, n]{
+        head_cache_ = head_.load();
+        return capacity_ - (tail - head_cache_) >= n;
+      });
     }
-    auto next_data = new char_type[data_cap_];
-    // Only copy valid entries
-    std::copy(&data_[goff_], &data_[poff_], next_data);
-    delete data_;
-    data_ = next_data;
-    poff_ = poff_ - goff_;
-    goff_ = 0;
-    next_poff = poff_ + count;
+
+    const auto begin = tail & (capacity_ - 1);
+    const auto first = std::min(n, capacity_ - begin);
+    memcpy(data_ + begin, s + total, first);
+    memcpy(data_, s + total + first, n - first);
+    tail_.store(tail + n, std::memory_order_release);
+    notify();
+
+    total += n;
   }
-  
-  std::copy(s, s+count, &data_[poff_]);
-  poff_ = next_poff;
-  cv_.notify_all();
-  
   return count;
 }
 
-inline std::streamsize syncbuf::xsgetn(char_type* s, std::streamsize count) {
-  std::lock_guard<std::mutex> lg(mut_);
+inline void syncbuf::consume() {
+  // Release whatever the reader has already pulled out of the get area back
+  // to the writer.
+  const auto n = gptr() - eback();
+  if (n > 0) {
+    head_.store(head_.load(std::memory_order_relaxed) + n, std::memory_order_release);
+    setg(gptr(), gptr(), egptr());
+    notify();
+  }
+}
 
-  const auto true_count = std::min((size_t)count, (poff_-goff_));
-  if (true_count == 0) {
-    return 0;
+inline bool syncbuf::refill() {
+  // Expose as much of the ring as is contiguous. Refills only happen once the
+  // get area has been exhausted, so this always starts at head_.
+  consume();
+  const auto head = head_.load(std::memory_order_relaxed);
+  const auto tail = tail_.load(std::memory_order_acquire);
+  if (head == tail) {
+    return false;
   }
-  
-  const auto next_goff = goff_ + true_count;
-  std::copy(&data_[goff_], &data_[next_goff], s);
-  goff_ = next_goff;
-  
-  // If no data is left, reset pointers to recycle space
-  if (goff_ == poff_) {
-    goff_ = 0;
-    poff_ = 0;
+  const auto begin = head & (capacity_ - 1);
+  const auto n = std::min(tail - head, capacity_ - begin);
+  setg(data_ + begin, data_ + begin, data_ + begin + n);
+  return true;
+}
+
+template <typename P>
+inline void syncbuf::wait(P pred) {
+  // Spin for a while. The other side of this buffer is usually in the middle
+  // of answering. On a single core machine, spinning only delays it.
+  static const size_t spins = (std::thread::hardware_concurrency() > 1) ? 4096 : 0;
+  for (size_t i = 0; i < spins; ++i) {
+    if (pred()) {
+      return;
+    }
+  }
+  // Then fall back on sleeping. Waiters are registered before the predicate
+  // is checked under the lock, so notify() can't miss them.
+  std::unique_lock<std::mutex> ul(mut_);
+  ++waiters_;
+  cv_.wait(ul, pred);
+  --waiters_;
+}
+
+inline void syncbuf::notify() {
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  if (waiters_.load() > 0) {
+    std::lock_guard<std::mutex> lg(mut_);
+    cv_.notify_all();
   }
-  
-  return true_count;
 }
 
 } // namespace cascade
@@ -51,6 +51,9 @@ ProxyCompiler::~ProxyCompiler() {
     // has the potential to introduce a race condition on the other side.
     delete c.second.async_sock;
     delete c.second.sync_sock;
+    if (c.second.sync_shm != nullptr) {
+      delete c.second.sync_shm;
+    }
   }
 }
 
@@ -177,13 +180,11 @@ bool ProxyCompiler::open(const string& loc) {
 
   // Step 2: Open the synchronous socket and send a register request. This
   // time around, send the pid so that the new socket can be associated with
-  // this connection in the remote compiler.
+  // this connection in the remote compiler. If possible, traffic on this
+  // socket is moved into shared memory.
   ci.sync_sock = get_sock(loc);
   assert(ci.sync_sock != nullptr);
-  Rpc(Rpc::Type::OPEN_CONN_2, ci.pid, 0, 0).serialize(*ci.sync_sock);
-  ci.sync_sock->flush();
-  rpc.deserialize(*ci.sync_sock);
-  assert(rpc.type_ == Rpc::Type::OKAY);
+  ci.sync_shm = open_shm(loc, ci.pid, ci.sync_sock);
 
   // Step 3: Create a thread to listen for asynchronous messages 
   pool_.insert([this, ci]{async_loop(ci.async_sock);});
@@ -193,6 +194,37 @@ bool ProxyCompiler::open(const string& loc) {
   return true;
 }
 
+shmbuf* ProxyCompiler::open_shm(const string& loc, uint32_t pid, sockstream* sock) {
+  // If the remote compiler is on this host, offer to move synchronous traffic
+  // into shared memory by setting n to 1. Otherwise, or if we can't create a
+  // segment, stick with the socket.
+  auto* shm = (loc.find(':') == string::npos) ? new shmbuf(sock->descriptor()) : nullptr;
+  if ((shm != nullptr) && shm->error()) {
+    delete shm;
+    shm = nullptr;
+  }
+
+  Rpc rpc;
+  Rpc(Rpc::Type::OPEN_CONN_2, pid, 0, (shm != nullptr) ? 1 : 0).serialize(*sock);
+  sock->flush();
+  rpc.deserialize(*sock);
+  assert(rpc.type_ == Rpc::Type::OKAY);
+
+  // The remote compiler replies with n set to 1 if it agrees. In which case,
+  // we pass it the segment and wait to hear that it was mapped.
+  if ((shm != nullptr) && (rpc.n_ == 1) && sock->send_descriptor(shm->descriptor())) {
+    rpc.deserialize(*sock);
+    if (rpc.type_ == Rpc::Type::OKAY) {
+      sock->rdbuf(shm);
+      return shm;
+    }
+  }
+  if (shm != nullptr) {
+    delete shm;
+  }
+  return nullptr;
+}
+
 sockstream* ProxyCompiler::get_sock(const string& loc) {
   auto* sock = (loc.find(':') != string::npos) ? get_tcp_sock(loc) : get_unix_sock(loc);
   if (sock->error()) {
@@ -34,6 +34,7 @@
 #include <mutex>
 #include <string>
 #include <unordered_map>
+#include "common/shmstream.h"
 #include "common/sockstream.h"
 #include "common/thread_pool.h"
 #include "target/compiler.h"
@@ -56,6 +57,7 @@ class ProxyCompiler : public CoreCompiler {
       uint32_t pid;
       sockstream* async_sock;
       sockstream* sync_sock;
+      shmbuf* sync_shm;
     };
     std::unordered_map<std::string, ConnInfo> conns_;
     std::mutex lock_;
@@ -86,6 +88,8 @@ class ProxyCompiler : public CoreCompiler {
     bool open(const std::string& loc);
     bool close(const ConnInfo& ci);
 
+    shmbuf* open_shm(const std::string& loc, uint32_t pid, sockstream* sock);
+
     sockstream* get_sock(const std::string& loc);
     sockstream* get_tcp_sock(const std::string& loc);
     sockstream* get_unix_sock(const std::string& loc);
@@ -84,7 +84,7 @@ inline State* SwClock::get_state() {
 inline void SwClock::set_state(const State* s) {
   const auto itr = s->find(out_);
   if (itr != s->end()) {
-    val_ = itr->second[0].to_bool();
+    val_ = itr->second.get(0).to_bool();
   }
 }
 
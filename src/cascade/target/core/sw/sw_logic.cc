@@ -33,9 +33,8 @@
 #include <algorithm>
 #include <cassert>
 #include <iostream>
+#include <limits>
 #include "target/core/common/interfacestream.h"
-#include "target/core/common/printf.h"
-#include "target/core/common/scanf.h"
 #include "target/core/sw/monitor.h"
 #include "target/input.h"
 #include "target/state.h"
@@ -63,6 +62,21 @@ SwLogic::SwLogic(Interface* interface, ModuleDeclaration* md) : Logic(interface)
   });
   EofIndex ei(this);
   src_->accept(&ei);
+  CaseIndex ci(this);
+  src_->accept(&ci);
+  FormatIndex fi(this);
+  src_->accept(&fi);
+
+  // Assign a rank to every schedulable node and provision one bucket per rank
+  // in the active queue.
+  active_.resize(Levelize(this).run());
+  active_rank_ = active_.size();
+
+  // Open loop trigger sets are computed on demand
+  open_loop_clk_ = numeric_limits<VId>::max();
+
+  // State tracking is disabled until requested
+  tracking_ = false;
 
   // Set silent mode, schedule always constructs and continuous assigns, and then
   // place the silent flag in its default, disabled state
@@ -121,6 +135,27 @@ void SwLogic::set_state(const State* s) {
   silent_evaluate();
 }
 
+bool SwLogic::overrides_state_tracking() const {
+  return true;
+}
+
+void SwLogic::begin_state_tracking() {
+  tracking_ = true;
+  dirty_.clear();
+}
+
+State* SwLogic::get_tracked_state() {
+  auto* s = new State();
+  for (const auto& sv : state_) {
+    if (dirty_.find(sv.second) != dirty_.end()) {
+      s->insert(sv.first, eval_.get_array_value(sv.second));
+    }
+  }
+  tracking_ = false;
+  dirty_.clear();
+  return s;
+}
+
 Input* SwLogic::get_input() {
   auto* i = new Input();
   for (size_t v = 0, ve = inputs_.size(); v < ve; ++v) {
@@ -199,12 +234,7 @@ void SwLogic::read(VId vid, const Bits* b) {
 void SwLogic::evaluate() {
   // This is a while loop. Active events can generate new active events.
   there_were_tasks_ = false;
-  while (!active_.empty()) {
-    auto* e = active_.back();
-    active_.pop_back();
-    const_cast<Node*>(e)->set_flag<1>(false);
-    schedule_now(e);
-  }
+  drain_active();
   for (auto& o : outputs_) {
     interface()->write(o.second, &eval_.get_value(o.first));
   }
@@ -215,23 +245,12 @@ bool SwLogic::there_are_updates() const {
 }
 
 void SwLogic::update() {
-  // This is a for loop. Updates happen simultaneously
-  for (size_t i = 0, ie = updates_.size(); i < ie; ++i) {
-    const auto& val = update_pool_[i];
-    if (eval_.assign_value(get<0>(updates_[i]), get<1>(updates_[i]), get<2>(updates_[i]), get<3>(updates_[i]), val)) {
-      notify(get<0>(updates_[i]));
-    }
-  }
-  updates_.clear();
+  // Updates happen simultaneously
+  drain_updates();
 
   // This is while loop. Active events can generate new active events.
   there_were_tasks_ = false;
-  while (!active_.empty()) {
-    auto* e = active_.back();
-    active_.pop_back();
-    const_cast<Node*>(e)->set_flag<1>(false);
-    schedule_now(e);
-  }
+  drain_active();
 
   for (auto& o : outputs_) {
     interface()->write(o.second, &eval_.get_value(o.first));
@@ -242,6 +261,97 @@ bool SwLogic::there_were_tasks() const {
   return there_were_tasks_;
 }
 
+size_t SwLogic::open_loop(VId clk, bool val, size_t itr) {
+  if (clk != open_loop_clk_) {
+    init_open_loop(clk);
+  }
+  const auto* id = inputs_[clk];
+
+  size_t res = 0;
+  for (auto tasks = false; (res < itr) && !tasks && !open_loop_preempted(res); ++res) {
+    // Flip the clock in place and schedule everything which is sensitive to
+    // this edge. This bypasses the events attached to the clock, since we
+    // already know which of them will fire.
+    val = !val;
+    eval_.assign_value(id, open_loop_vals_[val]);
+    for (auto* n : open_loop_triggers_[val]) {
+      schedule_active(n);
+    }
+
+    // Drain evaluations and updates. Outputs aren't reported until we're done.
+    there_were_tasks_ = false;
+    drain_active();
+    while (!updates_.empty()) {
+      drain_updates();
+      drain_active();
+    }
+    tasks = there_were_tasks_;
+  }
+
+  for (auto& o : outputs_) {
+    interface()->write(o.second, &eval_.get_value(o.first));
+  }
+  return res;
+}
+
+SwLogic::CaseIndex::CaseIndex(SwLogic* sw) : Visitor() {
+  sw_ = sw;
+}
+
+void SwLogic::CaseIndex::visit(const CaseStatement* cs) {
+  auto& ct = sw_->cases_[cs];
+  ct.width = sw_->eval_.get_width(cs);
+  ct.type = sw_->eval_.get_type(cs);
+  ct.indexed = (ct.type != Bits::Type::REAL) && (ct.width <= 8*sizeof(CaseKey));
+  ct.base = 0;
+  ct.fallback = nullptr;
+
+  // Collect labels in order. Anything other than a number could change value
+  // at runtime, so its presence rules out an index.
+  vector<pair<CaseKey, const Statement*>> labels;
+  for (auto i = cs->begin_items(), ie = cs->end_items(); i != ie; ++i) {
+    if ((*i)->empty_exprs()) {
+      ct.fallback = (*i)->get_stmt();
+      continue;
+    }
+    for (auto j = (*i)->begin_exprs(), je = (*i)->end_exprs(); ct.indexed && (j != je); ++j) {
+      if ((*j)->is(Node::Tag::number)) {
+        labels.push_back(make_pair(sw_->case_key(ct, *j), (*i)->get_stmt()));
+      } else {
+        ct.indexed = false;
+      }
+    }
+  }
+
+  // Use a dense table if labels cover at least a quarter of their range. In
+  // either case, the first item that matches a value takes precedence.
+  if (ct.indexed && !labels.empty()) {
+    auto lo = labels[0].first;
+    auto hi = labels[0].first;
+    for (const auto& l : labels) {
+      lo = min(lo, l.first);
+      hi = max(hi, l.first);
+    }
+    if ((hi - lo) < 4*labels.size()) {
+      ct.base = lo;
+      ct.dense.resize(hi - lo + 1, nullptr);
+      for (const auto& l : labels) {
+        auto& s = ct.dense[l.first - lo];
+        if (s == nullptr) {
+          s = l.second;
+        }
+      }
+    } else {
+      for (const auto& l : labels) {
+        ct.sparse.insert(l);
+      }
+    }
+  }
+
+  // Descend on nested case statements
+  Visitor::visit(cs);
+}
+
 SwLogic::EofIndex::EofIndex(SwLogic* sw) : Visitor() {
   sw_ = sw;
 }
@@ -250,13 +360,178 @@ void SwLogic::EofIndex::visit(const FeofExpression* fe) {
   sw_->eofs_.push_back(fe);
 }
 
+SwLogic::FormatIndex::FormatIndex(SwLogic* sw) : Visitor() {
+  sw_ = sw;
+}
+
+void SwLogic::FormatIndex::visit(const GetStatement* gs) {
+  sw_->gets_.insert(make_pair(gs, Scanf(gs)));
+}
+
+void SwLogic::FormatIndex::visit(const PutStatement* ps) {
+  sw_->puts_.insert(make_pair(ps, Printf(ps)));
+}
+
+SwLogic::Levelize::Levelize(SwLogic* sw) : Visitor() {
+  sw_ = sw;
+  writer_ = nullptr;
+}
+
+size_t SwLogic::Levelize::run() {
+  // Collect every node that can appear in the active queue along with the
+  // dependencies between them. An edge from n to m means that evaluating n can
+  // cause m to be scheduled.
+  sw_->src_->accept(this);
+  for (const auto& e : edges_) {
+    get_index(e.second);
+  }
+  vector<vector<size_t>> succs(nodes_.size());
+  for (const auto& e : edges_) {
+    succs[get_index(e.first)].push_back(get_index(e.second));
+  }
+
+  // Collapse cycles using an iterative version of Tarjan's algorithm. Nodes
+  // which participate in combinational loops all share a single rank and are
+  // evaluated in whatever order they're scheduled.
+  const auto unvisited = nodes_.size();
+  vector<size_t> idx(nodes_.size(), unvisited);
+  vector<size_t> low(nodes_.size(), 0);
+  vector<size_t> scc(nodes_.size(), 0);
+  vector<bool> on_stack(nodes_.size(), false);
+  vector<size_t> stack;
+  vector<pair<size_t, size_t>> frames;
+  size_t next_idx = 0;
+  size_t num_sccs = 0;
+
+  for (size_t s = 0, se = nodes_.size(); s < se; ++s) {
+    if (idx[s] != unvisited) {
+      continue;
+    }
+    idx[s] = low[s] = next_idx++;
+    stack.push_back(s);
+    on_stack[s] = true;
+    frames.push_back(make_pair(s, 0));
+
+    while (!frames.empty()) {
+      const auto u = frames.back().first;
+      if (frames.back().second < succs[u].size()) {
+        const auto v = succs[u][frames.back().second++];
+        if (idx[v] == unvisited) {
+          idx[v] = low[v] = next_idx++;
+          stack.push_back(v);
+          on_stack[v] = true;
+          frames.push_back(make_pair(v, 0));
+        } else if (on_stack[v]) {
+          low[u] = min(low[u], idx[v]);
+        }
+        continue;
+      }
+      frames.pop_back();
+      if (!frames.empty()) {
+        const auto p = frames.back().first;
+        low[p] = min(low[p], low[u]);
+      }
+      if (low[u] == idx[u]) {
+        for (auto done = false; !done; ) {
+          const auto w = stack.back();
+          stack.pop_back();
+          on_stack[w] = false;
+          scc[w] = num_sccs;
+          done = (w == u);
+        }
+        ++num_sccs;
+      }
+    }
+  }
+
+  // Tarjan's algorithm discovers components in reverse topological order.
+  // Walk them front to back and assign each component the length of the
+  // longest path which leads to it.
+  vector<vector<size_t>> members(num_sccs);
+  for (size_t i = 0, ie = nodes_.size(); i < ie; ++i) {
+    members[scc[i]].push_back(i);
+  }
+  vector<size_t> rank(num_sccs, 0);
+  size_t num_ranks = 1;
+  for (size_t c = num_sccs; c > 0; --c) {
+    const auto r = rank[c-1];
+    num_ranks = max(num_ranks, r+1);
+    for (auto u : members[c-1]) {
+      const_cast<Node*>(nodes_[u])->set_val<2,30>(r);
+      for (auto v : succs[u]) {
+        if (scc[v] != c-1) {
+          rank[scc[v]] = max(rank[scc[v]], r+1);
+        }
+      }
+    }
+  }
+  return num_ranks;
+}
+
+size_t SwLogic::Levelize::get_index(const Node* n) {
+  const auto itr = index_.find(n);
+  if (itr != index_.end()) {
+    return itr->second;
+  }
+  const auto res = nodes_.size();
+  index_[n] = res;
+  nodes_.push_back(n);
+  return res;
+}
+
+void SwLogic::Levelize::add_writes(const Node* n, const Identifier* id) {
+  const auto* r = Resolve().get_resolution(id);
+  assert(r != nullptr);
+  for (auto* m : r->monitor_) {
+    edges_.push_back(make_pair(n, m));
+  }
+}
+
+void SwLogic::Levelize::visit(const Event* e) {
+  assert(e->get_parent()->is(Node::Tag::event_control));
+  assert(e->get_parent()->get_parent()->is(Node::Tag::timing_control_statement));
+  get_index(e);
+  edges_.push_back(make_pair(e, static_cast<const TimingControlStatement*>(e->get_parent()->get_parent())->get_stmt()));
+}
+
+void SwLogic::Levelize::visit(const ContinuousAssign* ca) {
+  get_index(ca);
+  add_writes(ca, ca->get_lhs());
+}
+
+void SwLogic::Levelize::visit(const TimingControlStatement* tcs) {
+  tcs->accept_ctrl(this);
+  get_index(tcs->get_stmt());
+
+  // Everything written by this statement is attributed to it, since this is
+  // the node that the events attached to its control schedule.
+  const auto* prev = writer_;
+  writer_ = tcs->get_stmt();
+  tcs->accept_stmt(this);
+  writer_ = prev;
+}
+
+void SwLogic::Levelize::visit(const BlockingAssign* ba) {
+  if (writer_ != nullptr) {
+    add_writes(writer_, ba->get_lhs());
+  }
+}
+
+void SwLogic::Levelize::visit(const GetStatement* gs) {
+  if ((writer_ != nullptr) && gs->is_non_null_var()) {
+    add_writes(writer_, gs->get_var());
+  }
+}
+
 void SwLogic::schedule_now(const Node* n) {
   n->accept(this);
 }
 
 void SwLogic::schedule_active(const Node* n) {
   if (!n->get_flag<1>()) {
-    active_.push_back(n);
+    const auto r = n->get_val<2,30>();
+    active_[r].push_back(n);
+    active_rank_ = min(active_rank_, static_cast<size_t>(r));
     const_cast<Node*>(n)->set_flag<1>(true);
   }
 }
@@ -264,6 +539,9 @@ void SwLogic::schedule_active(const Node* n) {
 void SwLogic::notify(const Node* n) {
   switch (n->get_tag()) {
     case Node::Tag::identifier:
+      if (tracking_) {
+        dirty_.insert(n);
+      }
       for (auto* m : static_cast<const Identifier*>(n)->monitor_) {
         schedule_active(m);
       }
@@ -283,18 +561,98 @@ void SwLogic::notify(const Node* n) {
   }
 }
 
-void SwLogic::silent_evaluate() {
-  // Turn on silent mode and drain the active queue
-  silent_ = true;
-  while (!active_.empty()) {
-    auto* e = active_.back();
-    active_.pop_back();
+void SwLogic::drain_active() {
+  // Active events are drained in rank order. In the absence of combinational
+  // loops, this guarantees that every node is evaluated at most once, since
+  // nothing that it depends on can be scheduled behind it. 
+  while (active_rank_ < active_.size()) {
+    auto& bucket = active_[active_rank_];
+    if (bucket.empty()) {
+      ++active_rank_;
+      continue;
+    }
+    auto* e = bucket.back();
+    bucket.pop_back();
     const_cast<Node*>(e)->set_flag<1>(false);
     schedule_now(e);
   }
+}
+
+void SwLogic::drain_updates() {
+  // This is a for loop. Updates happen simultaneously
+  for (size_t i = 0, ie = updates_.size(); i < ie; ++i) {
+    const auto& val = update_pool_[i];
+    if (eval_.assign_value(get<0>(updates_[i]), get<1>(updates_[i]), get<2>(updates_[i]), get<3>(updates_[i]), val)) {
+      notify(get<0>(updates_[i]));
+    }
+  }
+  updates_.clear();
+}
+
+void SwLogic::silent_evaluate() {
+  // Turn on silent mode and drain the active queue
+  silent_ = true;
+  drain_active();
   silent_ = false;
 }
 
+void SwLogic::init_open_loop(VId clk) {
+  open_loop_clk_ = clk;
+  open_loop_vals_[0] = Bits(false);
+  open_loop_vals_[1] = Bits(true);
+  open_loop_triggers_[0].clear();
+  open_loop_triggers_[1].clear();
+
+  // Sort the nodes which monitor the clock by the edges that trigger them.
+  // Events are replaced by the statements they guard. Anything else (ie
+  // continuous assigns which read the clock) is triggered on both edges.
+  const auto* id = inputs_[clk];
+  assert(id != nullptr);
+  for (auto* m : id->monitor_) {
+    if (!m->is(Node::Tag::event)) {
+      open_loop_triggers_[0].push_back(m);
+      open_loop_triggers_[1].push_back(m);
+      continue;
+    }
+    const auto* e = static_cast<const Event*>(m);
+    assert(e->get_parent()->is(Node::Tag::event_control));
+    assert(e->get_parent()->get_parent()->is(Node::Tag::timing_control_statement));
+    const auto* s = static_cast<const TimingControlStatement*>(e->get_parent()->get_parent())->get_stmt();
+    if (e->get_type() != Event::Type::POSEDGE) {
+      open_loop_triggers_[0].push_back(s);
+    }
+    if (e->get_type() != Event::Type::NEGEDGE) {
+      open_loop_triggers_[1].push_back(s);
+    }
+  }
+}
+
+Bits SwLogic::case_value(const CaseTable& ct, const Expression* e) {
+  auto res = eval_.get_value(e);
+  if (ct.type == Bits::Type::REAL) {
+    res.cast_type(ct.type);
+  } else {
+    res.reinterpret_type(ct.type);
+    res.resize(ct.width);
+  }
+  return res;
+}
+
+SwLogic::CaseKey SwLogic::case_key(const CaseTable& ct, const Expression* e) {
+  // This is case_value() without the copy. Sign extend if necessary, and then
+  // mask off anything above the comparison width.
+  const auto& v = eval_.get_value(e);
+  const auto n = v.size();
+  auto res = v.to_uint();
+  if ((ct.type == Bits::Type::SIGNED) && (n < ct.width) && v.get(n-1)) {
+    res |= (static_cast<CaseKey>(-1) << n);
+  }
+  if (ct.width < 8*sizeof(CaseKey)) {
+    res &= ((static_cast<CaseKey>(1) << ct.width) - 1);
+  }
+  return res;
+}
+
 interfacestream* SwLogic::get_stream(FId fd) {
   const auto itr = streams_.find(fd);
   if (itr != streams_.end()) {
@@ -369,19 +727,35 @@ void SwLogic::visit(const SeqBlock* sb) {
 }
 
 void SwLogic::visit(const CaseStatement* cs) {
-  const auto s = eval_.get_value(cs->get_cond()).to_uint();
-  for (auto i = cs->begin_items(), ie = cs->end_items(); i != ie; ++i) { 
-    for (auto j = (*i)->begin_exprs(), je = (*i)->end_exprs(); j != je; ++j) { 
-      const auto c = eval_.get_value(*j).to_uint();
-      if (s == c) {
-        schedule_now((*i)->get_stmt());
+  const auto& ct = cases_.find(cs)->second;
+  if (ct.indexed) {
+    const auto c = case_key(ct, cs->get_cond());
+    if (!ct.dense.empty()) {
+      const auto idx = c - ct.base;
+      if ((idx < ct.dense.size()) && (ct.dense[idx] != nullptr)) {
+        schedule_now(ct.dense[idx]);
+        return;
+      }
+    } else {
+      const auto itr = ct.sparse.find(c);
+      if (itr != ct.sparse.end()) {
+        schedule_now(itr->second);
         return;
       }
-    } 
-    if ((*i)->empty_exprs()) {
-      schedule_now((*i)->get_stmt());
-      return;
     }
+  } else {
+    const auto c = case_value(ct, cs->get_cond());
+    for (auto i = cs->begin_items(), ie = cs->end_items(); i != ie; ++i) { 
+      for (auto j = (*i)->begin_exprs(), je = (*i)->end_exprs(); j != je; ++j) { 
+        if (c.eq(case_value(ct, *j))) {
+          schedule_now((*i)->get_stmt());
+          return;
+        }
+      } 
+    }
+  }
+  if (ct.fallback != nullptr) {
+    schedule_now(ct.fallback);
   }
 }
 
@@ -439,7 +813,7 @@ void SwLogic::visit(const GetStatement* gs) {
   if (!silent_) {
     const auto fd = eval_.get_value(gs->get_fd()).to_uint();
     auto* is = get_stream(fd);
-    Scanf().read(*is, &eval_, gs);
+    gets_.find(gs)->second.read(*is, &eval_);
 
     if (gs->is_non_null_var()) {
       const auto* r = Resolve().get_resolution(gs->get_var());
@@ -454,7 +828,7 @@ void SwLogic::visit(const PutStatement* ps) {
   if (!silent_) {
     const auto fd = eval_.get_value(ps->get_fd()).to_uint();
     auto* is = get_stream(fd);
-    Printf().write(*is, &eval_, ps);
+    puts_.find(ps)->second.write(*is, &eval_);
     update_eofs();
   }
 }
@@ -34,9 +34,13 @@
 #include <string>
 #include <tuple>
 #include <unordered_map>
+#include <unordered_set>
+#include <utility>
 #include <vector>
 #include "common/bits.h"
 #include "target/core.h"
+#include "target/core/common/printf.h"
+#include "target/core/common/scanf.h"
 #include "verilog/analyze/evaluate.h"
 #include "verilog/ast/visitors/visitor.h"
 
@@ -69,7 +73,39 @@ class SwLogic : public Logic, public Visitor {
     void update() override;
     bool there_were_tasks() const override;
 
+    // Incremental State Interface:
+    bool overrides_state_tracking() const override;
+    void begin_state_tracking() override;
+    State* get_tracked_state() override;
+
+    // Optimized Scheduling Interface:
+    size_t open_loop(VId clk, bool val, size_t itr) override;
+
   private:
+    // Dispatch table for a case statement. Conditions and items are compared
+    // at a common width and type (see Evaluate::get_width(CaseStatement*)).
+    // If every item is a number and that width fits in a word, items are
+    // indexed by value, either densely (offset from base) or in a hash table.
+    // Otherwise, items are compared one at a time.
+    typedef decltype(std::declval<Bits>().to_uint()) CaseKey;
+    struct CaseTable {
+      size_t width;
+      Bits::Type type;
+      bool indexed;
+      CaseKey base;
+      std::vector<const Statement*> dense;
+      std::unordered_map<CaseKey, const Statement*> sparse;
+      const Statement* fallback;
+    };
+
+    class CaseIndex : public Visitor {
+      public:
+        CaseIndex(SwLogic* sw);
+        void visit(const CaseStatement* cs);
+      private:
+        SwLogic* sw_;
+    };
+
     class EofIndex : public Visitor {
       public:
         EofIndex(SwLogic* sw);
@@ -78,31 +114,81 @@ class SwLogic : public Logic, public Visitor {
         SwLogic* sw_;
     };
 
+    class FormatIndex : public Visitor {
+      public:
+        FormatIndex(SwLogic* sw);
+        void visit(const GetStatement* gs);
+        void visit(const PutStatement* ps);
+      private:
+        SwLogic* sw_;
+    };
+
+    class Levelize : public Visitor {
+      public:
+        Levelize(SwLogic* sw);
+        size_t run();
+      private:
+        SwLogic* sw_;
+        const Node* writer_;
+        std::unordered_map<const Node*, size_t> index_;
+        std::vector<const Node*> nodes_;
+        std::vector<std::pair<const Node*, const Node*>> edges_;
+
+        size_t get_index(const Node* n);
+        void add_writes(const Node* n, const Identifier* id);
+
+        void visit(const Event* e) override;
+        void visit(const ContinuousAssign* ca) override;
+        void visit(const TimingControlStatement* tcs) override;
+        void visit(const BlockingAssign* ba) override;
+        void visit(const GetStatement* gs) override;
+    };
+
     // Source Management:
     ModuleDeclaration* src_;
     std::vector<const Identifier*> inputs_;
     std::vector<std::pair<const Identifier*, VId>> outputs_;
     std::unordered_map<VId, const Identifier*> state_;
     std::vector<const FeofExpression*> eofs_;
+    std::unordered_map<const CaseStatement*, CaseTable> cases_;
+    std::unordered_map<const GetStatement*, Scanf> gets_;
+    std::unordered_map<const PutStatement*, Printf> puts_;
 
     // Control State:
     bool silent_;
     bool there_were_tasks_;
-    std::vector<const Node*> active_;
+    std::vector<std::vector<const Node*>> active_;
+    size_t active_rank_;
     std::vector<std::tuple<const Identifier*,size_t,int,int>> updates_;
     std::vector<Bits> update_pool_;
     Evaluate eval_;
     std::unordered_map<FId, interfacestream*> streams_;
 
+    // State Tracking:
+    bool tracking_;
+    std::unordered_set<const Node*> dirty_;
+
+    // Open Loop State:
+    VId open_loop_clk_;
+    Bits open_loop_vals_[2];
+    std::vector<const Node*> open_loop_triggers_[2];
+
     // Scheduling: 
     void schedule_now(const Node* n);
     void schedule_active(const Node* n);
     void notify(const Node* n);
+    void drain_active();
+    void drain_updates();
 
     // Finalize Helpers:
     void silent_evaluate();
 
+    // Open Loop Helpers:
+    void init_open_loop(VId clk);
+
     // Control Helpers:
+    Bits case_value(const CaseTable& ct, const Expression* e);
+    CaseKey case_key(const CaseTable& ct, const Expression* e);
     interfacestream* get_stream(FId fd);
     void update_eofs();
 
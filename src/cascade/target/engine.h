@@ -87,7 +87,17 @@ class Engine {
     void set_clock_val(bool t);
 
     // Compiler Interface:
-    void replace_with(Engine* e);
+    //
+    // Returns true if this engine's state can be migrated incrementally.
+    bool overrides_state_tracking() const;
+    // Returns a snapshot of this engine's state and begins tracking changes.
+    // The snapshot can be used to initialize a replacement engine in the
+    // background, before it's swapped in with replace_with(e, true).
+    State* begin_migration();
+    // Replaces this engine with e. If migrated is true, e is assumed to
+    // already contain the state returned by begin_migration(), and only
+    // elements which have changed since then are transferred.
+    void replace_with(Engine* e, bool migrated = false);
 
   private:
     Id id_;
@@ -228,9 +238,18 @@ inline void Engine::set_clock_val(bool v) {
   c->set_val(v);
 }
 
-inline void Engine::replace_with(Engine* e) {
+inline bool Engine::overrides_state_tracking() const {
+  return c_->overrides_state_tracking();
+}
+
+inline State* Engine::begin_migration() {
+  c_->begin_state_tracking();
+  return c_->get_state();
+}
+
+inline void Engine::replace_with(Engine* e, bool migrated) {
   // Move state and inputs from this engine into the new engine
-  const auto* s = c_->get_state();
+  const auto* s = migrated ? c_->get_tracked_state() : c_->get_state();
   e->c_->set_state(s);
   delete s;
   const auto* i = c_->get_input();
@@ -70,6 +70,11 @@ class Interface {
     virtual uint32_t sgetn(FId id, char* c, uint32_t n) = 0;
     virtual int32_t sputc(FId id, char c) = 0;
     virtual uint32_t sputn(FId id, const char* c, uint32_t n) = 0;
+
+    // This method must perform whatever target-specific logic is necessary to
+    // determine whether the runtime is waiting to regain control. Cores which
+    // run in open loop should poll it periodically.
+    virtual bool interrupt_pending() = 0;
 };
 
 } // namespace cascade
@@ -50,12 +50,14 @@ void State::read(istream& is, size_t base) {
     size_t type = 0;
     is >> type; 
 
+    auto& bs = state_[id];
+    bs.resize(arity, width, static_cast<Bits::Type>(type));
     for (size_t j = 0; j < arity; ++j) {
       Bits bits;
       bits.read(is, base);
       bits.resize(width);
       bits.reinterpret_type(static_cast<Bits::Type>(type));
-      state_[id].push_back(bits);
+      bs.set(j, bits);
     }
   }  
 }
@@ -63,10 +65,10 @@ void State::read(istream& is, size_t base) {
 void State::write(ostream& os, size_t base) const {
   os << state_.size() << endl;
   for (const auto& s : state_) {
-    os << "  " << s.first << " " << s.second.size() << " " << s.second[0].size() << " " << static_cast<size_t>(s.second[0].get_type()) << endl;
-    for (const auto& b : s.second) {
+    os << "  " << s.first << " " << s.second.size() << " " << s.second.width() << " " << static_cast<size_t>(s.second.get_type()) << endl;
+    for (size_t i = 0, ie = s.second.size(); i < ie; ++i) {
       os << "    ";
-      b.write(os, base);
+      s.second.get(i).write(os, base);
       os << endl;
     }
   }
@@ -80,21 +82,12 @@ size_t State::deserialize(istream& is) {
   is.read(reinterpret_cast<char*>(&n), 4);
   size_t res = 4;
 
-  // Read that many id / bit pairs
+  // Read that many id / array pairs
   for (size_t i = 0; i < n; ++i) {
     VId id; 
     is.read(reinterpret_cast<char*>(&id), 4);
     res += 4;
-
-    uint32_t arity = 0;
-    is.read(reinterpret_cast<char*>(&arity), 4);
-    res += 4;
-
-    for (size_t j = 0; j < arity; ++j) {
-      Bits bits;
-      res += bits.deserialize(is);
-      state_[id].push_back(bits);
-    }
+    res += state_[id].deserialize(is);
   }
   return res;
 }
@@ -105,18 +98,11 @@ size_t State::serialize(ostream& os) const {
   os.write(reinterpret_cast<char*>(&n), 4);
   size_t res = 4;
 
-  // Write that many id / bit pairs
+  // Write that many id / array pairs
   for (const auto& s : state_) {
     os.write(const_cast<char*>(reinterpret_cast<const char*>(&s.first)), 4);
     res += 4;
-    
-    uint32_t arity = s.second.size();
-    os.write(reinterpret_cast<char*>(&arity), 4);
-    res += 4; 
-           
-    for (const auto& b : s.second) {
-      res += b.serialize(os);
-    }
+    res += s.second.serialize(os);
   }
   return res;
 }
@@ -33,8 +33,8 @@
 
 #include <unordered_map>
 #include "common/bits.h"
+#include "common/bits_array.h"
 #include "common/serializable.h"
-#include "common/vector.h"
 #include "runtime/ids.h"
 
 namespace cascade {
@@ -45,13 +45,13 @@ namespace cascade {
 
 class State : public Serializable {
   public:
-    typedef std::unordered_map<VId, Vector<Bits>>::const_iterator const_iterator;
+    typedef std::unordered_map<VId, BitsArray>::const_iterator const_iterator;
 
     State() = default;
     ~State() override = default;
 
     void insert(VId id, const Bits& b);
-    void insert(VId id, const Vector<Bits>& bs);
+    void insert(VId id, const BitsArray& bs);
 
     const_iterator find(VId id) const;
     const_iterator begin() const;
@@ -63,16 +63,14 @@ class State : public Serializable {
     size_t serialize(std::ostream& os) const override;
 
   private:
-    std::unordered_map<VId, Vector<Bits>> state_; 
+    std::unordered_map<VId, BitsArray> state_; 
 };
 
 inline void State::insert(VId id, const Bits& b) {
-  Vector<Bits> bs;
-  bs.push_back(b);
-  state_.insert(std::make_pair(id, bs));
+  state_.insert(std::make_pair(id, BitsArray(b)));
 }
 
-inline void State::insert(VId id, const Vector<Bits>& bs) {
+inline void State::insert(VId id, const BitsArray& bs) {
   state_.insert(std::make_pair(id, bs));
 }
 
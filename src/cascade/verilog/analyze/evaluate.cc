@@ -98,6 +98,31 @@ Bits::Type Evaluate::get_type(const Expression* e) {
   return e->bit_val_[0].get_type();
 }
 
+size_t Evaluate::get_width(const CaseStatement* cs) {
+  auto res = get_width(cs->get_cond());
+  for (auto i = cs->begin_items(), ie = cs->end_items(); i != ie; ++i) {
+    for (auto j = (*i)->begin_exprs(), je = (*i)->end_exprs(); j != je; ++j) {
+      res = max(res, get_width(*j));
+    }
+  }
+  return res;
+}
+
+Bits::Type Evaluate::get_type(const CaseStatement* cs) {
+  auto res = get_type(cs->get_cond());
+  for (auto i = cs->begin_items(), ie = cs->end_items(); i != ie; ++i) {
+    for (auto j = (*i)->begin_exprs(), je = (*i)->end_exprs(); j != je; ++j) {
+      const auto t = get_type(*j);
+      if ((t == Bits::Type::REAL) || (res == Bits::Type::REAL)) {
+        res = Bits::Type::REAL;
+      } else if (t == Bits::Type::UNSIGNED) {
+        res = Bits::Type::UNSIGNED;
+      }
+    }
+  }
+  return res;
+}
+
 const Bits& Evaluate::get_value(const Expression* e) {
   if (e->bit_val_.empty()) {
     init(const_cast<Expression*>(e));
@@ -109,7 +134,7 @@ const Bits& Evaluate::get_value(const Expression* e) {
   return e->bit_val_[0];
 }
 
-const Vector<Bits>& Evaluate::get_array_value(const Identifier* i) {
+const BitsArray& Evaluate::get_array_value(const Identifier* i) {
   if (i->bit_val_.empty()) {
     init(const_cast<Identifier*>(i));
   }
@@ -117,7 +142,17 @@ const Vector<Bits>& Evaluate::get_array_value(const Identifier* i) {
     const_cast<Identifier*>(i)->accept(this);
     const_cast<Identifier*>(i)->set_flag<0>(false);
   }
-  return i->bit_val_;
+  // Scalars are stored inline. This method is never invoked along the critical
+  // path, so it's fine to copy their value into a single element array here.
+  if (i->empty_dim()) {
+    const auto* p = i->get_parent();
+    assert((p != nullptr) && p->is_subclass_of(Node::Tag::declaration));
+    if (get_array(i) == nullptr) {
+      init_array(const_cast<Declaration*>(static_cast<const Declaration*>(p)), 1, i->bit_val_[0].size(), i->bit_val_[0].get_type());
+    }
+    get_array(i)->set(0, i->bit_val_[0]);
+  }
+  return *get_array(i);
 }
 
 pair<size_t, size_t> Evaluate::get_range(const Expression* e) {
@@ -159,39 +194,12 @@ bool Evaluate::assign_value(const Identifier* id, const Bits& val) {
     init(const_cast<Identifier*>(r));
   }
 
-  // Calculate its index
+  // Calculate its index and perform the assignment
   const auto dres = dereference(r, id);
-  const auto idx = static_cast<size_t>(get<0>(dres));
-
-  // Corner Case: Ignore writes to out of range indices
-  if (idx >= r->bit_val_.size()) {
-    return false;
-  }
-  // Simple Case: Full Assignment
-  if (get<1>(dres) == -1) {
-    if (!r->bit_val_[idx].eq(val)) {
-      const_cast<Identifier*>(r)->bit_val_[idx].assign(val);
-      flag_changed(r);
-      return true;
-    }
-    return false;
-  } 
-  // Corner Case: Ignore writes to bit ranges which are entirely out of range
-  if (static_cast<size_t>(get<2>(dres)) >= get_width(r)) {
-    return false;
-  }
-  // Partial Case: Write as much as possible to a partially valid range
-  const auto msb = min(static_cast<size_t>(get<1>(dres)), get_width(r)-1);
-  const auto lsb = min(static_cast<size_t>(get<2>(dres)), get_width(r)-1);
-  if (!r->bit_val_[idx].eq(msb, lsb, val)) {
-    const_cast<Identifier*>(r)->bit_val_[idx].assign(msb, lsb, val);
-    flag_changed(r);
-    return true;
-  }
-  return false;
+  return assign_value(r, get<0>(dres), get<1>(dres), get<2>(dres), val);
 }
 
-void Evaluate::assign_array_value(const Identifier* id, const Vector<Bits>& val) {
+void Evaluate::assign_array_value(const Identifier* id, const BitsArray& val) {
   if (id->bit_val_.empty()) {
     init(const_cast<Identifier*>(id));
   }
@@ -205,9 +213,19 @@ void Evaluate::assign_array_value(const Identifier* id, const Vector<Bits>& val)
 
   // Perform the assignment. This method is never invoked along the critical
   // path. There's no need to short-circuit after performing an equality check.
-  assert(val.size() == r->bit_val_.size());
-  for (size_t i = 0, ie = r->bit_val_.size(); i < ie; ++i) {
-    const_cast<Identifier*>(r)->bit_val_[i].assign(val[i]);
+  if (r->empty_dim()) {
+    assert(val.size() == 1);
+    val.get(0, const_cast<Identifier*>(r)->bit_val_[0]);
+  } else {
+    auto* a = get_array(r);
+    assert(val.size() == a->size());
+    if ((val.width() == a->width()) && (val.get_type() == a->get_type())) {
+      *a = val;
+    } else {
+      for (size_t i = 0, ie = a->size(); i < ie; ++i) {
+        a->set(i, val.get(i));
+      }
+    }
   }
   flag_changed(r);
 }
@@ -233,7 +251,7 @@ tuple<size_t,int,int> Evaluate::dereference(const Identifier* r, const Identifie
   if (r->bit_val_.empty()) {
     init(const_cast<Identifier*>(r));
   }
-  size_t mul = r->bit_val_.size();
+  size_t mul = get_array(r)->size();
 
   // Walk along subscripts 
   for (auto re = r->end_dim(); ritr != re; ++iitr, ++ritr) {
@@ -257,14 +275,22 @@ bool Evaluate::assign_value(const Identifier* id, size_t idx, int msb, int lsb,
     init(const_cast<Identifier*>(id));
   }
 
+  // Arrays are stored in packed form, scalars are stored inline
+  auto* a = id->empty_dim() ? nullptr : get_array(id);
+
   // Corner Case: Ignore writes to out of bounds indices
-  if (idx >= id->bit_val_.size()) {
+  if (idx >= ((a == nullptr) ? 1 : a->size())) {
     return false;
   }
   // Fast Path: Single bit assignments are easy to check
   if (msb == -1) {
-    if (!id->bit_val_[idx].eq(val)) {
-      const_cast<Identifier*>(id)->bit_val_[idx].assign(val);
+    if (a != nullptr) {
+      if (a->set(idx, val)) {
+        flag_changed(id);
+        return true;
+      }
+    } else if (!id->bit_val_[0].eq(val)) {
+      const_cast<Identifier*>(id)->bit_val_[0].assign(val);
       flag_changed(id);
       return true;
     }
@@ -277,14 +303,27 @@ bool Evaluate::assign_value(const Identifier* id, size_t idx, int msb, int lsb,
   // Partial Case: Perform as much of the assignment as possible
   const auto m = min(static_cast<size_t>(msb), get_width(id)-1);
   const auto l = min(static_cast<size_t>(lsb), get_width(id)-1);
-  if (!id->bit_val_[idx].eq(m, l, val)) {
-    const_cast<Identifier*>(id)->bit_val_[idx].assign(m, l, val);
+  if (a != nullptr) {
+    if (a->set(idx, m, l, val)) {
+      flag_changed(id);
+      return true;
+    }
+  } else if (!id->bit_val_[0].eq(m, l, val)) {
+    const_cast<Identifier*>(id)->bit_val_[0].assign(m, l, val);
     flag_changed(id);
     return true;
   }
   return false;
 }
 
+void Evaluate::init_array(Declaration* d, size_t arity, size_t w, Bits::Type t) {
+  if (d->array_val_ == nullptr) {
+    d->array_val_ = new BitsArray(arity, w, t);
+  } else {
+    d->array_val_->resize(arity, w, t);
+  }
+}
+
 void Evaluate::flag_changed(const Identifier* id) {
   for (auto i = Resolve().use_begin(id), ie = Resolve().use_end(id); i != ie; ++i) {
     const_cast<Expression*>(*i)->set_flag<0>(true);
@@ -429,19 +468,31 @@ void Evaluate::edit(Identifier* id) {
   const auto dres = dereference(r, id);
   const auto idx = static_cast<size_t>(get<0>(dres));
 
+  // Scalars are stored inline, arrays are stored in packed form
+  const auto& val = get_value(r);
+  const auto* a = r->empty_dim() ? nullptr : get_array(r);
+
   // Corner Case: Ignore reads from out of bounds indices
-  if (idx >= get_array_value(r).size()) {
+  if (idx >= ((a == nullptr) ? 1 : a->size())) {
     return;
   }
   // Simple Case: Full value assignment
   else if (get<1>(dres) == -1) {
-    id->bit_val_[0].assign(get_array_value(r)[idx]);
+    if (a != nullptr) {
+      a->get(idx, id->bit_val_[0]);
+    } else {
+      id->bit_val_[0].assign(val);
+    }
   } 
   // Partial Case: Ignore reads from bit ranges which are out of bounds
   else {
     const auto msb = min(static_cast<size_t>(get<1>(dres)), get_width(r)-1);
     const auto lsb = min(static_cast<size_t>(get<2>(dres)), get_width(r)-1);
-    id->bit_val_[0].assign(get_array_value(r)[idx], msb, lsb);
+    if (a != nullptr) {
+      a->get(idx, msb, lsb, id->bit_val_[0]);
+    } else {
+      id->bit_val_[0].assign(val, msb, lsb);
+    }
   }
 }
 
@@ -871,15 +922,16 @@ void Evaluate::SelfDetermine::edit(NetDeclaration* nd) {
     const auto rng = eval_->get_range(nd->get_dim());
     w = (rng.first-rng.second)+1;
   }
-  // Allocate bits
-  nd->get_id()->bit_val_.resize(arity);
-  for (size_t i = 0; i < arity; ++i) {
-    nd->get_id()->bit_val_[i].resize(w);
-    if (nd->get_type() == Declaration::Type::UNTYPED) {
-      nd->get_id()->bit_val_[i].reinterpret_type(Bits::Type::UNSIGNED);
-    } else {
-      nd->get_id()->bit_val_[i].reinterpret_type(static_cast<Bits::Type>(nd->get_type()));
-    }
+  // Allocate bits. Arrays are stored separately; the identifier only records
+  // the width and type of their elements.
+  const auto t = (nd->get_type() == Declaration::Type::UNTYPED) ? 
+    Bits::Type::UNSIGNED : 
+    static_cast<Bits::Type>(nd->get_type());
+  nd->get_id()->bit_val_.resize(1);
+  nd->get_id()->bit_val_[0].resize(w);
+  nd->get_id()->bit_val_[0].reinterpret_type(t);
+  if (!nd->get_id()->empty_dim() || (nd->array_val_ != nullptr)) {
+    eval_->init_array(nd, arity, w, t);
   }
 
   // TODO(eschkufz) For whatever reason, we've chosen to materialize net
@@ -909,15 +961,16 @@ void Evaluate::SelfDetermine::edit(RegDeclaration* rd) {
     const auto rng = eval_->get_range(rd->get_dim());
     w = (rng.first-rng.second)+1;
   }
-  // Allocate bits:
-  rd->get_id()->bit_val_.resize(arity);
-  for (size_t i = 0; i < arity; ++i) {
-    rd->get_id()->bit_val_[i].resize(w);
-    if (rd->get_type() == Declaration::Type::UNTYPED) {
-      rd->get_id()->bit_val_[i].reinterpret_type(Bits::Type::UNSIGNED);
-    } else {
-      rd->get_id()->bit_val_[i].reinterpret_type(static_cast<Bits::Type>(rd->get_type()));
-    }
+  // Allocate bits. Arrays are stored separately; the identifier only records
+  // the width and type of their elements.
+  const auto t = (rd->get_type() == Declaration::Type::UNTYPED) ? 
+    Bits::Type::UNSIGNED : 
+    static_cast<Bits::Type>(rd->get_type());
+  rd->get_id()->bit_val_.resize(1);
+  rd->get_id()->bit_val_[0].resize(w);
+  rd->get_id()->bit_val_[0].reinterpret_type(t);
+  if (!rd->get_id()->empty_dim() || (rd->array_val_ != nullptr)) {
+    eval_->init_array(rd, arity, w, t);
   }
 
   // Hold off on initial assignment here. We may be doing some size extending
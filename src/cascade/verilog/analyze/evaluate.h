@@ -37,6 +37,7 @@
 #include <utility>
 #include <vector>
 #include "common/bits.h"
+#include "common/bits_array.h"
 #include "common/vector.h"
 #include "verilog/analyze/resolve.h"
 #include "verilog/ast/ast.h"
@@ -49,16 +50,17 @@ namespace cascade {
 // (see resolve.h) to function correctly.
 
 // Internally, this class relies on the fact that AST expressions are decorated
-// with Bits arrays. In practice, most expressions will only have a single
-// element in that array. The only exception are identifiers which are nested
-// within declarations. Verilog does not allow array slicing, so wherever else
-// an identifier appears, it either refers to a scalar, or a scalar element of
-// an array.
+// with Bits. The only exception are declarations of arrays, which are
+// decorated with a packed BitsArray (see bits_array.h). The identifier nested
+// within such a declaration still carries a single Bits which describes the
+// width and type of its elements. Verilog does not allow array slicing, so
+// wherever else an identifier appears, it either refers to a scalar, or a
+// scalar element of an array.
 
-// While verilog allows multidimensional arrays, expressions are decorated with
-// single dimensional arrays. The mapping is standard: elements are stored in
-// lexicographically ascending order. The array r[1:0][1:0] would be linearized
-// as follows: r[0][0] r[0][1] r[1][0] r[1][1].
+// While verilog allows multidimensional arrays, declarations are decorated
+// with single dimensional arrays. The mapping is standard: elements are stored
+// in lexicographically ascending order. The array r[1:0][1:0] would be
+// linearized as follows: r[0][0] r[0][1] r[1][0] r[1][1].
 
 class Evaluate : public Editor {
   public:
@@ -91,13 +93,20 @@ class Evaluate : public Editor {
     // Returns the underlying type of an expression. Returns the same for
     // scalars and arrays.
     Bits::Type get_type(const Expression* e);
+    // Returns the bit-width at which the condition of a case statement is
+    // compared against its items: the widest of all of these expressions.
+    size_t get_width(const CaseStatement* cs);
+    // Returns the type at which the condition of a case statement is compared
+    // against its items: real if any of these expressions is real, signed if
+    // all of them are signed, and unsigned otherwise.
+    Bits::Type get_type(const CaseStatement* cs);
 
     // Returns the bit value of an expression. Invoking this method on an expression
     // which evaluates to an array returns the first element of that array.
     const Bits& get_value(const Expression* e);
     // Returns the array value of an identifier. Invoking this method on an identifier
     // which evaluates to a scalar returns a single element array.
-    const Vector<Bits>& get_array_value(const Identifier* i);
+    const BitsArray& get_array_value(const Identifier* i);
     // Returns upper and lower values for ranges, get_value() twice otherwise.
     std::pair<size_t, size_t> get_range(const Expression* e);
 
@@ -108,7 +117,7 @@ class Evaluate : public Editor {
     // High-level interface: Resolves id and sets the value of its target to
     // val. Invoking this method on an unresolvable id or one which refers to
     // an array subscript is undefined.
-    void assign_array_value(const Identifier* id, const Vector<Bits>& val);
+    void assign_array_value(const Identifier* id, const BitsArray& val);
 
     // Low-level interface: Returns an index into r's underlying array, as well
     // as bit range, based on the expressions in i's dimensions. This method is
@@ -161,6 +170,11 @@ class Evaluate : public Editor {
     // Initializes the bit value associated with an identifier using the rules
     // of self- and context- determination to determine bit-width and sign.
     void init(Expression* e);
+    // Returns the packed storage associated with the declaration of r, or
+    // nullptr if r is a scalar or hasn't been initialized.
+    static BitsArray* get_array(const Identifier* r);
+    // Allocates storage for the variable declared by d.
+    static void init_array(Declaration* d, size_t arity, size_t w, Bits::Type t);
 
     // Invalidates bit, size, and type info for the expressions in this subtree
     struct Invalidate : Editor {
@@ -233,11 +247,23 @@ inline void Evaluate::assign_word(const Identifier* id, size_t idx, size_t n, B
   if (id->bit_val_.empty()) {      
     init(const_cast<Identifier*>(id));
   }
-  assert(idx < id->bit_val_.size());
-  const_cast<Identifier*>(id)->bit_val_[idx].write_word<B>(n, b);
+  if (id->empty_dim()) {
+    assert(idx == 0);
+    const_cast<Identifier*>(id)->bit_val_[0].write_word<B>(n, b);
+  } else {
+    get_array(id)->write_word<B>(idx, n, b);
+  }
   flag_changed(id);
 }
 
+inline BitsArray* Evaluate::get_array(const Identifier* r) {
+  const auto* p = r->get_parent();
+  if ((p == nullptr) || !p->is_subclass_of(Node::Tag::declaration)) {
+    return nullptr;
+  }
+  return static_cast<const Declaration*>(p)->array_val_;
+}
+
 } // namespace cascade
 
 #endif
@@ -31,6 +31,7 @@
 #ifndef CASCADE_SRC_VERILOG_AST_DECLARATION_H
 #define CASCADE_SRC_VERILOG_AST_DECLARATION_H
 
+#include "common/bits_array.h"
 #include "common/vector.h"
 #include "verilog/ast/types/attributes.h"
 #include "verilog/ast/types/expression.h"
@@ -76,16 +77,22 @@ class Declaration : public ModuleItem {
 
     friend class Resolve;
     DECORATION(Vector<const Expression*>*, uses);
+    friend class Evaluate;
+    DECORATION(BitsArray*, array_val);
 };
 
 inline Declaration::Declaration(Node::Tag tag) : ModuleItem(tag) { 
   uses_ = nullptr;
+  array_val_ = nullptr;
 }
 
 inline Declaration::~Declaration() {
   if (uses_ != nullptr) {
     delete uses_;
   }
+  if (array_val_ != nullptr) {
+    delete array_val_;
+  }
 }
 
 } // namespace cascade 
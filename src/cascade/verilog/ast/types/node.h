@@ -165,6 +165,7 @@ class Node {
     DECORATION(uint32_t, common);
     // common_[0]    Evaluate: needs_update_
     // common_[1]    SwLogic:  active_
+    // common_[2-31] SwLogic:  rank_ (schedulable non-Number nodes only)
     // common_[2-4]  Number:   format_
     // common_[5]    Number:   signed_
     // common_[6-31] Number:   size_
@@ -1648,6 +1648,15 @@ system_task_enable
     $$ = new GetStatement($3, new String("%u"), $5);
     parser->set_loc($$);
   }
+  | SYS_FREAD OPAREN expression COMMA identifier COMMA expression COMMA expression CPAREN SCOLON {
+    if (!$5->empty_dim()) {
+      error(parser->get_loc(), "Found incorrectly formatted $fread() statement!");
+      YYERROR;
+    }
+    $5->push_back_dim(new RangeExpression($7, RangeExpression::Type::PLUS, $9));
+    $$ = new GetStatement($3, new String("%u"), $5);
+    parser->set_loc($$);
+  }
   | SYS_FSCANF OPAREN expression COMMA expression_P CPAREN SCOLON {
     auto* sb = desugar_io(true, $3, $5.begin(), $5.end());
     if (sb == nullptr) {
@@ -1666,13 +1675,20 @@ system_task_enable
     parser->set_loc($$);
   }
   | SYS_FWRITE OPAREN expression COMMA expression_P CPAREN SCOLON { 
-    auto* fd = $3->clone();
-    auto* sb = desugar_io(false, $3, $5.begin(), $5.end()); 
-    if (sb == nullptr) {
-      error(parser->get_loc(), "Found incorrectly formatted $fwrite() statement!");
-      YYERROR;
+    // Bulk transfers: $fwrite(fd, mem, start, count)
+    if (($5.size() == 3) && $5[0]->is(Node::Tag::identifier) && static_cast<Identifier*>($5[0])->empty_dim()) {
+      auto* id = static_cast<Identifier*>($5[0]);
+      id->push_back_dim(new RangeExpression($5[1], RangeExpression::Type::PLUS, $5[2]));
+      $$ = new PutStatement($3, new String("%u"), id);
+    } else {
+      auto* fd = $3->clone();
+      auto* sb = desugar_io(false, $3, $5.begin(), $5.end()); 
+      if (sb == nullptr) {
+        error(parser->get_loc(), "Found incorrectly formatted $fwrite() statement!");
+        YYERROR;
+      }
+      $$ = sb;
     }
-    $$ = sb;
     parser->set_loc($$);
   }
   | SYS_GET OPAREN expression COMMA string_ CPAREN SCOLON {
@@ -31,6 +31,7 @@
 #include "verilog/program/elaborate.h"
 
 #include <cassert>
+#include <sstream>
 #include <unordered_map>
 #include "common/bits.h"
 #include "verilog/analyze/evaluate.h"
@@ -144,6 +145,36 @@ Vector<GenerateBlock*>& Elaborate::elaborate(LoopGenerateConstruct* lgc) {
   return lgc->gen_;
 }
 
+string Elaborate::get_memo_key(const ModuleInstantiation* mi) {
+  stringstream ss;
+  ss << mi->get_mid()->front_ids()->get_readable_sid();
+  for (auto i = mi->begin_params(), ie = mi->end_params(); i != ie; ++i) {
+    ss << " ";
+    if ((*i)->is_non_null_exp()) {
+      ss << (*i)->get_exp()->front_ids()->get_readable_sid();
+    }
+    const auto& v = Evaluate().get_value((*i)->get_imp());
+    ss << ":" << v.size() << (v.is_signed() ? "s" : "u") << (v.is_real() ? "r" : "") << ":";
+    v.write(ss, 16);
+  }
+  return ss.str();
+}
+
+ModuleDeclaration* Elaborate::clone_elaboration(const ModuleDeclaration* md) {
+  auto* res = md->clone();
+  clone_elaborations(md, res);
+  return res;
+}
+
+ModuleDeclaration* Elaborate::elaborate(ModuleInstantiation* mi, const ModuleDeclaration* memo) {
+  if (mi->inst_ != nullptr) {
+    return mi->inst_;
+  }
+  mi->inst_ = clone_elaboration(memo);
+  mi->inst_->parent_ = mi;
+  return mi->inst_;
+}
+
 bool Elaborate::is_elaborated(const ModuleInstantiation* mi) {
   return mi->inst_ != nullptr;
 }
@@ -256,6 +287,38 @@ void Elaborate::elaborate(ConditionalGenerateConstruct* cgc, GenerateBlock* b) {
   b->replace_id(get_name(cgc));
 }
 
+void Elaborate::clone_elaborations(const Node* src, Node* dst) {
+  // Clones are structurally identical, so their generate constructs appear
+  // in the same order.
+  Generates sgs;
+  src->accept(&sgs);
+  Generates dgs;
+  dst->accept(&dgs);
+  assert(sgs.gcs_.size() == dgs.gcs_.size());
+
+  for (size_t i = 0, ie = sgs.gcs_.size(); i < ie; ++i) {
+    if (sgs.gcs_[i]->is(Node::Tag::loop_generate_construct)) {
+      const auto* s = static_cast<const LoopGenerateConstruct*>(sgs.gcs_[i]);
+      auto* d = const_cast<LoopGenerateConstruct*>(static_cast<const LoopGenerateConstruct*>(dgs.gcs_[i]));
+      for (auto* b : s->gen_) {
+        auto* c = b->clone();
+        c->parent_ = d;
+        d->gen_.push_back(c);
+        clone_elaborations(b, c);
+      }
+    } else {
+      const auto* s = static_cast<const ConditionalGenerateConstruct*>(sgs.gcs_[i]);
+      auto* d = const_cast<ConditionalGenerateConstruct*>(static_cast<const ConditionalGenerateConstruct*>(dgs.gcs_[i]));
+      if (s->gen_ != nullptr) {
+        auto* c = s->gen_->clone();
+        c->parent_ = d;
+        d->gen_ = c;
+        clone_elaborations(s->gen_, c);
+      }
+    }
+  }
+}
+
 Identifier* Elaborate::get_name(GenerateConstruct* gc) {
   // Automatically generated genblk ids begin with genblk1
   next_name_ = 1;
@@ -300,4 +363,16 @@ void Elaborate::visit(const LoopGenerateConstruct* lgc) {
   }
 }
 
+void Elaborate::Generates::visit(const CaseGenerateConstruct* cgc) {
+  gcs_.push_back(cgc);
+}
+
+void Elaborate::Generates::visit(const IfGenerateConstruct* igc) {
+  gcs_.push_back(igc);
+}
+
+void Elaborate::Generates::visit(const LoopGenerateConstruct* lgc) {
+  gcs_.push_back(lgc);
+}
+
 } // namespace cascade
@@ -32,6 +32,8 @@
 #define CASCADE_SRC_VERILOG_PROGRAM_ELABORATE_H
 
 #include <stddef.h>
+#include <string>
+#include <vector>
 #include "common/vector.h"
 #include "verilog/ast/visitors/visitor.h"
 
@@ -51,6 +53,19 @@ class Elaborate : public Visitor {
     GenerateBlock* elaborate(IfGenerateConstruct* igc);
     Vector<GenerateBlock*>& elaborate(LoopGenerateConstruct* lgc);
 
+    // Memoization Interface:
+    //
+    // Returns a key which identifies the declaration and resolved parameter
+    // values that elaborating mi would combine. Instantiations with equal keys
+    // elaborate to identical bodies.
+    std::string get_memo_key(const ModuleInstantiation* mi);
+    // Returns a copy of an elaborated module, including the contents of its
+    // elaborated generate constructs, but not of its nested instantiations.
+    ModuleDeclaration* clone_elaboration(const ModuleDeclaration* md);
+    // Elaborates mi by copying memo, which is assumed to be the result of
+    // calling clone_elaboration() on an instantiation with the same key.
+    ModuleDeclaration* elaborate(ModuleInstantiation* mi, const ModuleDeclaration* memo);
+
     // Query Interface:
     bool is_elaborated(const ModuleInstantiation* mi);
     bool is_elaborated(const CaseGenerateConstruct* cgc);
@@ -68,6 +83,17 @@ class Elaborate : public Visitor {
     const Vector<GenerateBlock*>& get_elaboration(const LoopGenerateConstruct* lgc);
 
   private:
+    // Collects the outermost generate constructs below a node:
+    class Generates : public Visitor {
+      public:
+        ~Generates() override = default;
+        std::vector<const GenerateConstruct*> gcs_;
+      private:
+        void visit(const CaseGenerateConstruct* cgc) override;
+        void visit(const IfGenerateConstruct* igc) override;
+        void visit(const LoopGenerateConstruct* lgc) override;
+    };
+
     // Program Access:
     const Program* program_;
 
@@ -80,6 +106,7 @@ class Elaborate : public Visitor {
     void named_params(ModuleInstantiation* mi);
     void ordered_params(ModuleInstantiation* mi);
     void elaborate(ConditionalGenerateConstruct* cgc, GenerateBlock* b);
+    void clone_elaborations(const Node* src, Node* dst);
 
     // Visitor Interface:
     void visit(const CaseGenerateConstruct* cgc) override;
@@ -0,0 +1,196 @@
+// Copyright 2017-2019 VMware, Inc.
+// SPDX-License-Identifier: BSD-2-Clause
+//
+// The BSD-2 license (the License) set forth below applies to all parts of the
+// Cascade project.  You may not use this file except in compliance with the
+// License.
+//
+// BSD-2 License
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this
+// list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+// this list of conditions and the following disclaimer in the documentation
+// and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS AS IS AND
+// ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "verilog/program/partition.h"
+
+#include <algorithm>
+#include <cassert>
+#include <tuple>
+#include "verilog/analyze/module_info.h"
+#include "verilog/ast/ast.h"
+#include "verilog/program/elaborate.h"
+#include "verilog/program/inline.h"
+
+using namespace std;
+
+namespace cascade {
+
+Partition::Partition() : Editor() { }
+
+void Partition::partition(ModuleDeclaration* md, size_t k) {
+  // Nothing to do if we've only been asked for a single engine
+  if (k < 2) {
+    return;
+  }
+
+  // Collect instantiations. Anything which is already inlined stays that way,
+  // and anything which was previously outlined counts against k. 
+  insts_.clear();
+  md->accept(this);
+
+  ModuleInfo info(md);
+  vector<size_t> loads;
+  vector<tuple<size_t, size_t, ModuleDeclaration*>> cands;
+  for (auto* mi : insts_) {
+    if (Inline().is_inlined(mi)) {
+      continue;
+    }
+    assert(Elaborate().is_elaborated(mi));
+    auto* src = Elaborate().get_elaboration(mi);
+    const auto itr = info.connections().find(mi->get_iid());
+    const auto cut = (itr == info.connections().end()) ? 0 : 2 * itr->second.size();
+    if (is_partition(src)) {
+      loads.push_back(Weigh().weigh(src) + cut);
+    } else if (Inline().can_inline(src)) {
+      cands.push_back(make_tuple(Weigh().weigh(src), cut, src));
+    }
+  }
+  sort(cands.begin(), cands.end(), [](const auto& a, const auto& b) {
+    return get<0>(a) > get<0>(b);
+  });
+
+  // Outline candidates for as long as doing so reduces the peak load. The
+  // weight of the root includes every candidate, since they would otherwise
+  // be inlined into it.
+  auto root = Weigh().weigh(md);
+  for (const auto& c : cands) {
+    if (loads.size() + 1 >= k) {
+      break;
+    }
+    const auto w = get<0>(c);
+    const auto cut = get<1>(c);
+    const auto peak = max(root, loads.empty() ? 0 : *max_element(loads.begin(), loads.end()));
+    if ((w + cut >= peak) || (root - w + cut >= peak)) {
+      continue;
+    }
+    root = root - w + cut;
+    loads.push_back(w + cut);
+
+    auto* src = get<2>(c);
+    src->get_attrs()->set_or_replace("__no_inline", new String("true"));
+    src->get_attrs()->set_or_replace("__partition", new String("true"));
+  }
+}
+
+bool Partition::is_partition(const ModuleDeclaration* md) const {
+  return md->get_attrs()->find("__partition");
+}
+
+Partition::Weigh::Weigh() : Visitor() { 
+  weight_ = 0;
+}
+
+size_t Partition::Weigh::weigh(const ModuleDeclaration* md) {
+  weight_ = 0;
+  md->accept_items(this);
+  return weight_;
+}
+
+void Partition::Weigh::visit(const Identifier* id) {
+  ++weight_;
+  Visitor::visit(id);
+}
+
+void Partition::Weigh::visit(const CaseGenerateConstruct* cgc) {
+  if (Elaborate().is_elaborated(cgc)) {
+    Elaborate().get_elaboration(cgc)->accept(this);
+  }
+}
+
+void Partition::Weigh::visit(const IfGenerateConstruct* igc) {
+  if (Elaborate().is_elaborated(igc)) {
+    Elaborate().get_elaboration(igc)->accept(this);
+  }
+}
+
+void Partition::Weigh::visit(const LoopGenerateConstruct* lgc) {
+  if (Elaborate().is_elaborated(lgc)) {
+    for (auto* b : Elaborate().get_elaboration(lgc)) {
+      b->accept(this);
+    }
+  }
+}
+
+void Partition::Weigh::visit(const ContinuousAssign* ca) {
+  ++weight_;
+  Visitor::visit(ca);
+}
+
+void Partition::Weigh::visit(const ModuleInstantiation* mi) {
+  // Inlined code and code that will be inlined counts against this module.
+  // Everything else will run in an engine of its own.
+  if (Inline().is_inlined(mi)) {
+    return Inline().get_source(mi)->accept(this);
+  }
+  if (!Elaborate().is_elaborated(mi)) {
+    return;
+  }
+  const auto* src = Elaborate().get_elaboration(mi);
+  if (Inline().can_inline(src)) {
+    src->accept_items(this);
+  }
+}
+
+void Partition::Weigh::visit(const BlockingAssign* ba) {
+  ++weight_;
+  Visitor::visit(ba);
+}
+
+void Partition::Weigh::visit(const NonblockingAssign* na) {
+  ++weight_;
+  Visitor::visit(na);
+}
+
+void Partition::edit(CaseGenerateConstruct* cgc) {
+  if (Elaborate().is_elaborated(cgc)) {
+    Elaborate().get_elaboration(cgc)->accept(this);
+  }
+}
+
+void Partition::edit(IfGenerateConstruct* igc) {
+  if (Elaborate().is_elaborated(igc)) {
+    Elaborate().get_elaboration(igc)->accept(this);
+  }
+}
+
+void Partition::edit(LoopGenerateConstruct* lgc) {
+  if (Elaborate().is_elaborated(lgc)) {
+    for (auto* b : Elaborate().get_elaboration(lgc)) {
+      b->accept(this);
+    }
+  }
+}
+
+void Partition::edit(ModuleInstantiation* mi) {
+  insts_.push_back(mi);
+  // Don't descend! We only want to partition THIS module!
+}
+
+} // namespace cascade
@@ -0,0 +1,96 @@
+// Copyright 2017-2019 VMware, Inc.
+// SPDX-License-Identifier: BSD-2-Clause
+//
+// The BSD-2 license (the License) set forth below applies to all parts of the
+// Cascade project.  You may not use this file except in compliance with the
+// License.
+//
+// BSD-2 License
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this
+// list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+// this list of conditions and the following disclaimer in the documentation
+// and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS AS IS AND
+// ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef CASCADE_SRC_VERILOG_PROGRAM_PARTITION_H
+#define CASCADE_SRC_VERILOG_PROGRAM_PARTITION_H
+
+#include <stddef.h>
+#include <vector>
+#include "verilog/ast/visitors/editor.h"
+#include "verilog/ast/visitors/visitor.h"
+
+namespace cascade {
+
+// Inlining collapses all of the user logic in a program into a single module,
+// which the runtime evaluates on a single thread. This class splits that
+// module back apart along instantiation boundaries. It chooses up to k-1 of
+// the logic instantiations in the root module and marks them __no_inline and
+// __partition, so that they are compiled into engines of their own. Their
+// ports become data plane variables, and the runtime is free to evaluate
+// them concurrently with each other and with the root.
+//
+// Instantiations are chosen greedily, heaviest first, for as long as doing
+// so reduces the load on the most heavily loaded engine. Load is estimated
+// by counting variable references and assignments; every port which crosses
+// a partition boundary is charged for one data plane write and one read.
+
+class Partition : public Editor {
+  public:
+    // Constructors:
+    Partition();
+    ~Partition() override = default;
+
+    // Source Generate Interface:
+    void partition(ModuleDeclaration* md, size_t k);
+
+    // Query Interface:
+    bool is_partition(const ModuleDeclaration* md) const;
+
+  private:
+    class Weigh : public Visitor {
+      public:
+        Weigh();
+        ~Weigh() override = default;
+        size_t weigh(const ModuleDeclaration* md);
+      private:
+        size_t weight_;
+        void visit(const Identifier* id) override;
+        void visit(const CaseGenerateConstruct* cgc) override;
+        void visit(const IfGenerateConstruct* igc) override;
+        void visit(const LoopGenerateConstruct* lgc) override;
+        void visit(const ContinuousAssign* ca) override;
+        void visit(const ModuleInstantiation* mi) override;
+        void visit(const BlockingAssign* ba) override;
+        void visit(const NonblockingAssign* na) override;
+    };
+
+    // Operational State:
+    std::vector<ModuleInstantiation*> insts_;
+
+    // Editor Overrides:
+    void edit(CaseGenerateConstruct* cgc) override;
+    void edit(IfGenerateConstruct* igc) override;
+    void edit(LoopGenerateConstruct* lgc) override;
+    void edit(ModuleInstantiation* mi) override;
+};
+
+} // namespace cascade
+
+#endif
@@ -32,6 +32,8 @@
 
 #include <algorithm>
 #include <cassert>
+#include <unordered_map>
+#include <unordered_set>
 #include "common/log.h"
 #include "verilog/analyze/evaluate.h"
 #include "verilog/analyze/module_info.h"
@@ -41,6 +43,7 @@
 #include "verilog/parse/parser.h"
 #include "verilog/program/elaborate.h"
 #include "verilog/program/inline.h"
+#include "verilog/program/partition.h"
 #include "verilog/program/type_check.h"
 
 using namespace std;
@@ -71,6 +74,9 @@ Program::~Program() {
   if (root_elab() != elab_end()) {
     delete root_elab()->second;
   }
+  for (auto& m : memo_) {
+    delete m.second;
+  }
 }
 
 Program& Program::typecheck(bool tc) {
@@ -149,6 +155,12 @@ void Program::outline_all() {
   }
 }
 
+void Program::partition(size_t k) {
+  if (root_elab() != elabs_.end()) {
+    Partition().partition(root_elab()->second, k);
+  }
+}
+
 const ModuleDeclaration* Program::src() const {
   return (root_elab() == elab_end()) ? nullptr : root_elab()->second;
 }
@@ -195,12 +207,36 @@ void Program::elaborate(Node* n, Log* log, const Parser* p) {
   gen_queue_.clear();
   n->accept(this);
 
+  // Instantiations which share a memo key with one that is still being
+  // expanded are deferred until its body has been recorded.
+  unordered_map<string, const ModuleInstantiation*> pending;
+  unordered_set<const ModuleInstantiation*> checked;
+  vector<ModuleInstantiation*> deferred;
+
   while (!log->error() && (!inst_queue_.empty() || !gen_queue_.empty())) {
     for (size_t i = 0; !log->error() && i < inst_queue_.size(); ++i) {
       auto* mi = inst_queue_[i];
-      tc.pre_elaboration_check(mi);
+      if (checked.find(mi) == checked.end()) {
+        tc.pre_elaboration_check(mi);
+      }
       if (!log->error() && expand_insts_) {
-        auto* e = Elaborate(this).elaborate(mi);
+        ModuleDeclaration* e = nullptr;
+        if (Elaborate().is_elaborated(mi)) {
+          e = Elaborate().get_elaboration(mi);
+        } else {
+          const auto key = Elaborate(this).get_memo_key(mi);
+          const auto mitr = memo_.find(key);
+          if (mitr != memo_.end()) {
+            e = Elaborate(this).elaborate(mi, mitr->second);
+          } else if (pending.find(key) != pending.end()) {
+            checked.insert(mi);
+            deferred.push_back(mi);
+            continue;
+          } else {
+            e = Elaborate(this).elaborate(mi);
+            pending[key] = mi;
+          }
+        }
         assert(e != nullptr);
         e->accept(this);
         if (!Navigate(mi).lost()) {
@@ -226,12 +262,18 @@ void Program::elaborate(Node* n, Log* log, const Parser* p) {
     // generate statements which we create here until after we've recleared the
     // instantiation queue. In practice because we don't support defparams I
     // don't *think* it makes a difference.
+    //
+    // Generate constructs copied out of a memoized body arrive elaborated.
+    // They were checked when that body was first expanded, and checking them
+    // again would trip over the scopes they've already introduced.
 
     for (size_t i = 0; !log->error() && i < gen_queue_.size(); ++i) {
       auto* gc = gen_queue_[i];
       if (gc->is(Node::Tag::case_generate_construct)) {
         auto* cgc = static_cast<CaseGenerateConstruct*>(gc);
-        tc.pre_elaboration_check(cgc);
+        if (!Elaborate().is_elaborated(cgc)) {
+          tc.pre_elaboration_check(cgc);
+        }
         if (!log->error() && expand_gens_) {
           if (auto* e = Elaborate().elaborate(cgc)) {
             e->accept(this);
@@ -240,7 +282,9 @@ void Program::elaborate(Node* n, Log* log, const Parser* p) {
         }
       } else if (gc->is(Node::Tag::if_generate_construct)) {
         auto* igc = static_cast<IfGenerateConstruct*>(gc);
-        tc.pre_elaboration_check(igc);
+        if (!Elaborate().is_elaborated(igc)) {
+          tc.pre_elaboration_check(igc);
+        }
         if (!log->error() && expand_gens_) {
           if (auto* e = Elaborate().elaborate(igc)) {
             e->accept(this);
@@ -249,7 +293,9 @@ void Program::elaborate(Node* n, Log* log, const Parser* p) {
         }
       } else if (gc->is(Node::Tag::loop_generate_construct)) {
         auto* lgc = static_cast<LoopGenerateConstruct*>(gc);
-        tc.pre_elaboration_check(lgc);
+        if (!Elaborate().is_elaborated(lgc)) {
+          tc.pre_elaboration_check(lgc);
+        }
         if (!log->error() && expand_gens_) {
           const auto* itr = lgc->get_init()->get_lhs();
           const auto* r = Resolve().get_resolution(itr);
@@ -262,6 +308,17 @@ void Program::elaborate(Node* n, Log* log, const Parser* p) {
       }
     }
     gen_queue_.clear();
+
+    // Everything which was pending has now been fully expanded. Nested
+    // instantiations are elaborated separately and aren't part of the record.
+    if (!log->error()) {
+      for (auto& pm : pending) {
+        memo_[pm.first] = Elaborate().clone_elaboration(Elaborate().get_elaboration(pm.second));
+      }
+      pending.clear();
+      inst_queue_.insert(inst_queue_.end(), deferred.begin(), deferred.end());
+      deferred.clear();
+    }
   }
 
   if (!log->error()) {
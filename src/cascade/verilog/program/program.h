@@ -31,6 +31,8 @@
 #ifndef CASCADE_SRC_VERILOG_PROGRAM_PROGRAM_H
 #define CASCADE_SRC_VERILOG_PROGRAM_PROGRAM_H
 
+#include <string>
+#include <unordered_map>
 #include <vector>
 #include "common/undo_map.h"
 #include "verilog/analyze/indices.h"
@@ -94,6 +96,9 @@ class Program : public Editor {
     void inline_all();
     // Outline all modules
     void outline_all();
+    // Splits the logic which would otherwise be inlined into the root module
+    // into as many as k modules. See partition.h for details.
+    void partition(size_t k);
 
     // Top-level Source Interface:
     // 
@@ -125,6 +130,13 @@ class Program : public Editor {
     std::vector<ModuleInstantiation*> inst_queue_;
     std::vector<GenerateConstruct*> gen_queue_;
 
+    // Elaboration Memoization:
+    //
+    // Fully elaborated bodies, indexed by Elaborate::get_memo_key(). These are
+    // recorded once the generate constructs they contain have been expanded,
+    // and copied into subsequent instantiations with the same key.
+    std::unordered_map<std::string, ModuleDeclaration*> memo_;
+
     // Configuration Flags:
     bool checker_off_;
     bool decl_check_;
@@ -734,10 +734,12 @@ void TypeCheck::visit(const DebugStatement* ds) {
 void TypeCheck::visit(const GetStatement* gs) {
   gs->accept_fd(this);
   // Don't descend on format string
-  gs->accept_var(this);
   if (gs->is_null_var()) {
     return;
   }
+  if (!check_slice(gs->get_var())) {
+    gs->accept_var(this);
+  }
 
   // Can't continue checking if pointers are unresolvable
   const auto* r = Resolve().get_resolution(gs->get_var());
@@ -755,7 +757,9 @@ void TypeCheck::visit(const GetStatement* gs) {
 void TypeCheck::visit(const PutStatement* ps) {
   ps->accept_fd(this);
   // Don't descend on format string.
-  ps->accept_expr(this);
+  if (!check_slice(ps->get_expr())) {
+    ps->accept_expr(this);
+  }
 }
 
 void TypeCheck::visit(const VariableAssign* va) {
@@ -861,6 +865,34 @@ Identifier::const_iterator_dim TypeCheck::check_deref(const Identifier* r, const
   return iitr;
 }
 
+bool TypeCheck::check_slice(const Expression* e) {
+  if ((e == nullptr) || !e->is(Node::Tag::identifier)) {
+    return false;
+  }
+  const auto* id = static_cast<const Identifier*>(e);
+  if ((id->size_dim() != 1) || !id->back_dim()->is(Node::Tag::range_expression)) {
+    return false;
+  }
+  const auto* re = static_cast<const RangeExpression*>(id->back_dim());
+  if (re->get_type() != RangeExpression::Type::PLUS) {
+    return false;
+  }
+  // Anything other than a reference to an array is a part-select, and
+  // unresolvable identifiers are reported by the usual checks.
+  const auto* r = Resolve().get_resolution(id);
+  if ((r == nullptr) || r->empty_dim()) {
+    return false;
+  }
+
+  // RECURSE: start and count
+  re->accept(this);
+  // CHECK: One-dimensional arrays
+  if (r->size_dim() != 1) {
+    error("Cascade does not currently support bulk transfers on multi-dimensional arrays", id);
+  }
+  return true;
+}
+
 void TypeCheck::check_arity(const ModuleInstantiation* mi, const Identifier* port, const Expression* arg) {
   // Nothing to do if this is a scalar instantiation
   if (mi->is_null_range()) {
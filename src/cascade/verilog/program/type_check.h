@@ -129,6 +129,10 @@ class TypeCheck : public Visitor {
     // dereference, returns a pointer to the last unused element in its
     // dimensions so that further operations may check its slice.
     Identifier::const_iterator_dim check_deref(const Identifier* r, const Identifier* i);
+    // Checks the target of a bulk $fread() or $fwrite(): an indexed
+    // part-select in place of an array subscript. Returns false if e isn't
+    // one of these, in which case it should be checked as an expression.
+    bool check_slice(const Expression* e);
     // Instantiation Array Checking Helpers:
     void check_arity(const ModuleInstantiation* mi, const Identifier* port, const Expression* arg);
 };
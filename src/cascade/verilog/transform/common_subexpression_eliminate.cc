@@ -0,0 +1,455 @@
+// Copyright 2017-2019 VMware, Inc.
+// SPDX-License-Identifier: BSD-2-Clause
+//
+// The BSD-2 license (the License) set forth below applies to all parts of the
+// Cascade project.  You may not use this file except in compliance with the
+// License.
+//
+// BSD-2 License
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this
+// list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+// this list of conditions and the following disclaimer in the documentation
+// and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS AS IS AND
+// ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "verilog/transform/common_subexpression_eliminate.h"
+
+#include <algorithm>
+#include <sstream>
+#include "verilog/analyze/evaluate.h"
+#include "verilog/analyze/module_info.h"
+#include "verilog/analyze/navigate.h"
+#include "verilog/analyze/resolve.h"
+#include "verilog/ast/ast.h"
+#include "verilog/print/print.h"
+
+using namespace std;
+
+namespace cascade {
+
+CommonSubexpressionEliminate::CommonSubexpressionEliminate() : Rewriter() { 
+  next_id_ = 0;
+  replaced_ = 0;
+  nodes_before_ = 0;
+  nodes_after_ = 0;
+}
+
+void CommonSubexpressionEliminate::run(ModuleDeclaration* md) {
+  Count before;
+  md->accept(&before);
+  nodes_before_ = before.get();
+
+  // Each round replaces the outermost repeated expressions. Anything that was
+  // nested inside of one of those expressions now appears exactly once in the
+  // assignment to its new home, and will be considered again the next time
+  // around.
+  while (eliminate(md));
+
+  Count after;
+  md->accept(&after);
+  nodes_after_ = after.get();
+}
+
+size_t CommonSubexpressionEliminate::get_nodes_before() const {
+  return nodes_before_;
+}
+
+size_t CommonSubexpressionEliminate::get_nodes_after() const {
+  return nodes_after_;
+}
+
+bool CommonSubexpressionEliminate::eliminate(ModuleDeclaration* md) {
+  vns_.clear();
+  table_.clear();
+  sizes_.clear();
+  pure_.clear();
+  uses_.clear();
+  homes_.clear();
+  roots_.clear();
+
+  // Number the right-hand side of every continuous assignment
+  Numbering n(this);
+  for (auto i = md->begin_items(), ie = md->end_items(); i != ie; ++i) {
+    if ((*i)->is(Node::Tag::continuous_assign)) {
+      static_cast<const ContinuousAssign*>(*i)->get_rhs()->accept(&n);
+    }
+  }
+  // Prefer existing nets as homes for shared values 
+  for (auto i = md->begin_items(), ie = md->end_items(); i != ie; ++i) {
+    if ((*i)->is(Node::Tag::continuous_assign)) {
+      const auto* ca = static_cast<const ContinuousAssign*>(*i);
+      if (is_home(ca)) {
+        homes_.insert(make_pair(vns_[ca->get_rhs()], ca->get_lhs()));
+        roots_.insert(ca->get_rhs());
+      }
+    }
+  }
+
+  // Replace repeated expressions
+  replaced_ = 0;
+  for (auto i = md->begin_items(), ie = md->end_items(); i != ie; ++i) {
+    if ((*i)->is(Node::Tag::continuous_assign)) {
+      auto* ca = static_cast<ContinuousAssign*>(*i);
+      const auto n = replaced_;
+      ca->accept_rhs(this);
+      if (replaced_ > n) {
+        Evaluate().invalidate(ca->get_rhs());
+      }
+    }
+  }
+  if (replaced_ == 0) {
+    return false;
+  }
+
+  for (auto* d : decls_) {
+    md->push_front_items(d);
+  }
+  for (auto* ca : cas_) {
+    md->push_back_items(ca);
+  }
+  decls_.clear();
+  cas_.clear();
+
+  Resolve().invalidate(md);
+  Navigate(md).invalidate();
+  ModuleInfo(md).invalidate();
+  return true;
+}
+
+size_t CommonSubexpressionEliminate::fresh(size_t size) {
+  const auto res = sizes_.size();
+  sizes_.push_back(size);
+  pure_.push_back(false);
+  uses_.push_back(0);
+  return res;
+}
+
+size_t CommonSubexpressionEliminate::intern(const string& key, size_t size, bool pure) {
+  if (!pure) {
+    return fresh(size);
+  }
+  const auto itr = table_.find(key);
+  if (itr != table_.end()) {
+    return itr->second;
+  }
+  const auto res = fresh(size);
+  pure_[res] = true;
+  table_.insert(make_pair(key, res));
+  return res;
+}
+
+bool CommonSubexpressionEliminate::is_shared(const Expression* e) const {
+  const auto itr = vns_.find(e);
+  if (itr == vns_.end()) {
+    return false;
+  }
+  // Don't bother sharing anything smaller than an operator with two operands.
+  // Reading a net isn't free, and sharing ~x would cost more than it saves.
+  const auto vn = itr->second;
+  return pure_[vn] && (sizes_[vn] >= 3) && (uses_[vn] >= 2);
+}
+
+bool CommonSubexpressionEliminate::is_home(const ContinuousAssign* ca) const {
+  // The rhs has to be something worth sharing, and we only need one home
+  if (!is_shared(ca->get_rhs())) {
+    return false;
+  }
+  const auto itr = vns_.find(ca->get_rhs());
+  if (homes_.find(itr->second) != homes_.end()) {
+    return false;
+  }
+  // The lhs has to be a whole, scalar, unsigned net of exactly the same width
+  // as the rhs. Otherwise the value stored in the net would differ from the
+  // value of the expression.
+  const auto* lhs = ca->get_lhs();
+  if (!lhs->empty_dim()) {
+    return false;
+  }
+  const auto* r = Resolve().get_resolution(lhs);
+  if ((r == nullptr) || !r->get_parent()->is(Node::Tag::net_declaration)) {
+    return false;
+  }
+  if (!Evaluate().get_arity(r).empty()) {
+    return false;
+  }
+  return (Evaluate().get_type(r) == Bits::Type::UNSIGNED) &&
+    (Evaluate().get_width(r) == Evaluate().get_width(ca->get_rhs()));
+}
+
+Expression* CommonSubexpressionEliminate::share(Expression* e) {
+  if (!is_shared(e)) {
+    return nullptr;
+  }
+  // This expression is already computed by its home. Leave it, and everything
+  // nested inside of it, alone for the rest of this round.
+  if (roots_.find(e) != roots_.end()) {
+    return e;
+  }
+  const auto vn = vns_[e];
+  auto itr = homes_.find(vn);
+  if (itr == homes_.end()) {
+    const auto w = Evaluate().get_width(e);
+    const auto id = "__cse_" + to_string(next_id_++);
+    auto* lhs = new Identifier(id);
+    decls_.push_back(new NetDeclaration(
+      new Attributes(),
+      new Identifier(id),
+      Declaration::Type::UNSIGNED,
+      (w == 1) ? nullptr : new RangeExpression(w)
+    ));
+    cas_.push_back(new ContinuousAssign(lhs, e->clone()));
+    itr = homes_.insert(make_pair(vn, lhs)).first;
+  }
+  ++replaced_;
+  return itr->second->clone();
+}
+
+CommonSubexpressionEliminate::Numbering::Numbering(CommonSubexpressionEliminate* cse) : Visitor() {
+  cse_ = cse;
+}
+
+void CommonSubexpressionEliminate::Numbering::record(const Expression* e, const string& key, size_t size, bool pure) {
+  // Everything we share is read back from an unsigned net. Signed and real
+  // values would need to be cast, so we leave them where they are.
+  pure = pure && (Evaluate().get_type(e) == Bits::Type::UNSIGNED);
+
+  stringstream ss;
+  ss << key << " " << Evaluate().get_width(e) << " " << static_cast<int>(Evaluate().get_type(e));
+  const auto vn = cse_->intern(ss.str(), size, pure);
+  cse_->vns_[e] = vn;
+
+  // The concatenation inside of a multiple concatenation can't be replaced by
+  // a net, so it doesn't count as a use.
+  if (!e->get_parent()->is(Node::Tag::multiple_concatenation)) {
+    ++cse_->uses_[vn];
+  }
+}
+
+void CommonSubexpressionEliminate::Numbering::visit(const BinaryExpression* be) {
+  Visitor::visit(be);
+  auto l = cse_->vns_[be->get_lhs()];
+  auto r = cse_->vns_[be->get_rhs()];
+
+  // Canonicalize the operands of commutative operators. These operators
+  // determine the width of both operands the same way, so swapping them
+  // doesn't change the value of the expression.
+  switch (be->get_op()) {
+    case BinaryExpression::Op::PLUS:
+    case BinaryExpression::Op::TIMES:
+    case BinaryExpression::Op::EEEQ:
+    case BinaryExpression::Op::EEQ:
+    case BinaryExpression::Op::BEEQ:
+    case BinaryExpression::Op::BEQ:
+    case BinaryExpression::Op::AAMP:
+    case BinaryExpression::Op::PPIPE:
+    case BinaryExpression::Op::AMP:
+    case BinaryExpression::Op::PIPE:
+    case BinaryExpression::Op::CARAT:
+    case BinaryExpression::Op::TCARAT:
+      if (r < l) {
+        swap(l, r);
+      }
+      break;
+    default:
+      break;
+  }
+
+  stringstream ss;
+  ss << "b" << static_cast<int>(be->get_op()) << " " << l << " " << r;
+  const auto size = 1 + cse_->sizes_[l] + cse_->sizes_[r];
+  record(be, ss.str(), size, cse_->pure_[l] && cse_->pure_[r]);
+}
+
+void CommonSubexpressionEliminate::Numbering::visit(const ConditionalExpression* ce) {
+  Visitor::visit(ce);
+  const auto c = cse_->vns_[ce->get_cond()];
+  const auto l = cse_->vns_[ce->get_lhs()];
+  const auto r = cse_->vns_[ce->get_rhs()];
+
+  stringstream ss;
+  ss << "c " << c << " " << l << " " << r;
+  const auto size = 1 + cse_->sizes_[c] + cse_->sizes_[l] + cse_->sizes_[r];
+  record(ce, ss.str(), size, cse_->pure_[c] && cse_->pure_[l] && cse_->pure_[r]);
+}
+
+void CommonSubexpressionEliminate::Numbering::visit(const FeofExpression* fe) {
+  // The value of feof depends on side effects in the surrounding code. It can
+  // never be shared, and neither can anything that contains it.
+  cse_->vns_[fe] = cse_->fresh(1);
+}
+
+void CommonSubexpressionEliminate::Numbering::visit(const FopenExpression* fe) {
+  // Opening a file is a side effect.
+  cse_->vns_[fe] = cse_->fresh(1);
+}
+
+void CommonSubexpressionEliminate::Numbering::visit(const Concatenation* c) {
+  Visitor::visit(c);
+
+  stringstream ss;
+  ss << "{";
+  size_t size = 1;
+  auto pure = true;
+  for (auto i = c->begin_exprs(), ie = c->end_exprs(); i != ie; ++i) {
+    const auto vn = cse_->vns_[*i];
+    ss << " " << vn;
+    size += cse_->sizes_[vn];
+    pure = pure && cse_->pure_[vn];
+  }
+  record(c, ss.str(), size, pure);
+}
+
+void CommonSubexpressionEliminate::Numbering::visit(const Identifier* id) {
+  // Don't descend into subscripts. Identifiers are numbered by name, and
+  // since we only look at module-level assignments, equal names always refer
+  // to the same variable.
+  stringstream ss;
+  ss << "i " << id;
+  record(id, ss.str(), 1, true);
+}
+
+void CommonSubexpressionEliminate::Numbering::visit(const MultipleConcatenation* mc) {
+  // The multiplier is a constant expression tree of its own
+  mc->accept_concat(this);
+  const auto c = cse_->vns_[mc->get_concat()];
+
+  stringstream ss;
+  ss << "m " << mc->get_expr() << " " << c;
+  record(mc, ss.str(), 1 + cse_->sizes_[c], cse_->pure_[c]);
+}
+
+void CommonSubexpressionEliminate::Numbering::visit(const Number* n) {
+  stringstream ss;
+  ss << "n " << n;
+  record(n, ss.str(), 1, true);
+}
+
+void CommonSubexpressionEliminate::Numbering::visit(const String* s) {
+  cse_->vns_[s] = cse_->fresh(1);
+}
+
+void CommonSubexpressionEliminate::Numbering::visit(const UnaryExpression* ue) {
+  Visitor::visit(ue);
+  const auto l = cse_->vns_[ue->get_lhs()];
+
+  stringstream ss;
+  ss << "u" << static_cast<int>(ue->get_op()) << " " << l;
+  record(ue, ss.str(), 1 + cse_->sizes_[l], cse_->pure_[l]);
+}
+
+CommonSubexpressionEliminate::Count::Count() : Visitor() {
+  n_ = 0;
+}
+
+size_t CommonSubexpressionEliminate::Count::get() const {
+  return n_;
+}
+
+void CommonSubexpressionEliminate::Count::visit(const BinaryExpression* be) {
+  Visitor::visit(be);
+  ++n_;
+}
+
+void CommonSubexpressionEliminate::Count::visit(const ConditionalExpression* ce) {
+  Visitor::visit(ce);
+  ++n_;
+}
+
+void CommonSubexpressionEliminate::Count::visit(const FeofExpression* fe) {
+  Visitor::visit(fe);
+  ++n_;
+}
+
+void CommonSubexpressionEliminate::Count::visit(const FopenExpression* fe) {
+  Visitor::visit(fe);
+  ++n_;
+}
+
+void CommonSubexpressionEliminate::Count::visit(const Concatenation* c) {
+  Visitor::visit(c);
+  ++n_;
+}
+
+void CommonSubexpressionEliminate::Count::visit(const Identifier* id) {
+  Visitor::visit(id);
+  ++n_;
+}
+
+void CommonSubexpressionEliminate::Count::visit(const MultipleConcatenation* mc) {
+  Visitor::visit(mc);
+  ++n_;
+}
+
+void CommonSubexpressionEliminate::Count::visit(const Number* n) {
+  Visitor::visit(n);
+  ++n_;
+}
+
+void CommonSubexpressionEliminate::Count::visit(const RangeExpression* re) {
+  Visitor::visit(re);
+  ++n_;
+}
+
+void CommonSubexpressionEliminate::Count::visit(const String* s) {
+  Visitor::visit(s);
+  ++n_;
+}
+
+void CommonSubexpressionEliminate::Count::visit(const UnaryExpression* ue) {
+  Visitor::visit(ue);
+  ++n_;
+}
+
+Expression* CommonSubexpressionEliminate::rewrite(BinaryExpression* be) {
+  auto* res = share(be);
+  return (res != nullptr) ? res : Rewriter::rewrite(be);
+}
+
+Expression* CommonSubexpressionEliminate::rewrite(ConditionalExpression* ce) {
+  auto* res = share(ce);
+  return (res != nullptr) ? res : Rewriter::rewrite(ce);
+}
+
+Expression* CommonSubexpressionEliminate::rewrite(Concatenation* c) {
+  auto* res = share(c);
+  return (res != nullptr) ? res : Rewriter::rewrite(c);
+}
+
+Expression* CommonSubexpressionEliminate::rewrite(Identifier* id) {
+  // Subscripts are left alone, see Numbering::visit(Identifier*)
+  return id;
+}
+
+Expression* CommonSubexpressionEliminate::rewrite(MultipleConcatenation* mc) {
+  auto* res = share(mc);
+  if (res != nullptr) {
+    return res;
+  }
+  // The concatenation has to remain a concatenation, but its elements are
+  // fair game
+  mc->get_concat()->accept_exprs(this);
+  return mc;
+}
+
+Expression* CommonSubexpressionEliminate::rewrite(UnaryExpression* ue) {
+  auto* res = share(ue);
+  return (res != nullptr) ? res : Rewriter::rewrite(ue);
+}
+
+} // namespace cascade
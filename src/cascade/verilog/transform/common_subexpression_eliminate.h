@@ -0,0 +1,158 @@
+// Copyright 2017-2019 VMware, Inc.
+// SPDX-License-Identifier: BSD-2-Clause
+//
+// The BSD-2 license (the License) set forth below applies to all parts of the
+// Cascade project.  You may not use this file except in compliance with the
+// License.
+//
+// BSD-2 License
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this
+// list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+// this list of conditions and the following disclaimer in the documentation
+// and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS AS IS AND
+// ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef CASCADE_SRC_VERILOG_TRANSFORM_COMMON_SUBEXPRESSION_ELIMINATE_H
+#define CASCADE_SRC_VERILOG_TRANSFORM_COMMON_SUBEXPRESSION_ELIMINATE_H
+
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+#include "verilog/ast/visitors/rewriter.h"
+#include "verilog/ast/visitors/visitor.h"
+
+namespace cascade {
+
+// This pass hash-conses the right-hand sides of continuous assignments. Every
+// expression is assigned a value number based on its operator, the value
+// numbers of its operands, and its final (context-determined) width and type.
+// Any pure, unsigned expression whose value number appears more than once is
+// computed exactly once, either by an existing net that is already assigned
+// that value, or by a new __cse_n wire. Procedural code is left alone: an
+// expression inside of an always block can observe blocking assignments which
+// a continuously evaluated wire would not.
+
+class CommonSubexpressionEliminate : public Rewriter {
+  public:
+    CommonSubexpressionEliminate();
+    ~CommonSubexpressionEliminate() override = default;
+
+    void run(ModuleDeclaration* md);
+
+    // Returns the number of expression nodes in the most recently transformed
+    // module before and after running this pass.
+    size_t get_nodes_before() const;
+    size_t get_nodes_after() const;
+
+  private:
+    // Value number for every expression in an assignment rhs
+    std::unordered_map<const Expression*, size_t> vns_;
+    // Hash-cons table; subtree size, purity, and uses for each value number
+    std::unordered_map<std::string, size_t> table_;
+    std::vector<size_t> sizes_;
+    std::vector<bool> pure_;
+    std::vector<size_t> uses_;
+    // Nets which hold shared values, and the assignments which define them
+    std::unordered_map<size_t, const Identifier*> homes_;
+    std::unordered_set<const Expression*> roots_;
+    // New declarations and assignments created by the current iteration
+    std::vector<ModuleItem*> decls_;
+    std::vector<ModuleItem*> cas_;
+    size_t next_id_;
+    size_t replaced_;
+
+    size_t nodes_before_;
+    size_t nodes_after_;
+
+    // Runs a single round of value numbering and replacement. Returns true if
+    // any expressions were replaced.
+    bool eliminate(ModuleDeclaration* md);
+    // Returns a fresh value number which can never be shared
+    size_t fresh(size_t size);
+    // Looks up (or creates) the value number for a key
+    size_t intern(const std::string& key, size_t size, bool pure);
+    // Returns true if this expression can be replaced by a net
+    bool is_shared(const Expression* e) const;
+    // Returns true if this assignment can donate its lhs as a home for its rhs
+    bool is_home(const ContinuousAssign* ca) const;
+    // Returns a reference to the net holding e's value, creating one if
+    // necessary. Returns e if e should be left as is, or nullptr if e isn't
+    // shared but its subexpressions might be.
+    Expression* share(Expression* e);
+
+    // Helper Class: Assigns value numbers bottom up
+    class Numbering : public Visitor {
+      public:
+        explicit Numbering(CommonSubexpressionEliminate* cse);
+        ~Numbering() override = default;
+
+      private:
+        CommonSubexpressionEliminate* cse_;
+
+        void record(const Expression* e, const std::string& key, size_t size, bool pure);
+
+        void visit(const BinaryExpression* be) override;
+        void visit(const ConditionalExpression* ce) override;
+        void visit(const FeofExpression* fe) override;
+        void visit(const FopenExpression* fe) override;
+        void visit(const Concatenation* c) override;
+        void visit(const Identifier* id) override;
+        void visit(const MultipleConcatenation* mc) override;
+        void visit(const Number* n) override;
+        void visit(const String* s) override;
+        void visit(const UnaryExpression* ue) override;
+    };
+
+    // Helper Class: Counts the expression nodes in a module
+    class Count : public Visitor {
+      public:
+        Count();
+        ~Count() override = default;
+
+        size_t get() const;
+
+      private:
+        size_t n_;
+
+        void visit(const BinaryExpression* be) override;
+        void visit(const ConditionalExpression* ce) override;
+        void visit(const FeofExpression* fe) override;
+        void visit(const FopenExpression* fe) override;
+        void visit(const Concatenation* c) override;
+        void visit(const Identifier* id) override;
+        void visit(const MultipleConcatenation* mc) override;
+        void visit(const Number* n) override;
+        void visit(const RangeExpression* re) override;
+        void visit(const String* s) override;
+        void visit(const UnaryExpression* ue) override;
+    };
+
+    // Rewriter Interface
+    Expression* rewrite(BinaryExpression* be) override;
+    Expression* rewrite(ConditionalExpression* ce) override;
+    Expression* rewrite(Concatenation* c) override;
+    Expression* rewrite(Identifier* id) override;
+    Expression* rewrite(MultipleConcatenation* mc) override;
+    Expression* rewrite(UnaryExpression* ue) override;
+};
+
+} // namespace cascade
+
+#endif
@@ -247,6 +247,62 @@ Expression* ConstantProp::rewrite(UnaryExpression* ue) {
   return Rewriter::rewrite(ue);
 }
 
+Statement* ConstantProp::rewrite(CaseStatement* cs) {
+  if (!RuntimeConstant(this).check(cs->get_cond())) {
+    return Rewriter::rewrite(cs);
+  }
+  for (auto i = cs->begin_items(), ie = cs->end_items(); i != ie; ++i) {
+    for (auto j = (*i)->begin_exprs(), je = (*i)->end_exprs(); j != je; ++j) {
+      if (!RuntimeConstant(this).check(*j)) {
+        return Rewriter::rewrite(cs);
+      }
+    }
+  }
+
+  // The condition and items are compared at a common width and type. Items
+  // are tried in order, and the default is only taken if nothing matches.
+  const auto w = Evaluate().get_width(cs);
+  const auto t = Evaluate().get_type(cs);
+  const auto extend = [w, t](const Expression* e) {
+    auto res = Evaluate().get_value(e);
+    if (t == Bits::Type::REAL) {
+      res.cast_type(t);
+    } else {
+      res.reinterpret_type(t);
+      res.resize(w);
+    }
+    return res;
+  };
+
+  const auto c = extend(cs->get_cond());
+  CaseItem* match = nullptr;
+  for (auto i = cs->begin_items(), ie = cs->end_items(); (match == nullptr) && (i != ie); ++i) {
+    for (auto j = (*i)->begin_exprs(), je = (*i)->end_exprs(); j != je; ++j) {
+      if (c.eq(extend(*j))) {
+        match = *i;
+        break;
+      }
+    }
+  }
+  if (match == nullptr) {
+    for (auto i = cs->begin_items(), ie = cs->end_items(); i != ie; ++i) {
+      if ((*i)->empty_exprs()) {
+        match = *i;
+        break;
+      }
+    }
+  }
+  if (match == nullptr) {
+    return new SeqBlock();
+  }
+
+  auto* res = match->accept_stmt(this);
+  if (res == match->get_stmt()) {
+    match->set_stmt(new SeqBlock());
+  }
+  return res;
+}
+
 Statement* ConstantProp::rewrite(ConditionalStatement* cs) {
   if (RuntimeConstant(this).check(cs->get_if())) {
     Statement* res = nullptr;
@@ -79,7 +79,7 @@ class ConstantProp : public Rewriter {
     Expression* rewrite(MultipleConcatenation* mc) override;
     Expression* rewrite(RangeExpression* re) override;
     Expression* rewrite(UnaryExpression* ue) override;
-    // TODO(eschkufz) Add support for constexpr evaluating case statements
+    Statement* rewrite(CaseStatement* cs) override;
     Statement* rewrite(ConditionalStatement* cs) override;
     Statement* rewrite(DebugStatement* ds) override;
 };
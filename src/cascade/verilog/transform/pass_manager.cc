@@ -0,0 +1,244 @@
+// Copyright 2017-2019 VMware, Inc.
+// SPDX-License-Identifier: BSD-2-Clause
+//
+// The BSD-2 license (the License) set forth below applies to all parts of the
+// Cascade project.  You may not use this file except in compliance with the
+// License.
+//
+// BSD-2 License
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this
+// list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+// this list of conditions and the following disclaimer in the documentation
+// and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS AS IS AND
+// ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "verilog/transform/pass_manager.h"
+
+#include <algorithm>
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include "verilog/ast/ast.h"
+#include "verilog/print/print.h"
+#include "verilog/transform/assign_unpack.h"
+#include "verilog/transform/block_flatten.h"
+#include "verilog/transform/common_subexpression_eliminate.h"
+#include "verilog/transform/constant_prop.h"
+#include "verilog/transform/control_merge.h"
+#include "verilog/transform/de_alias.h"
+#include "verilog/transform/dead_code_eliminate.h"
+#include "verilog/transform/event_expand.h"
+#include "verilog/transform/index_normalize.h"
+#include "verilog/transform/loop_unroll.h"
+#include "verilog/transform/strength_reduce.h"
+
+using namespace std;
+
+namespace cascade {
+
+PassManager::PassManager() {
+  for (const auto& p : registry()) {
+    passes_.push_back(&p);
+  }
+  enable_report_ = false;
+}
+
+PassManager::~PassManager() {
+  clear_memo();
+}
+
+PassManager& PassManager::set_passes(const string& s) {
+  passes_.clear();
+  stringstream ss(s);
+  for (string name; getline(ss, name, ','); ) {
+    for (const auto& p : registry()) {
+      if (p.name == name) {
+        passes_.push_back(&p);
+        break;
+      }
+    }
+  }
+
+  // Put back any required passes that were left out. Each one goes in front
+  // of the first pass that follows it in the default pipeline.
+  const auto& r = registry();
+  for (auto i = r.begin(), ie = r.end(); i != ie; ++i) {
+    if (!i->required || (find(passes_.begin(), passes_.end(), &*i) != passes_.end())) {
+      continue;
+    }
+    auto j = passes_.begin();
+    for (; (j != passes_.end()) && (*j < &*i); ++j);
+    passes_.insert(j, &*i);
+  }
+
+  clear_memo();
+  return *this;
+}
+
+string PassManager::get_passes() const {
+  string res;
+  for (const auto& p : passes_) {
+    res += (res.empty() ? "" : ",") + p->name;
+  }
+  return res;
+}
+
+PassManager& PassManager::set_enable_report(bool er) {
+  enable_report_ = er;
+  return *this;
+}
+
+bool PassManager::get_enable_report() const {
+  return enable_report_;
+}
+
+ModuleDeclaration* PassManager::run(ModuleDeclaration* md, ostream* os) {
+  stringstream ss;
+  ss << md;
+  auto key = ss.str();
+
+  // Fast Path: We've seen this exact module before
+  const auto itr = memo_.find(key);
+  if (itr != memo_.end()) {
+    if (os != nullptr) {
+      *os << "  memoized result reused" << endl;
+    }
+    delete md;
+    return itr->second->clone();
+  }
+
+  // Slow Path: Run the pipeline, optionally recording statistics
+  const auto begin = chrono::steady_clock::now();
+  for (const auto* p : passes_) {
+    if (os == nullptr) {
+      p->run(md);
+      continue;
+    }
+    const auto before = Count().run(md);
+    const auto t = chrono::steady_clock::now();
+    p->run(md);
+    const chrono::duration<double, milli> ms = chrono::steady_clock::now() - t;
+    const auto after = Count().run(md);
+    *os << "  " << left << setw(32) << p->name << right << fixed << setprecision(3) << setw(10) << ms.count() << " ms"
+        << "  items " << before.first << " -> " << after.first 
+        << "  exprs " << before.second << " -> " << after.second << "\n";
+  }
+  if (os != nullptr) {
+    const chrono::duration<double, milli> ms = chrono::steady_clock::now() - begin;
+    *os << "  " << left << setw(32) << "total" << right << fixed << setprecision(3) << setw(10) << ms.count() << " ms" << endl;
+  }
+
+  if (memo_.size() >= max_memo_) {
+    clear_memo();
+  }
+  memo_.insert(make_pair(move(key), md->clone()));
+  return md;
+}
+
+PassManager::Count::Count() : Visitor() { 
+  exprs_ = 0;
+}
+
+pair<size_t, size_t> PassManager::Count::run(const ModuleDeclaration* md) {
+  exprs_ = 0;
+  md->accept_items(this);
+  return make_pair(md->size_items(), exprs_);
+}
+
+void PassManager::Count::visit(const BinaryExpression* be) {
+  Visitor::visit(be);
+  ++exprs_;
+}
+
+void PassManager::Count::visit(const ConditionalExpression* ce) {
+  Visitor::visit(ce);
+  ++exprs_;
+}
+
+void PassManager::Count::visit(const FeofExpression* fe) {
+  Visitor::visit(fe);
+  ++exprs_;
+}
+
+void PassManager::Count::visit(const FopenExpression* fe) {
+  Visitor::visit(fe);
+  ++exprs_;
+}
+
+void PassManager::Count::visit(const Concatenation* c) {
+  Visitor::visit(c);
+  ++exprs_;
+}
+
+void PassManager::Count::visit(const Identifier* id) {
+  Visitor::visit(id);
+  ++exprs_;
+}
+
+void PassManager::Count::visit(const MultipleConcatenation* mc) {
+  Visitor::visit(mc);
+  ++exprs_;
+}
+
+void PassManager::Count::visit(const Number* n) {
+  Visitor::visit(n);
+  ++exprs_;
+}
+
+void PassManager::Count::visit(const String* s) {
+  Visitor::visit(s);
+  ++exprs_;
+}
+
+void PassManager::Count::visit(const RangeExpression* re) {
+  Visitor::visit(re);
+  ++exprs_;
+}
+
+void PassManager::Count::visit(const UnaryExpression* ue) {
+  Visitor::visit(ue);
+  ++exprs_;
+}
+
+const vector<PassManager::Pass>& PassManager::registry() {
+  static const vector<Pass> passes = {{
+    {"assign_unpack", true, [](ModuleDeclaration* md) {AssignUnpack().run(md);}},
+    {"index_normalize", true, [](ModuleDeclaration* md) {IndexNormalize().run(md);}},
+    {"loop_unroll", true, [](ModuleDeclaration* md) {LoopUnroll().run(md);}},
+    {"de_alias", false, [](ModuleDeclaration* md) {DeAlias().run(md);}},
+    {"constant_prop", false, [](ModuleDeclaration* md) {ConstantProp().run(md);}},
+    {"strength_reduce", false, [](ModuleDeclaration* md) {StrengthReduce().run(md);}},
+    {"common_subexpression_eliminate", false, [](ModuleDeclaration* md) {CommonSubexpressionEliminate().run(md);}},
+    {"event_expand", true, [](ModuleDeclaration* md) {EventExpand().run(md);}},
+    {"control_merge", false, [](ModuleDeclaration* md) {ControlMerge().run(md);}},
+    {"dead_code_eliminate", false, [](ModuleDeclaration* md) {DeadCodeEliminate().run(md);}},
+    {"block_flatten", false, [](ModuleDeclaration* md) {BlockFlatten().run(md);}}
+  }};
+  return passes;
+}
+
+void PassManager::clear_memo() {
+  for (auto& m : memo_) {
+    delete m.second;
+  }
+  memo_.clear();
+}
+
+} // namespace cascade
@@ -0,0 +1,130 @@
+// Copyright 2017-2019 VMware, Inc.
+// SPDX-License-Identifier: BSD-2-Clause
+//
+// The BSD-2 license (the License) set forth below applies to all parts of the
+// Cascade project.  You may not use this file except in compliance with the
+// License.
+//
+// BSD-2 License
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this
+// list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+// this list of conditions and the following disclaimer in the documentation
+// and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS AS IS AND
+// ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef CASCADE_SRC_VERILOG_TRANSFORM_PASS_MANAGER_H
+#define CASCADE_SRC_VERILOG_TRANSFORM_PASS_MANAGER_H
+
+#include <functional>
+#include <iosfwd>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include "verilog/ast/ast_fwd.h"
+#include "verilog/ast/visitors/visitor.h"
+
+namespace cascade {
+
+// This class runs the sequence of transformations which lower an isolated
+// module to the form that's handed to a target. The sequence is configurable
+// by name, and each run can optionally report the time spent in each pass and
+// its effect on the size of the module. 
+//
+// Results are memoized on the text of the isolated module. Isolation produces
+// deterministic variable names, so modules which haven't changed since the
+// last time they were transformed skip the pipeline entirely. This class is
+// not thread-safe, and is intended to be used by the runtime thread only.
+
+class PassManager {
+  public:
+    PassManager();
+    ~PassManager();
+
+    // Configuration Interface:
+    //
+    // Sets the pipeline from a comma separated list of pass names. Passes run
+    // in the order they're listed, and optimizations which aren't listed don't
+    // run. Passes that targets depend on always run; if they aren't listed,
+    // they're inserted in their default position relative to the passes
+    // that are. Unrecognized names are ignored. Changing the pipeline clears
+    // any memoized results.
+    PassManager& set_passes(const std::string& s);
+    // Returns the current pipeline as a comma separated list.
+    std::string get_passes() const;
+    // Enables or disables reporting (see run()).
+    PassManager& set_enable_report(bool er);
+    bool get_enable_report() const;
+
+    // Runs the pipeline on md and returns the result. Ownership of md is
+    // transferred to this method, and the result may or may not be md itself.
+    // If os is non-null, a report for this run is printed to os.
+    ModuleDeclaration* run(ModuleDeclaration* md, std::ostream* os = nullptr);
+
+  private:
+    // A named pass, and whether it's required for correctness or is only an
+    // optimization
+    struct Pass {
+      std::string name;
+      bool required;
+      std::function<void(ModuleDeclaration*)> run;
+    };
+
+    // Helper Class: Counts the items and expressions in a module.
+    class Count : public Visitor {
+      public:
+        Count();
+        ~Count() override = default;
+
+        std::pair<size_t, size_t> run(const ModuleDeclaration* md);
+
+      private:
+        size_t exprs_;
+
+        void visit(const BinaryExpression* be) override;
+        void visit(const ConditionalExpression* ce) override;
+        void visit(const FeofExpression* fe) override;
+        void visit(const FopenExpression* fe) override;
+        void visit(const Concatenation* c) override;
+        void visit(const Identifier* id) override;
+        void visit(const MultipleConcatenation* mc) override;
+        void visit(const Number* n) override;
+        void visit(const String* s) override;
+        void visit(const RangeExpression* re) override;
+        void visit(const UnaryExpression* ue) override;
+    };
+
+    // Every pass this class knows about, in default order
+    static const std::vector<Pass>& registry();
+
+    // Configuration State:
+    std::vector<const Pass*> passes_;
+    bool enable_report_;
+
+    // Memoized results, keyed on the text of an isolated module. This table
+    // is cleared when it grows beyond max_memo_.
+    static constexpr size_t max_memo_ = 1024;
+    std::unordered_map<std::string, ModuleDeclaration*> memo_;
+
+    void clear_memo();
+};
+
+} // namespace cascade
+
+#endif
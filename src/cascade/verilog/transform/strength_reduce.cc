@@ -0,0 +1,410 @@
+// Copyright 2017-2019 VMware, Inc.
+// SPDX-License-Identifier: BSD-2-Clause
+//
+// The BSD-2 license (the License) set forth below applies to all parts of the
+// Cascade project.  You may not use this file except in compliance with the
+// License.
+//
+// BSD-2 License
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this
+// list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+// this list of conditions and the following disclaimer in the documentation
+// and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS AS IS AND
+// ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "verilog/transform/strength_reduce.h"
+
+#include <vector>
+#include "verilog/analyze/module_info.h"
+#include "verilog/analyze/resolve.h"
+
+using namespace std;
+
+namespace cascade {
+
+StrengthReduce::StrengthReduce() : Rewriter() { }
+
+void StrengthReduce::run(ModuleDeclaration* md) {
+  md->accept_items(this);
+
+  // Invalidate cached state (we haven't added or deleted declarations, so
+  // there's no need to invalidate the scope tree).
+  Resolve().invalidate(md);
+  ModuleInfo(md).invalidate();
+}
+
+bool StrengthReduce::get_self_width(const Expression* e, size_t* w) const {
+  if (e->is(Node::Tag::number)) {
+    *w = static_cast<const Number*>(e)->get_val().size();
+    return true;
+  }
+  if (!e->is(Node::Tag::identifier)) {
+    return false;
+  }
+  const auto* id = static_cast<const Identifier*>(e);
+  const auto* r = Resolve().get_resolution(id);
+  if (r == nullptr) {
+    return false;
+  }
+  if (!Resolve().is_slice(id)) {
+    *w = Evaluate().get_width(r);
+    return true;
+  }
+  const auto* dim = id->back_dim();
+  if (dim->is(Node::Tag::range_expression)) {
+    const auto rng = Evaluate().get_range(dim);
+    *w = rng.first - rng.second + 1;
+  } else {
+    *w = 1;
+  }
+  return true;
+}
+
+bool StrengthReduce::is_unsigned_const(const Number* n) const {
+  const auto& v = n->get_val();
+  switch (v.get_type()) {
+    case Bits::Type::UNSIGNED:
+      return true;
+    case Bits::Type::SIGNED:
+      return !v.get(v.size()-1);
+    default:
+      return false;
+  }
+}
+
+Expression* StrengthReduce::pad(const Expression* e, size_t w) const {
+  size_t ew = 0;
+  get_self_width(e, &ew);
+  if (ew >= w) {
+    return e->clone();
+  }
+  auto* res = new Concatenation();
+  res->push_back_exprs(new Number(Bits(w-ew, 0), Number::Format::HEX));
+  res->push_back_exprs(e->clone());
+  return res;
+}
+
+Expression* StrengthReduce::narrow(Expression* e, size_t w) {
+  if (Evaluate().get_width(e) <= w) {
+    return e;
+  }
+
+  // Operators whose low w bits only depend on the low w bits of their operands
+  if (e->is(Node::Tag::binary_expression)) {
+    auto* be = static_cast<BinaryExpression*>(e);
+    switch (be->get_op()) {
+      case BinaryExpression::Op::PLUS:
+      case BinaryExpression::Op::MINUS:
+      case BinaryExpression::Op::TIMES:
+      case BinaryExpression::Op::AMP:
+      case BinaryExpression::Op::PIPE:
+      case BinaryExpression::Op::CARAT:
+      case BinaryExpression::Op::TCARAT: {
+        auto* l = narrow(be->get_lhs(), w);
+        if (l != be->get_lhs()) {
+          be->replace_lhs(l);
+        }
+        auto* r = narrow(be->get_rhs(), w);
+        if (r != be->get_rhs()) {
+          be->replace_rhs(r);
+        }
+        return be;
+      }
+      case BinaryExpression::Op::LLT:
+      case BinaryExpression::Op::LLLT: {
+        // The shift amount is self-determined and has to be left alone
+        auto* l = narrow(be->get_lhs(), w);
+        if (l != be->get_lhs()) {
+          be->replace_lhs(l);
+        }
+        return be;
+      }
+      default:
+        return e;
+    }
+  }
+  if (e->is(Node::Tag::unary_expression)) {
+    auto* ue = static_cast<UnaryExpression*>(e);
+    switch (ue->get_op()) {
+      case UnaryExpression::Op::PLUS:
+      case UnaryExpression::Op::MINUS:
+      case UnaryExpression::Op::TILDE: {
+        auto* l = narrow(ue->get_lhs(), w);
+        if (l != ue->get_lhs()) {
+          ue->replace_lhs(l);
+        }
+        return ue;
+      }
+      default:
+        return e;
+    }
+  }
+  if (e->is(Node::Tag::conditional_expression)) {
+    // The condition is self-determined, but both branches can be narrowed
+    auto* ce = static_cast<ConditionalExpression*>(e);
+    auto* l = narrow(ce->get_lhs(), w);
+    if (l != ce->get_lhs()) {
+      ce->replace_lhs(l);
+    }
+    auto* r = narrow(ce->get_rhs(), w);
+    if (r != ce->get_rhs()) {
+      ce->replace_rhs(r);
+    }
+    return ce;
+  }
+
+  if (e->is(Node::Tag::concatenation)) {
+    // Zero padding (see pad()) can be dropped if the value it pads is narrow
+    // enough on its own
+    auto* c = static_cast<Concatenation*>(e);
+    if (c->size_exprs() != 2 || !c->front_exprs()->is(Node::Tag::number)) {
+      return e;
+    }
+    const auto* n = static_cast<const Number*>(c->front_exprs());
+    const auto* x = c->back_exprs();
+    if (!n->get_val().to_bool() && (Evaluate().get_type(x) == Bits::Type::UNSIGNED) && (Evaluate().get_width(x) <= w)) {
+      return x->clone();
+    }
+    return e;
+  }
+
+  // Leaves: truncate numbers and slice variables
+  if (e->is(Node::Tag::number)) {
+    const auto* n = static_cast<const Number*>(e);
+    if (n->get_val().is_real() || (n->get_val().size() <= w)) {
+      return e;
+    }
+    auto val = n->get_val();
+    val.resize(w);
+    return new Number(val, n->get_format());
+  }
+  if (e->is(Node::Tag::identifier)) {
+    const auto* id = static_cast<const Identifier*>(e);
+    const auto* r = Resolve().get_resolution(id);
+    if ((r == nullptr) || (Evaluate().get_type(r) == Bits::Type::REAL)) {
+      return e;
+    }
+    size_t lsb = 0;
+    size_t iw = 0;
+    if (!Resolve().is_slice(id)) {
+      // Whole variables are sliced relative to their declared range. We don't
+      // bother with ranges that are declared in ascending order.
+      if (Evaluate().get_msb(r) < Evaluate().get_lsb(r)) {
+        return e;
+      }
+      lsb = Evaluate().get_lsb(r);
+      iw = Evaluate().get_width(r);
+    } else {
+      // Existing slices are only narrowed if their bounds are constant
+      const auto* dim = id->back_dim();
+      if (!dim->is(Node::Tag::range_expression)) {
+        return e;
+      }
+      const auto* re = static_cast<const RangeExpression*>(dim);
+      const auto constant = 
+        (re->get_type() == RangeExpression::Type::CONSTANT) &&
+        re->get_upper()->is(Node::Tag::number) &&
+        re->get_lower()->is(Node::Tag::number);
+      if (!constant) {
+        return e;
+      }
+      const auto rng = Evaluate().get_range(re);
+      if (rng.first < rng.second) {
+        return e;
+      }
+      lsb = rng.second;
+      iw = rng.first - rng.second + 1;
+    }
+    if (iw <= w) {
+      return e;
+    }
+
+    auto* res = id->clone();
+    if (Resolve().is_slice(id)) {
+      res->purge_to_dim(res->size_dim()-1);
+    }
+    res->push_back_dim(new RangeExpression(lsb+w, lsb));
+    return res;
+  }
+
+  return e;
+}
+
+Expression* StrengthReduce::reduce_times(BinaryExpression* be) {
+  // Look for a constant on either side
+  const auto lnum = be->get_lhs()->is(Node::Tag::number);
+  const auto rnum = be->get_rhs()->is(Node::Tag::number);
+  if (!lnum && !rnum) {
+    return be;
+  }
+  const auto* c = static_cast<const Number*>(rnum ? be->get_rhs() : be->get_lhs());
+  const auto* x = rnum ? be->get_lhs() : be->get_rhs();
+
+  // Signed operands are left alone, and so is anything whose width we can't
+  // determine statically. Unsized constants like 4 are signed, but they're
+  // treated as unsigned values in an unsigned context.
+  const auto& v = c->get_val();
+  if (!is_unsigned_const(c) || (Evaluate().get_type(x) != Bits::Type::UNSIGNED)) {
+    return be;
+  }
+  size_t xw = 0;
+  if (!get_self_width(x, &xw)) {
+    return be;
+  }
+  vector<size_t> ones;
+  for (size_t i = 0, ie = v.size(); i < ie; ++i) {
+    if (v.get(i)) {
+      ones.push_back(i);
+    }
+  }
+
+  // Powers of two become shifts, and constants with two bits set become a
+  // sum of two shifts. Anything else is cheaper as a multiply.
+  const auto w = max(xw, v.size());
+  Expression* res = nullptr;
+  if (ones.size() == 1) {
+    res = (ones[0] == 0) ? pad(x, w) : new BinaryExpression(pad(x, w), BinaryExpression::Op::LLT, new Number(Bits(32, ones[0])));
+  } else if (ones.size() == 2) {
+    auto* lo = (ones[0] == 0) ? pad(x, w) : new BinaryExpression(pad(x, w), BinaryExpression::Op::LLT, new Number(Bits(32, ones[0])));
+    auto* hi = new BinaryExpression(pad(x, w), BinaryExpression::Op::LLT, new Number(Bits(32, ones[1])));
+    res = new BinaryExpression(hi, BinaryExpression::Op::PLUS, lo);
+  } else {
+    return be;
+  }
+  Evaluate().invalidate(be);
+  return res;
+}
+
+Expression* StrengthReduce::reduce_div(BinaryExpression* be) {
+  if (!be->get_rhs()->is(Node::Tag::number)) {
+    return be;
+  }
+  const auto* c = static_cast<const Number*>(be->get_rhs());
+  const auto* x = be->get_lhs();
+
+  const auto& v = c->get_val();
+  if (!is_unsigned_const(c) || (Evaluate().get_type(x) != Bits::Type::UNSIGNED)) {
+    return be;
+  }
+  size_t xw = 0;
+  if (!get_self_width(x, &xw)) {
+    return be;
+  }
+  vector<size_t> ones;
+  for (size_t i = 0, ie = v.size(); i < ie; ++i) {
+    if (v.get(i)) {
+      ones.push_back(i);
+    }
+  }
+  if (ones.size() != 1) {
+    return be;
+  }
+
+  const auto w = max(xw, v.size());
+  auto* res = (ones[0] == 0) ? pad(x, w) : new BinaryExpression(pad(x, w), BinaryExpression::Op::GGT, new Number(Bits(32, ones[0])));
+  Evaluate().invalidate(be);
+  return res;
+}
+
+Expression* StrengthReduce::reduce_mod(BinaryExpression* be) {
+  if (!be->get_rhs()->is(Node::Tag::number)) {
+    return be;
+  }
+  const auto* c = static_cast<const Number*>(be->get_rhs());
+  const auto& v = c->get_val();
+  if (!is_unsigned_const(c) || (Evaluate().get_type(be->get_lhs()) != Bits::Type::UNSIGNED)) {
+    return be;
+  }
+  size_t one = 0;
+  size_t count = 0;
+  for (size_t i = 0, ie = v.size(); i < ie; ++i) {
+    if (v.get(i)) {
+      one = i;
+      ++count;
+    }
+  }
+  if (count != 1) {
+    return be;
+  }
+
+  // The mask has the same width as the constant, so the width of the
+  // expression doesn't change.
+  Bits mask(v.size(), 0);
+  for (size_t i = 0; i < one; ++i) {
+    mask.set(i, true);
+  }
+  auto* res = new BinaryExpression(be->get_lhs()->clone(), BinaryExpression::Op::AMP, new Number(mask, Number::Format::HEX));
+  Evaluate().invalidate(be);
+  return res;
+}
+
+Expression* StrengthReduce::rewrite(BinaryExpression* be) {
+  Rewriter::rewrite(be);
+  switch (be->get_op()) {
+    case BinaryExpression::Op::TIMES:
+      return reduce_times(be);
+    case BinaryExpression::Op::DIV:
+      return reduce_div(be);
+    case BinaryExpression::Op::MOD:
+      return reduce_mod(be);
+    default:
+      return be;
+  }
+}
+
+ModuleItem* StrengthReduce::rewrite(ContinuousAssign* ca) {
+  Rewriter::rewrite(ca);
+  narrow_assign(ca);
+  return ca;
+}
+
+ModuleItem* StrengthReduce::rewrite(GenvarDeclaration* gd) {
+  // Does nothing. Declarations are evaluated once, there's nothing to gain.
+  return gd;
+}
+
+ModuleItem* StrengthReduce::rewrite(LocalparamDeclaration* ld) {
+  return ld;
+}
+
+ModuleItem* StrengthReduce::rewrite(NetDeclaration* nd) {
+  return nd;
+}
+
+ModuleItem* StrengthReduce::rewrite(ParameterDeclaration* pd) {
+  return pd;
+}
+
+ModuleItem* StrengthReduce::rewrite(RegDeclaration* rd) {
+  return rd;
+}
+
+Statement* StrengthReduce::rewrite(BlockingAssign* ba) {
+  Rewriter::rewrite(ba);
+  narrow_assign(ba);
+  return ba;
+}
+
+Statement* StrengthReduce::rewrite(NonblockingAssign* na) {
+  Rewriter::rewrite(na);
+  narrow_assign(na);
+  return na;
+}
+
+} // namespace cascade
@@ -0,0 +1,114 @@
+// Copyright 2017-2019 VMware, Inc.
+// SPDX-License-Identifier: BSD-2-Clause
+//
+// The BSD-2 license (the License) set forth below applies to all parts of the
+// Cascade project.  You may not use this file except in compliance with the
+// License.
+//
+// BSD-2 License
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this
+// list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+// this list of conditions and the following disclaimer in the documentation
+// and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS AS IS AND
+// ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef CASCADE_SRC_VERILOG_TRANSFORM_STRENGTH_REDUCE_H
+#define CASCADE_SRC_VERILOG_TRANSFORM_STRENGTH_REDUCE_H
+
+#include "verilog/analyze/evaluate.h"
+#include "verilog/ast/ast.h"
+#include "verilog/ast/visitors/rewriter.h"
+
+namespace cascade {
+
+// This pass does two things. First, it replaces unsigned multiplication,
+// division, and modulus by constants with shifts, masks, and short add chains.
+// Second, it narrows the right-hand sides of assignments to the width of
+// their targets. The low n bits of a sum, difference, product, or bitwise
+// operation depend only on the low n bits of its operands, so whenever an
+// assignment discards the upper bits of its rhs, those bits are never computed
+// in the first place.
+
+class StrengthReduce : public Rewriter {
+  public:
+    StrengthReduce();
+    ~StrengthReduce() override = default;
+
+    void run(ModuleDeclaration* md);
+
+  private:
+    // Returns true and sets w to the self-determined width of e if e is a
+    // number or an identifier. Returns false otherwise.
+    bool get_self_width(const Expression* e, size_t* w) const;
+    // Returns true if n is an integer whose value is the same regardless of
+    // whether it's treated as signed or unsigned.
+    bool is_unsigned_const(const Number* n) const;
+    // Returns a copy of e, zero-extended to width w if its self-determined
+    // width is smaller. This method is undefined if get_self_width(e)
+    // returns false.
+    Expression* pad(const Expression* e, size_t w) const;
+    // Returns e, narrowed so that its self-determined width is no greater than
+    // w, or e itself if that's not possible.
+    Expression* narrow(Expression* e, size_t w);
+    // Narrows the rhs of an assignment to the width of its lhs
+    template <typename T>
+    void narrow_assign(T* t);
+
+    // Strength reduction for x*c, x/c, and x%c
+    Expression* reduce_times(BinaryExpression* be);
+    Expression* reduce_div(BinaryExpression* be);
+    Expression* reduce_mod(BinaryExpression* be);
+
+    // Rewriter Interface
+    Expression* rewrite(BinaryExpression* be) override;
+    ModuleItem* rewrite(ContinuousAssign* ca) override;
+    ModuleItem* rewrite(GenvarDeclaration* gd) override;
+    ModuleItem* rewrite(LocalparamDeclaration* ld) override;
+    ModuleItem* rewrite(NetDeclaration* nd) override;
+    ModuleItem* rewrite(ParameterDeclaration* pd) override;
+    ModuleItem* rewrite(RegDeclaration* rd) override;
+    Statement* rewrite(BlockingAssign* ba) override;
+    Statement* rewrite(NonblockingAssign* na) override;
+};
+
+template <typename T>
+inline void StrengthReduce::narrow_assign(T* t) {
+  if (t->size_lhs() != 1) {
+    return;
+  }
+  // Slicing an operand changes its type to unsigned. That's only safe if the
+  // rhs was going to be evaluated as an unsigned value to begin with.
+  const auto* lhs = t->front_lhs();
+  if ((Evaluate().get_type(lhs) == Bits::Type::REAL) || (Evaluate().get_type(t->get_rhs()) != Bits::Type::UNSIGNED)) {
+    return;
+  }
+  const auto w = Evaluate().get_width(lhs);
+  if (Evaluate().get_width(t->get_rhs()) <= w) {
+    return;
+  }
+  auto* res = narrow(t->get_rhs(), w);
+  if (res != t->get_rhs()) {
+    t->replace_rhs(res);
+  }
+  Evaluate().invalidate(t->get_rhs());
+}
+
+} // namespace cascade
+
+#endif
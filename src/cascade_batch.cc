@@ -0,0 +1,157 @@
+// Copyright 2017-2019 VMware, Inc.
+// SPDX-License-Identifier: BSD-2-Clause
+//
+// The BSD-2 license (the License) set forth below applies to all parts of the
+// Cascade project.  You may not use this file except in compliance with the
+// License.
+//
+// BSD-2 License
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this
+// list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+// this list of conditions and the following disclaimer in the documentation
+// and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS AS IS AND
+// ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "include/cascade_batch.h"
+
+#include <cassert>
+#include <thread>
+#include "include/cascade.h"
+
+using namespace std;
+
+namespace cascade {
+
+CascadeBatch::CascadeBatch() {
+  march_ = "sw";
+  include_dirs_ = "";
+  enable_inlining_ = true;
+  open_loop_target_ = 1;
+  num_threads_ = std::max(1u, thread::hardware_concurrency());
+  is_running_ = false;
+}
+
+CascadeBatch::~CascadeBatch() {
+  wait_for_stop();
+}
+
+CascadeBatch& CascadeBatch::set_march(const string& march) {
+  assert(!is_running_);
+  march_ = march;
+  return *this;
+}
+
+CascadeBatch& CascadeBatch::set_include_dirs(const string& path) {
+  assert(!is_running_);
+  include_dirs_ = path;
+  return *this;
+}
+
+CascadeBatch& CascadeBatch::set_enable_inlining(bool enable) {
+  assert(!is_running_);
+  enable_inlining_ = enable;
+  return *this;
+}
+
+CascadeBatch& CascadeBatch::set_open_loop_target(size_t n) {
+  assert(!is_running_);
+  open_loop_target_ = n;
+  return *this;
+}
+
+CascadeBatch& CascadeBatch::set_num_threads(size_t n) {
+  assert(!is_running_);
+  num_threads_ = (n > 0) ? n : 1;
+  return *this;
+}
+
+CascadeBatch::Lane CascadeBatch::add_lane(const string& fopen_dirs, streambuf* out, streambuf* err) {
+  assert(!is_running_);
+  lanes_.push_back({fopen_dirs, out, err, false, false});
+  return lanes_.size() - 1;
+}
+
+size_t CascadeBatch::size() const {
+  return lanes_.size();
+}
+
+CascadeBatch& CascadeBatch::run(const string& path) {
+  // Ignore multiple calls to run()
+  if (is_running_) {
+    return *this;
+  }
+  is_running_ = true;
+
+  // There's no point in starting more threads than there are lanes
+  pool_.set_num_threads(std::min(num_threads_, std::max(lanes_.size(), static_cast<size_t>(1))));
+  pool_.run();
+  for (auto& l : lanes_) {
+    auto* ls = &l;
+    pool_.insert([this, ls, path]{run_lane(ls, path);});
+  }
+  return *this;
+}
+
+CascadeBatch& CascadeBatch::wait_for_stop() {
+  // Multiple calls to wait_for_stop are harmless. The pool drains any jobs
+  // that are still queued before its threads exit.
+  pool_.stop_now();
+  is_running_ = false;
+  return *this;
+}
+
+bool CascadeBatch::is_finished(Lane l) const {
+  assert(l < lanes_.size());
+  return lanes_[l].finished;
+}
+
+bool CascadeBatch::is_bad(Lane l) const {
+  assert(l < lanes_.size());
+  return lanes_[l].bad;
+}
+
+void CascadeBatch::run_lane(LaneState* ls, const string& path) {
+  Cascade c;
+  c.set_fopen_dirs(ls->fopen_dirs);
+  c.set_include_dirs(include_dirs_);
+  c.set_enable_inlining(enable_inlining_);
+  c.set_open_loop_target(open_loop_target_);
+  c.set_stdout(ls->out);
+  if (ls->err != nullptr) {
+    c.set_stderr(ls->err);
+  }
+
+  // Load the program. Lanes which fail to compile are marked bad and masked
+  // off immediately.
+  c.run();
+  c << "`include \"share/cascade/march/" << march_ << ".v\"\n"
+    << "`include \"" << path << "\"" << endl;
+  c.stop_now();
+  if (c.bad()) {
+    ls->bad = true;
+    return;
+  }
+
+  // Run to completion 
+  c.run();
+  c.wait_for_stop();
+  ls->finished = c.is_finished();
+}
+
+} // namespace cascade
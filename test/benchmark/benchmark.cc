@@ -28,9 +28,22 @@
 // OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
 // OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <mutex>
+#include <streambuf>
 #include <string>
+#include <thread>
+#include <vector>
 #include "benchmark/benchmark.h"
 #include "cl/cl.h"
+#include "include/cascade.h"
+#include "include/cascade_slave.h"
+#include "common/sockserver.h"
+#include "common/sockstream.h"
+#include "target/core/common/syncbuf.h"
 #include "gtest/gtest.h"
 #include "test/harness.h"
 
@@ -59,6 +72,13 @@ static void BM_Bitcoin(benchmark::State& state) {
 }
 BENCHMARK(BM_Bitcoin)->Unit(benchmark::kMillisecond);
 
+static void BM_Memory(benchmark::State& state) {
+  for(auto _ : state) {
+    run_benchmark("share/cascade/test/benchmark/memory/run_20.v", "4294443008\n");
+  }
+}
+BENCHMARK(BM_Memory)->Unit(benchmark::kMillisecond);
+
 static void BM_Mips32(benchmark::State& state) {
   for(auto _ : state) {
     run_benchmark("share/cascade/test/benchmark/mips32/run_bubble_128_1024.v", "1");
@@ -66,6 +86,13 @@ static void BM_Mips32(benchmark::State& state) {
 }
 BENCHMARK(BM_Mips32)->Unit(benchmark::kMillisecond);
 
+static void BM_Mips32x4(benchmark::State& state) {
+  for(auto _ : state) {
+    run_benchmark("share/cascade/test/benchmark/mips32/run_bubble_128_1024_x4.v", "1", state.range(0));
+  }
+}
+BENCHMARK(BM_Mips32x4)->RangeMultiplier(2)->Range(1, 4)->Unit(benchmark::kMillisecond)->UseRealTime();
+
 static void BM_Regex(benchmark::State& state) {
   for(auto _ : state) {
     run_benchmark("share/cascade/test/benchmark/regex/run_disjunct_64.v", "27136");
@@ -79,3 +106,255 @@ static void BM_Nw(benchmark::State& state) {
   }
 }
 BENCHMARK(BM_Nw)->Unit(benchmark::kMillisecond);
+
+static void BM_Adpcm(benchmark::State& state) {
+  for(auto _ : state) {
+    run_benchmark("share/cascade/test/benchmark/adpcm/adpcm.v", "0\n");
+  }
+}
+BENCHMARK(BM_Adpcm)->Unit(benchmark::kMillisecond);
+
+// Records the number of writes it receives and the longest interval between
+// any two of them.
+class stallbuf : public streambuf {
+  public:
+    size_t ticks() {
+      lock_guard<mutex> lg(lock_);
+      return ticks_;
+    }
+    double max_stall() {
+      lock_guard<mutex> lg(lock_);
+      return max_stall_;
+    }
+    void reset() {
+      lock_guard<mutex> lg(lock_);
+      last_ = chrono::steady_clock::now();
+      max_stall_ = 0;
+    }
+
+  private:
+    mutex lock_;
+    size_t ticks_ = 0;
+    chrono::steady_clock::time_point last_;
+    double max_stall_ = 0;
+
+    void tick() {
+      lock_guard<mutex> lg(lock_);
+      const auto now = chrono::steady_clock::now();
+      max_stall_ = max(max_stall_, chrono::duration<double, milli>(now - last_).count());
+      last_ = now;
+      ++ticks_;
+    }
+    int_type overflow(int_type c) override {
+      tick();
+      return c;
+    }
+    streamsize xsputn(const char* s, streamsize n) override {
+      (void) s;
+      tick();
+      return n;
+    }
+};
+
+static void BM_EvalStall(benchmark::State& state) {
+  // A design which writes to stdout every 256 cycles, and a large module
+  // declaration to load while it runs
+  const auto ticker = 
+    "reg[31:0] cnt = 0;\n"
+    "always @(posedge clock.val) begin\n"
+    "  cnt <= cnt + 1;\n"
+    "  if (cnt[7:0] == 0) $write(\".\");\n"
+    "end\n";
+  const auto path = "/tmp/cascade_stall_" + to_string(state.range(0)) + ".v";
+  ofstream ofs(path);
+  ofs << "module Stall(input wire clk);\n";
+  for (auto i = 0; i < state.range(0); ++i) {
+    ofs << "  reg[31:0] r" << i << " = 0;\n";
+    ofs << "  always @(posedge clk) r" << i << " <= r" << i << " + " << i << ";\n";
+  }
+  ofs << "endmodule\n";
+  ofs.close();
+
+  double stall = 0;
+  for (auto _ : state) {
+    stallbuf sb;
+    Cascade c;
+    c.set_stdout(&sb);
+    c.set_stderr(cout.rdbuf());
+    c.run();
+
+    c << "`include \"share/cascade/march/regression/minimal.v\"\n" << ticker << endl;
+    while (sb.ticks() < 16) {
+      this_thread::sleep_for(chrono::milliseconds(1));
+    }
+    sb.reset();
+    // The eval loop sets eofbit whenever it drains its input and won't read
+    // any further until it's cleared.
+    c.clear();
+    c << "`include \"" << path << "\"\ninitial $finish;" << endl;
+    while (!c.is_finished()) {
+      this_thread::sleep_for(chrono::milliseconds(1));
+      c.clear();
+    }
+    c.wait_for_stop();
+    stall += sb.max_stall();
+  }
+  // The longest time that simulation went without producing output while
+  // declarations were being loaded
+  state.counters["stall_ms"] = benchmark::Counter(stall, benchmark::Counter::kAvgIterations);
+  remove(path.c_str());
+}
+BENCHMARK(BM_EvalStall)->RangeMultiplier(4)->Range(256, 16384)->Unit(benchmark::kMillisecond)->UseRealTime();
+
+// Counts the number of bytes written to it and discards them.
+class countbuf : public streambuf {
+  public:
+    size_t bytes() const {
+      return bytes_;
+    }
+
+  private:
+    size_t bytes_ = 0;
+
+    int_type overflow(int_type c) override {
+      ++bytes_;
+      return c;
+    }
+    streamsize xsputn(const char* s, streamsize n) override {
+      (void) s;
+      bytes_ += n;
+      return n;
+    }
+};
+
+static void BM_Display(benchmark::State& state) {
+  // A design which prints a mix of literal text and formatted values on every
+  // cycle
+  const auto n = to_string(state.range(0));
+  const auto display = 
+    "reg[31:0] cnt = 0;\n"
+    "always @(posedge clock.val) begin\n"
+    "  cnt <= cnt + 1;\n"
+    "  $display(\"cnt = %d (%h) lsbs = %b\", cnt, cnt, cnt[7:0]);\n"
+    "  if (cnt == " + n + ") $finish;\n"
+    "end\n";
+
+  size_t bytes = 0;
+  for (auto _ : state) {
+    countbuf cb;
+    Cascade c;
+    c.set_stdout(&cb);
+    c.set_stderr(cout.rdbuf());
+    c.run();
+    c << "`include \"share/cascade/march/regression/minimal.v\"\n" << display << endl;
+    c.stop_now();
+    c.run();
+    c.wait_for_stop();
+    bytes = cb.bytes();
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+  state.SetBytesProcessed(state.iterations() * bytes);
+}
+BENCHMARK(BM_Display)->RangeMultiplier(8)->Range(1 << 10, 1 << 16)->Unit(benchmark::kMillisecond)->UseRealTime();
+
+// Echoes whatever is sent over a loopback TCP connection back to the sender,
+// n bytes at a time, until the sender closes the connection.
+static void echo(sockserver* server, size_t n) {
+  auto* sock = server->accept();
+  vector<char> buf(n);
+  while (sock->read(buf.data(), n)) {
+    sock->write(buf.data(), n);
+    sock->flush();
+  }
+  delete sock;
+}
+
+static void BM_SockstreamLatency(benchmark::State& state) {
+  sockserver server(8810, 1);
+  thread t(echo, &server, 4);
+  auto* sock = new sockstream("127.0.0.1", 8810);
+
+  uint32_t val = 0;
+  for(auto _ : state) {
+    sock->write(reinterpret_cast<const char*>(&val), 4);
+    sock->flush();
+    sock->read(reinterpret_cast<char*>(&val), 4);
+  }
+
+  delete sock;
+  t.join();
+}
+BENCHMARK(BM_SockstreamLatency)->Unit(benchmark::kMicrosecond);
+
+static void BM_SockstreamThroughput(benchmark::State& state) {
+  const auto n = state.range(0);
+  sockserver server(8811, 1);
+  thread t(echo, &server, n);
+  auto* sock = new sockstream("127.0.0.1", 8811);
+
+  vector<char> buf(n);
+  for(auto _ : state) {
+    sock->write(buf.data(), n);
+    sock->flush();
+    sock->read(buf.data(), n);
+  }
+  state.SetBytesProcessed(2 * n * state.iterations());
+
+  delete sock;
+  t.join();
+}
+BENCHMARK(BM_SockstreamThroughput)->Range(64, 1 << 20)->Unit(benchmark::kMicrosecond);
+
+static void BM_RemoteStress(benchmark::State& state) {
+  CascadeSlave slave;
+  slave.set_listeners("/tmp/fpga_socket", 8800);
+  slave.run();
+
+  for(auto _ : state) {
+    vector<thread> ts;
+    for (auto i = 0; i < state.range(0); ++i) {
+      ts.push_back(thread(run_code, "regression/remote_tcp", "share/cascade/test/benchmark/regex/run_disjunct_1.v", "424", false));
+    }
+    for (auto& t : ts) {
+      t.join();
+    }
+  }
+
+  slave.stop_now();
+}
+BENCHMARK(BM_RemoteStress)->RangeMultiplier(4)->Range(1, 64)->Unit(benchmark::kMillisecond)->UseRealTime();
+
+static void BM_SyncbufLatency(benchmark::State& state) {
+  // Mimics an AmorphOS variable read: a three byte request answered by an
+  // eight byte response.
+  syncbuf reqs;
+  syncbuf resps;
+  thread t([&reqs, &resps]{
+    char buf[8] = {0};
+    while (true) {
+      reqs.waitforn(buf, 3);
+      if (buf[0] != 0) {
+        break;
+      }
+      resps.sputn(buf, 8);
+    }
+  });
+
+  char buf[8] = {0};
+  for(auto _ : state) {
+    reqs.sputn(buf, 3);
+    resps.waitforn(buf, 8);
+  }
+
+  buf[0] = 1;
+  reqs.sputn(buf, 3);
+  t.join();
+}
+BENCHMARK(BM_SyncbufLatency)->Unit(benchmark::kMicrosecond);
+
+static void BM_Amorphos(benchmark::State& state) {
+  for(auto _ : state) {
+    run_code("regression/amorphos", "share/cascade/test/benchmark/regex/run_disjunct_1.v", "424", false);
+  }
+}
+BENCHMARK(BM_Amorphos)->Unit(benchmark::kMillisecond);
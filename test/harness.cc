@@ -34,6 +34,7 @@
 #include "common/system.h"
 #include "gtest/gtest.h"
 #include "include/cascade.h"
+#include "include/cascade_batch.h"
 
 using namespace cascade;
 using namespace cascade::cl;
@@ -109,11 +110,33 @@ void run_concurrent(const string& march, const string& path, const string& expec
   t2.join();
 }
 
-void run_benchmark(const string& path, const string& expected) {
+void run_batch(const string& march, const string& path, size_t lanes, const string& expected) {
+  vector<stringbuf*> sbs;
+
+  CascadeBatch cb;
+  cb.set_march(march);
+  cb.set_num_threads(2);
+  for (size_t i = 0; i < lanes; ++i) {
+    sbs.push_back(new stringbuf());
+    cb.add_lane(System::src_root(), sbs.back(), cout.rdbuf());
+  }
+  cb.run(path);
+  cb.wait_for_stop();
+
+  for (size_t i = 0; i < lanes; ++i) {
+    EXPECT_FALSE(cb.is_bad(i));
+    EXPECT_TRUE(cb.is_finished(i));
+    EXPECT_EQ(sbs[i]->str(), expected);
+    delete sbs[i];
+  }
+}
+
+void run_benchmark(const string& path, const string& expected, size_t partitions) {
   auto* sb = new stringbuf();
 
   Cascade c;
   c.set_fopen_dirs(System::src_root());
+  c.set_num_partitions(partitions);
   c.set_stdout(sb);
   c.set_stderr(cout.rdbuf());
   c.set_quartus_server(::compiler_host.value(), ::compiler_port.value());
@@ -39,7 +39,8 @@ void run_parse(const std::string& path, bool expected);
 void run_typecheck(const std::string& march, const std::string& path, bool expected);
 void run_code(const std::string& march, const std::string& path, const std::string& expected, bool omit_from_coverage = false);
 void run_concurrent(const std::string& march, const std::string& path, const std::string& expected, bool omit_from_coverage = false);
-void run_benchmark(const std::string& path, const std::string& expected);
+void run_batch(const std::string& march, const std::string& path, size_t lanes, const std::string& expected);
+void run_benchmark(const std::string& path, const std::string& expected, size_t partitions = 1);
 
 } // namespace cascade
 
@@ -69,6 +69,13 @@ TEST(one_to_one, regex) {
   run_code("regression/remote", "share/cascade/test/benchmark/regex/run_disjunct_1.v", "424");
 }
 
+TEST(one_to_one_tcp, pipeline_1) {
+  run_code("regression/remote_tcp", "share/cascade/test/regression/simple/pipeline_1.v", "0123456789");
+}
+TEST(one_to_one_tcp, regex) {
+  run_code("regression/remote_tcp", "share/cascade/test/benchmark/regex/run_disjunct_1.v", "424");
+}
+
 TEST(many_to_one, bitcoin) {
   run_concurrent("regression/concurrent", "share/cascade/test/benchmark/bitcoin/run_12.v", "00001314 00001398\n", true);
 }
@@ -63,6 +63,9 @@ TEST(simple, array_3) {
 TEST(simple, array_4) {
   run_code("regression/minimal","share/cascade/test/regression/simple/array_4.v", "2550");
 }
+TEST(simple, array_5) {
+  run_code("regression/minimal","share/cascade/test/regression/simple/array_5.v", "-1 5 2047 0");
+}
 TEST(simple, assign_1) {
   run_code("regression/minimal","share/cascade/test/regression/simple/assign_1.v", "1");
 }
@@ -114,6 +117,9 @@ TEST(simple, case_2) {
 TEST(simple, case_3) {
   run_code("regression/minimal","share/cascade/test/regression/simple/case_3.v", "123");
 }
+TEST(simple, case_4) {
+  run_code("regression/minimal","share/cascade/test/regression/simple/case_4.v", "011d45d acb wide signed unsigned");
+}
 TEST(simple, concat_1) {
   run_code("regression/minimal","share/cascade/test/regression/simple/concat_1.v", "170");
 }
@@ -126,6 +132,9 @@ TEST(simple, concat_3) {
 TEST(simple, cond_1) {
   run_code("regression/minimal","share/cascade/test/regression/simple/cond_1.v", "123");
 }
+TEST(simple, cse_1) {
+  run_code("regression/minimal","share/cascade/test/regression/simple/cse_1.v", "305,52,310,85,100,254");
+}
 TEST(simple, declaration_1) {
   run_code("regression/minimal","share/cascade/test/regression/simple/declaration_1.v", "8");
 }
@@ -183,6 +192,9 @@ TEST(simple, inst_2) {
 TEST(simple, inst_3) {
   run_code("regression/minimal","share/cascade/test/regression/simple/inst_3.v", "1");
 }
+TEST(simple, inst_4) {
+  run_code("regression/minimal","share/cascade/test/regression/simple/inst_4.v", "22322");
+}
 TEST(simple, io_1) {
   run_code("regression/minimal","share/cascade/test/regression/simple/io_1.v", "1234512345");
 }
@@ -195,6 +207,9 @@ TEST(simple, io_3) {
 TEST(simple, io_4) {
   run_code("regression/minimal","share/cascade/test/regression/simple/io_4.v", "32 65535 -1");
 }
+TEST(simple, io_5) {
+  run_code("regression/minimal","share/cascade/test/regression/simple/io_5.v", "ff\n01\n02\n03\n04\n05\nff\n");
+}
 TEST(simple, issue_20a) {
   run_code("regression/minimal","share/cascade/test/regression/simple/issue_20a.v", "");
 }
@@ -285,6 +300,9 @@ TEST(simple, nonblock_2) {
 TEST(simple, nonblock_3) {
   run_code("regression/minimal","share/cascade/test/regression/simple/nonblock_3.v", "0 1 2 4 8 ");
 }
+TEST(simple, partition_1) {
+  run_code("regression/minimal","share/cascade/test/regression/simple/partition_1.v", "48");
+}
 TEST(simple, pipeline_1) {
   run_code("regression/minimal","share/cascade/test/regression/simple/pipeline_1.v", "0123456789");
 }
@@ -345,6 +363,9 @@ TEST(simple, sign_1) {
 TEST(simple, sign_2) {
   run_code("regression/minimal","share/cascade/test/regression/simple/sign_2.v", "0000000000");
 }
+TEST(simple, strength_1) {
+  run_code("regression/minimal","share/cascade/test/regression/simple/strength_1.v", "804 2010 25 9 91 240 1250 253 97 1 1 182 239");
+}
 TEST(simple, string) {
   run_code("regression/minimal","share/cascade/test/regression/simple/string.v", "   Hello world is stored as 00000048656c6c6f20776f726c64\nHello world!!! is stored as 48656c6c6f20776f726c64212121\n");
 }
@@ -39,6 +39,9 @@ TEST(verilator32, array) {
 TEST(verilator32, bitcoin) {
   run_code("regression/verilator32", "share/cascade/test/benchmark/bitcoin/run_13.v", "00002d21 00002da5\n", true);
 }
+TEST(verilator32, memory) {
+  run_code("regression/verilator32", "share/cascade/test/benchmark/memory/run_10.v", "523776\n");
+}
 TEST(verilator32, mips32) {
   run_code("regression/verilator32", "share/cascade/test/benchmark/mips32/run_bubble_128.v", "1", true);
 }
@@ -56,6 +59,9 @@ TEST(verilator64, array) {
 TEST(verilator64, bitcoin) {
   run_code("regression/verilator64", "share/cascade/test/benchmark/bitcoin/run_13.v", "00002d21 00002da5\n", true);
 }
+TEST(verilator64, memory) {
+  run_code("regression/verilator64", "share/cascade/test/benchmark/memory/run_10.v", "523776\n");
+}
 TEST(verilator64, mips32) {
   run_code("regression/verilator64", "share/cascade/test/benchmark/mips32/run_bubble_128.v", "1", true);
 }
@@ -32,8 +32,12 @@
 #include <signal.h>
 #include <fstream>
 #include <sstream>
+#include <string>
+#include <vector>
 #include "include/cascade.h"
+#include "include/cascade_batch.h"
 #include "cl/cl.h"
+#include "common/trace.h"
 
 using namespace cascade;
 using namespace cascade::cl;
@@ -85,19 +89,43 @@ auto& disable_error = FlagArg::create("--disable_error")
   .description("Turn off error messages");
 auto& enable_log = FlagArg::create("--enable_log")
   .description("Prints debugging information to log file");
+auto& trace_path = StrArg<string>::create("--trace")
+  .usage("<path/to/trace.json>")
+  .description("Records compilation, state handoff, and scheduling events and writes them to a file in Chrome trace-event format on exit")
+  .initial("");
+auto& profile_passes = FlagArg::create("--profile_passes")
+  .description("Prints the running time of each IR pass and the number of items and expressions it leaves behind for every module; only effective with --enable_info");
 
 __attribute__((unused)) auto& g4 = Group::create("Optimization Options");
 auto& disable_inlining = FlagArg::create("--disable_inlining")
   .description("Prevents cascade from inlining modules");
+auto& partitions = StrArg<size_t>::create("--partitions")
+  .usage("<n>")
+  .description("Splits inlined user logic into as many as n engines which are evaluated in parallel; 0 uses one per hardware thread")
+  .initial(1);
 auto& open_loop_target = StrArg<size_t>::create("--open_loop_target")
   .usage("<n>")
   .description("Maximum number of seconds to run in open loop for before transferring control back to runtime")
   .initial(1);
+auto& passes = StrArg<string>::create("--passes")
+  .usage("<pass1>,<pass2>,...,<passn>")
+  .description("IR passes to run on each module, in order; optimizations which aren't listed are disabled; the default pipeline is printed on startup with --enable_info")
+  .initial("");
 
 __attribute__((unused)) auto& g5 = Group::create("REPL Options");
 auto& disable_repl = FlagArg::create("--disable_repl")
   .description("Disables the REPL and treats user input as stdin");
 
+__attribute__((unused)) auto& g6 = Group::create("Batch Options");
+auto& batch = StrArg<string>::create("--batch")
+  .usage("<dir1>:<dir2>:...:<dirn>")
+  .description("Runs one copy of the program provided by -e per directory; each copy resolves $fopen() statements against its directory and writes its output to <dir>/cascade.out")
+  .initial("");
+auto& batch_threads = StrArg<size_t>::create("--batch_threads")
+  .usage("<n>")
+  .description("Number of threads to run batch copies on; setting n to zero uses one thread per core")
+  .initial(0);
+
 class inbuf : public streambuf {
   public:
     inbuf(streambuf* sb) : streambuf() { 
@@ -175,12 +203,65 @@ void segv_handler(int sig) {
   exit(1);
 }
 
+int run_batch() {
+  if (::input_path.value() == "") {
+    cerr << "\033[31mBatch mode requires an input file (-e)\033[00m" << endl;
+    return 1;
+  }
+
+  CascadeBatch cb;
+  cb.set_march(::march.value());
+  cb.set_include_dirs(::inc_dirs.value());
+  cb.set_enable_inlining(!::disable_inlining.value());
+  cb.set_open_loop_target(::open_loop_target.value());
+  if (::batch_threads.value() > 0) {
+    cb.set_num_threads(::batch_threads.value());
+  }
+
+  // Create one lane per directory
+  vector<string> dirs;
+  stringstream ss(::batch.value());
+  for (string dir; getline(ss, dir, ':'); ) {
+    if (dir != "") {
+      dirs.push_back(dir);
+    }
+  }
+  vector<filebuf*> outs;
+  for (const auto& dir : dirs) {
+    auto* fb = new filebuf();
+    fb->open(dir + "/cascade.out", ios::out);
+    outs.push_back(fb);
+    cb.add_lane(dir + ":" + ::fopen_dirs.value(), fb, fb);
+  }
+
+  cb.run(::input_path.value());
+  cb.wait_for_stop();
+
+  // Report the status of each lane
+  auto res = 0;
+  for (size_t i = 0, ie = dirs.size(); i < ie; ++i) {
+    if (cb.is_bad(i)) {
+      cout << "\033[31m[" << i << "] " << dirs[i] << ": error\033[00m" << endl;
+      res = 1;
+    } else {
+      cout << "[" << i << "] " << dirs[i] << ": " << (cb.is_finished(i) ? "finished" : "stopped") << endl;
+    }
+    delete outs[i];
+  }
+  return res;
+}
+
 } // namespace
 
 int main(int argc, char** argv) {
   // Parse command line
   Simple::read(argc, argv);
 
+  // Batch mode bypasses the REPL entirely
+  if (::batch.value() != "") {
+    return ::run_batch();
+  }
+
   // Wrap cin in inbuf (re-prints the prompt when the user types \n)
   inbuf ib(cin.rdbuf());
   cin.rdbuf(&ib);
@@ -204,10 +285,15 @@ int main(int argc, char** argv) {
   ::cascade_->set_fopen_dirs(::fopen_dirs.value());
   ::cascade_->set_include_dirs(::inc_dirs.value());
   ::cascade_->set_enable_inlining(!::disable_inlining.value());
+  ::cascade_->set_num_partitions(::partitions.value());
   ::cascade_->set_open_loop_target(::open_loop_target.value());
   ::cascade_->set_quartus_server(::compiler_host.value(), ::compiler_port.value());
   ::cascade_->set_vivado_server(::compiler_host.value(), ::compiler_port.value(), ::compiler_fpga.value());
   ::cascade_->set_profile_interval(::profile.value());
+  if (::passes.value() != "") {
+    ::cascade_->set_passes(::passes.value());
+  }
+  ::cascade_->set_enable_pass_report(::profile_passes.value());
 
   // Map standard streams to colored outbufs
   if (::disable_repl.value()) {
@@ -223,11 +309,14 @@ int main(int argc, char** argv) {
   if (::enable_info.value()) {
     ::cascade_->set_stdinfo(new outbuf("\033[37m"));
   }
-  auto* fb = new filebuf();
   if (::enable_log.value()) {
+    auto* fb = new filebuf();
     fb->open("cascade.log", ios::app | ios::out);
+    ::cascade_->set_stdlog(fb);
+  }
+  if (::trace_path.value() != "") {
+    Trace::enable(Trace::ALL);
   }
-  ::cascade_->set_stdlog(fb);
 
   // Print the initial prompt
   cout << ">>> ";
@@ -256,6 +345,12 @@ int main(int argc, char** argv) {
   }
   delete ::cascade_;
 
+  // Write out the event trace now that every thread has been joined
+  if (::trace_path.value() != "") {
+    ofstream ofs(::trace_path.value());
+    Trace::write(ofs);
+  }
+
   cout << "Goodbye!" << endl;
   return 0;
 }